@@ -0,0 +1,62 @@
+#ifndef _ALIGNED_ALLOCATOR_H_
+#define _ALIGNED_ALLOCATOR_H_
+
+#include <cstddef>
+#include <new>
+
+#include "Vector.h"
+
+namespace epl
+{
+    template <typename T, size_t Alignment = cache_line_size>
+    class aligned_allocator {
+        static_assert((Alignment & (Alignment - 1)) == 0, "The alignment must be a power of two");
+
+    public:
+        //
+        // Stateless allocator handing out memory aligned to at least Alignment bytes
+        // (and never less than T itself needs). A Vector using it starts its buffer, and
+        // hence its elements as long as nothing was pushed at the front, on a cache line,
+        // so wide vector loads over the elements never straddle two lines.
+        //
+        typedef T value_type;
+
+        static const size_t alignment = Alignment > alignof(T) ? Alignment : alignof(T);
+
+        template <typename U>
+        struct rebind {
+            typedef aligned_allocator<U, Alignment> other;
+        };
+
+        aligned_allocator(void) = default;
+
+        template <typename U>
+        aligned_allocator(const aligned_allocator<U, Alignment>&) {}
+
+        T* allocate(size_t n) {
+            return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignment)));
+        }
+
+        void deallocate(T* p, size_t n) {
+            ::operator delete(p, n * sizeof(T), std::align_val_t(alignment));
+        }
+
+        template <typename U>
+        bool operator==(const aligned_allocator<U, Alignment>&) const {
+            return true;
+        }
+
+        template <typename U>
+        bool operator!=(const aligned_allocator<U, Alignment>&) const {
+            return false;
+        }
+    };
+
+    //
+    // Vector whose buffer starts on a cache line, e.g. for the epl::simd kernels
+    //
+    template <typename T, typename Checking = default_checking, typename Growth = growth::doubling>
+    using AlignedVector = Vector<T, Checking, aligned_allocator<T>, Growth>;
+}
+
+#endif
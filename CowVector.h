@@ -0,0 +1,500 @@
+#ifndef _COW_VECTOR_H_
+#define _COW_VECTOR_H_
+
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include "Vector.h"
+
+namespace epl
+{
+    template <typename T, typename Checking = default_checking, typename Alloc = std::allocator<T>,
+        typename Growth = growth::doubling>
+    class CowVector : protected Vector<T, Checking, Alloc, Growth> {
+        typedef Vector<T, Checking, Alloc, Growth> base;
+        typedef std::allocator_traits<Alloc> alloc_traits;
+
+        struct share_count {
+            //
+            // Number of CowVectors using the buffer
+            //
+            std::atomic<uint64_t> _owners;
+        };
+
+        typedef typename alloc_traits::template rebind_alloc<share_count> share_allocator;
+        typedef std::allocator_traits<share_allocator> share_traits;
+
+    public:
+        //
+        // A Vector whose copies share the buffer until one of them is modified. Copying
+        // costs one atomic increment instead of allocating and copy constructing every
+        // element; the first mutating call on a copy whose buffer is shared gives it a
+        // buffer of its own (the deep copy), which invalidates that copy's iterators like
+        // a reallocation does. Each copy has its own control block, so iterators are
+        // checked per logical copy exactly as for Vector.
+        //
+        // Mutating calls are the pushes and pops, clear, reserve, resize, append and
+        // prepend, non-const for_each_checked(), and everything handing out mutable
+        // access: non-const operator[], at_unchecked(), data(), begin(), end() and
+        // erase(). Once mutable access has been handed out the buffer may be written
+        // through it at any time, so that vector is never shared again: its copies are
+        // deep. Use the const overloads (or cbegin/cend) to read without unsharing.
+        //
+        // Copies may be made, read and destroyed on different threads; as for Vector,
+        // a single CowVector needs exclusive access while it is mutated.
+        //
+        typedef typename base::allocator_type allocator_type;
+        typedef typename base::checking_policy checking_policy;
+        typedef typename base::iterator iterator;
+        typedef typename base::const_iterator const_iterator;
+
+        using base::size;
+        using base::capacity;
+        using base::get_allocator;
+
+        CowVector(void) : base(), _share(nullptr), _leaked(false) {}
+
+        explicit CowVector(const Alloc& allocator) : base(allocator), _share(nullptr), _leaked(false) {}
+
+        explicit CowVector(uint64_t n, const Alloc& allocator = Alloc()) : base(n, allocator), _share(nullptr), _leaked(false) {}
+
+        CowVector(std::initializer_list<T> init_list, const Alloc& allocator = Alloc()) :
+            base(init_list, allocator), _share(nullptr), _leaked(false) {}
+
+        template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+        CowVector(InputIt first, InputIt last, const Alloc& allocator = Alloc()) :
+            base(first, last, allocator), _share(nullptr), _leaked(false) {}
+
+        CowVector(const CowVector& other) :
+            base(share_or_clone(other, alloc_traits::select_on_container_copy_construction(other._alloc)),
+                copy_capacity(other), other._front - other._buffer, other._length,
+                alloc_traits::select_on_container_copy_construction(other._alloc)),
+            _share(nullptr), _leaked(false) {
+            if (this->_buffer == other._buffer) {
+                _share.store(other._share.load(std::memory_order_acquire), std::memory_order_relaxed);
+            }
+        }
+
+        CowVector(CowVector&& other) : base(std::move(other)), _share(nullptr), _leaked(other._leaked) {
+            _share.store(other._share.exchange(nullptr, std::memory_order_relaxed), std::memory_order_relaxed);
+            other._leaked = false;
+        }
+
+        CowVector& operator=(const CowVector& other) {
+            if (this != &other) {
+                drop(base::CtrlBlk::COPY_ASSIGN);
+                if constexpr (alloc_traits::propagate_on_container_copy_assignment::value) {
+                    this->_alloc = other._alloc;
+                }
+                T* buffer = share_or_clone(other, this->_alloc);
+                if (buffer == other._buffer) {
+                    _share.store(other._share.load(std::memory_order_acquire), std::memory_order_relaxed);
+                }
+                adopt(buffer, copy_capacity(other), other._front - other._buffer, other._length);
+            }
+            return *this;
+        }
+
+        CowVector& operator=(CowVector&& other) {
+            if (this == &other) {
+                return *this;
+            }
+            if (!alloc_traits::propagate_on_container_move_assignment::value && !(this->_alloc == other._alloc)) {
+                //
+                // The buffer of the rhs cannot change hands: copy it (the rhs may share it)
+                //
+                return *this = static_cast<const CowVector&>(other);
+            }
+            drop(base::CtrlBlk::MOVE_ASSIGN);
+            if constexpr (alloc_traits::propagate_on_container_move_assignment::value) {
+                this->_alloc = std::move(other._alloc);
+            }
+            adopt(other._buffer, other._buffer_end - other._buffer, other._front - other._buffer, other._length);
+            _share.store(other._share.exchange(nullptr, std::memory_order_relaxed), std::memory_order_relaxed);
+            _leaked = other._leaked;
+            //
+            // The rhs is left empty, with its iterators invalidated
+            //
+            other._buffer = nullptr;
+            other._length = 0;
+            other.destroy(base::CtrlBlk::MOVE_ASSIGN);
+            other.init_empty();
+            other._leaked = false;
+            return *this;
+        }
+
+        ~CowVector(void) {
+            //
+            // The base class destructor frees the buffer, unless other copies still use it
+            //
+            release_share();
+        }
+
+        bool shared(void) const {
+            //
+            // True if other copies use the same buffer
+            //
+            share_count* share = _share.load(std::memory_order_acquire);
+            return share != nullptr && share->_owners.load(std::memory_order_acquire) > 1;
+        }
+
+        const base& vector(void) const {
+            //
+            // Read only access as a plain Vector, e.g. for epl::simd or epl::parallel
+            //
+            return *this;
+        }
+
+        const T& operator[](uint64_t k) const {
+            return base::operator[](k);
+        }
+
+        T& operator[](uint64_t k) {
+            unshare();
+            _leaked = true;
+            return base::operator[](k);
+        }
+
+        const T* data(void) const {
+            return base::data();
+        }
+
+        T* data(void) {
+            unshare();
+            _leaked = true;
+            return base::data();
+        }
+
+        const T& at_unchecked(uint64_t k) const {
+            return base::at_unchecked(k);
+        }
+
+        T& at_unchecked(uint64_t k) {
+            unshare();
+            _leaked = true;
+            return base::at_unchecked(k);
+        }
+
+        template <typename F>
+        void for_each_checked(F f) const {
+            base::for_each_checked(f);
+        }
+
+        template <typename F>
+        void for_each_checked(F f) {
+            //
+            // The references f gets do not outlive the call, so this unshares but does
+            // not stop later copies from sharing
+            //
+            unshare();
+            base::for_each_checked(f);
+        }
+
+        const_iterator begin(void) const {
+            return base::begin();
+        }
+
+        const_iterator end(void) const {
+            return base::end();
+        }
+
+        const_iterator cbegin(void) const {
+            return base::begin();
+        }
+
+        const_iterator cend(void) const {
+            return base::end();
+        }
+
+        iterator begin(void) {
+            unshare();
+            _leaked = true;
+            return base::begin();
+        }
+
+        iterator end(void) {
+            unshare();
+            _leaked = true;
+            return base::end();
+        }
+
+        template <typename... Args>
+        void emplace_back(Args&&... args) {
+            unshare();
+            base::emplace_back(std::forward<Args>(args)...);
+        }
+
+        void push_back(const T& val) {
+            unshare();
+            base::push_back(val);
+        }
+
+        void push_back(T&& val) {
+            unshare();
+            base::push_back(std::move(val));
+        }
+
+        void push_front(const T& val) {
+            unshare();
+            base::push_front(val);
+        }
+
+        void push_front(T&& val) {
+            unshare();
+            base::push_front(std::move(val));
+        }
+
+        void pop_back(void) {
+            unshare();
+            base::pop_back();
+        }
+
+        void pop_front(void) {
+            unshare();
+            base::pop_front();
+        }
+
+        void pop_back(uint64_t n) {
+            unshare();
+            base::pop_back(n);
+        }
+
+        void pop_front(uint64_t n) {
+            unshare();
+            base::pop_front(n);
+        }
+
+        iterator erase(const_iterator first, const_iterator last) {
+            //
+            // The iterators may point into the shared buffer, so they are turned into
+            // positions before unsharing
+            //
+            const base& self = *this;
+            int64_t at = first - self.begin();
+            int64_t count = last - first;
+            if (at < 0 || count < 0 || (uint64_t)(at + count) > this->_length) {
+                throw std::out_of_range("Erasing a range outside of the container.");
+            }
+            unshare();
+            _leaked = true;
+            const_iterator from = self.begin() + at;
+            return base::erase(from, from + count);
+        }
+
+        void clear(void) {
+            //
+            // A shared buffer is left to the other copies rather than copied only to be
+            // emptied; this copy gets an empty buffer of the same capacity
+            //
+            if (_share.load(std::memory_order_relaxed) == nullptr) {
+                base::clear();
+                return;
+            }
+            uint64_t capacity = this->_buffer_end - this->_buffer;
+            T* old_front = this->_front;
+            T* old_back = this->_back;
+            T* buffer = this->allocate_buffer(capacity);
+            if (!release_share()) {
+                this->deallocate_buffer(buffer, capacity);
+                base::clear();
+                return;
+            }
+            this->_buffer = buffer;
+            this->_buffer_end = buffer + capacity;
+            this->_front = buffer;
+            this->_back = buffer;
+            this->update_ctrlBlk(base::CtrlBlk::invalidate_reason::POP_BACK, old_front, old_back, this->_front, this->_back);
+        }
+
+        void reserve(uint64_t n) {
+            unshare();
+            base::reserve(n);
+        }
+
+        void reserve_front(uint64_t n) {
+            unshare();
+            base::reserve_front(n);
+        }
+
+        void resize(uint64_t n) {
+            unshare();
+            base::resize(n);
+        }
+
+        template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+        void append(InputIt first, InputIt last) {
+            unshare();
+            base::append(first, last);
+        }
+
+        template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+        void prepend(InputIt first, InputIt last) {
+            unshare();
+            base::prepend(first, last);
+        }
+
+    private:
+        //
+        // Created when the buffer is first shared; nullptr while it has a single owner
+        //
+        mutable std::atomic<share_count*> _share;
+        //
+        // Set once mutable access to the elements has been handed out
+        //
+        bool _leaked;
+
+        static T* share_or_clone(const CowVector& other, const Alloc& allocator) {
+            //
+            // The buffer for a copy of 'other': its own buffer, shared, if possible, or
+            // else a deep copy with the same layout
+            //
+            if (!other._leaked && other._buffer != nullptr && allocator == other._alloc) {
+                share_count* share = other.share_block();
+                share->_owners.fetch_add(1, std::memory_order_relaxed);
+                return other._buffer;
+            }
+            Alloc a(allocator);
+            uint64_t capacity = copy_capacity(other);
+            T* buffer = alloc_traits::allocate(a, (size_t)capacity);
+            try {
+                base::construct_range(buffer + (other._front - other._buffer), other._front, other._length);
+            }
+            catch (...) {
+                alloc_traits::deallocate(a, buffer, (size_t)capacity);
+                throw;
+            }
+            return buffer;
+        }
+
+        static uint64_t copy_capacity(const CowVector& other) {
+            //
+            // A moved-from vector has no buffer; its copies get an empty one
+            //
+            return other._buffer != nullptr ? (uint64_t)(other._buffer_end - other._buffer) : base::initial_size;
+        }
+
+        share_count* share_block(void) const {
+            //
+            // The share count of the buffer, created (with this vector as its only owner)
+            // on first use. Copies of one vector may be made on several threads at once.
+            //
+            share_count* share = _share.load(std::memory_order_acquire);
+            if (share != nullptr) {
+                return share;
+            }
+            share_allocator a(this->_alloc);
+            share_count* fresh = share_traits::allocate(a, 1);
+            new (fresh) share_count();
+            fresh->_owners.store(1, std::memory_order_relaxed);
+            if (_share.compare_exchange_strong(share, fresh, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                return fresh;
+            }
+            free_share(fresh);
+            return share;
+        }
+
+        void free_share(share_count* share) const {
+            share_allocator a(this->_alloc);
+            share->~share_count();
+            share_traits::deallocate(a, share, 1);
+        }
+
+        void adopt(T* buffer, uint64_t capacity, uint64_t front, uint64_t length) {
+            //
+            // Takes over a buffer (shared or not) holding 'length' elements at 'front'
+            //
+            this->_buffer = buffer;
+            this->_buffer_end = buffer + capacity;
+            this->_front = buffer + front;
+            this->_back = this->_front + length;
+            this->_length = length;
+            this->_ctrlBlk = this->fresh_ctrlBlk();
+        }
+
+        bool release_share(void) {
+            //
+            // Gives up this vector's claim on a shared buffer. Returns true if other copies
+            // still use it, in which case the vector no longer refers to it at all.
+            //
+            share_count* share = _share.exchange(nullptr, std::memory_order_relaxed);
+            if (share == nullptr) {
+                return false;
+            }
+            if (share->_owners.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                free_share(share);
+                return false;
+            }
+            this->_buffer = nullptr;
+            this->_buffer_end = nullptr;
+            this->_front = nullptr;
+            this->_back = nullptr;
+            this->_length = 0;
+            return true;
+        }
+
+        void drop(typename base::CtrlBlk::invalidate_reason reason) {
+            //
+            // Releases the contents before an assignment: the elements are destroyed
+            // unless other copies still use them, and iterators are invalidated
+            //
+            release_share();
+            this->destroy(reason);
+            _leaked = false;
+        }
+
+        void unshare(void) {
+            //
+            // Gives this vector a buffer of its own before it is mutated
+            //
+            share_count* share = _share.load(std::memory_order_relaxed);
+            if (share == nullptr) {
+                return;
+            }
+            if (share->_owners.load(std::memory_order_acquire) == 1) {
+                //
+                // The other copies are gone: the buffer is ours again
+                //
+                _share.store(nullptr, std::memory_order_relaxed);
+                free_share(share);
+                return;
+            }
+            uint64_t capacity = this->_buffer_end - this->_buffer;
+            uint64_t front = this->_front - this->_buffer;
+            T* old_buffer = this->_buffer;
+            T* old_front = this->_front;
+            T* old_back = this->_back;
+            T* buffer = this->allocate_buffer(capacity);
+            try {
+                base::construct_range(buffer + front, old_front, this->_length);
+            }
+            catch (...) {
+                this->deallocate_buffer(buffer, capacity);
+                throw;
+            }
+            this->_buffer = buffer;
+            this->_buffer_end = buffer + capacity;
+            this->_front = buffer + front;
+            this->_back = this->_front + this->_length;
+            _share.store(nullptr, std::memory_order_relaxed);
+            if (share->_owners.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                //
+                // The other copies let go while we were copying
+                //
+                base::destroy_range(old_front, old_back);
+                this->deallocate_buffer(old_buffer, capacity);
+                free_share(share);
+            }
+            //
+            // Iterators of this copy point into the shared buffer: invalidate them as
+            // for a reallocation
+            //
+            this->update_ctrlBlk(base::CtrlBlk::invalidate_reason::PUSH_BACK, nullptr, nullptr, this->_front, this->_back);
+        }
+    };
+}
+
+#endif
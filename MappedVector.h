@@ -0,0 +1,347 @@
+#ifndef _MAPPED_VECTOR_H_
+#define _MAPPED_VECTOR_H_
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Vector.h"
+
+namespace epl
+{
+    namespace detail
+    {
+        //
+        // Layout of a MappedVector file: this header, padded to one cache line, followed
+        // by 'capacity' cells of T. The live range is cells [front, front + length).
+        //
+        struct mapped_header {
+            uint64_t magic;
+            uint64_t element_size;
+            uint64_t element_align;
+            uint64_t capacity;
+            uint64_t front;
+            uint64_t length;
+            uint64_t checksum;
+            uint64_t reserved;
+        };
+
+        static const uint64_t mapped_magic = 0x31304345564c5045ULL; // "EPLVEC01"
+        static const size_t mapped_header_size = cache_line_size;
+
+        static_assert(sizeof(mapped_header) <= mapped_header_size, "The file header must fit in its slot");
+
+        inline uint64_t mapped_checksum(const mapped_header& header) {
+            //
+            // FNV-1a over every field before the checksum
+            //
+            const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&header);
+            uint64_t hash = 0xcbf29ce484222325ULL;
+            for (size_t k = 0; k < offsetof(mapped_header, checksum); k++) {
+                hash = (hash ^ bytes[k]) * 0x100000001b3ULL;
+            }
+            return hash;
+        }
+
+        template <typename T>
+        class mapped_file {
+        public:
+            //
+            // The file behind a MappedVector and its (single) shared mapping. An existing
+            // file is validated and mapped as is; a new or empty one is sized for
+            // 'initial_capacity' elements.
+            //
+            mapped_file(const std::string& path, uint64_t initial_capacity) : _fd(-1), _base(nullptr), _mapped(0) {
+                _fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+                if (_fd < 0) {
+                    throw std::system_error(errno, std::generic_category(), "Cannot open " + path);
+                }
+                try {
+                    struct stat st;
+                    if (::fstat(_fd, &st) != 0) {
+                        throw std::system_error(errno, std::generic_category(), "Cannot stat " + path);
+                    }
+                    if (st.st_size == 0) {
+                        uint64_t capacity = initial_capacity > 0 ? initial_capacity : 1;
+                        map(capacity);
+                        _front = 0;
+                        _length = 0;
+                        store_layout(capacity, 0, 0);
+                    }
+                    else {
+                        mapped_header header;
+                        if ((uint64_t)st.st_size < mapped_header_size ||
+                            ::pread(_fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header) ||
+                            header.magic != mapped_magic || header.checksum != mapped_checksum(header)) {
+                            throw std::runtime_error(path + " is not a MappedVector file");
+                        }
+                        if (header.element_size != sizeof(T) || header.element_align != alignof(T)) {
+                            throw std::runtime_error(path + " holds elements of a different type");
+                        }
+                        if (header.front + header.length > header.capacity ||
+                            (uint64_t)st.st_size < mapped_header_size + header.capacity * sizeof(T)) {
+                            throw std::runtime_error(path + " is truncated");
+                        }
+                        _mapped = mapped_header_size + header.capacity * sizeof(T);
+                        map_bytes();
+                        _capacity = header.capacity;
+                        _front = header.front;
+                        _length = header.length;
+                    }
+                }
+                catch (...) {
+                    close();
+                    throw;
+                }
+            }
+
+            mapped_file(const mapped_file&) = delete;
+            mapped_file& operator=(const mapped_file&) = delete;
+
+            ~mapped_file() {
+                close();
+            }
+
+            T* buffer(void) const {
+                return reinterpret_cast<T*>(_base + mapped_header_size);
+            }
+
+            uint64_t capacity(void) const {
+                return _capacity;
+            }
+
+            uint64_t front(void) const {
+                return _front;
+            }
+
+            uint64_t length(void) const {
+                return _length;
+            }
+
+            T* map(uint64_t n) {
+                //
+                // Sizes the file for 'n' elements and maps it. Only one buffer can live in
+                // the file at a time.
+                //
+                if (_base != nullptr) {
+                    throw std::bad_alloc();
+                }
+                _mapped = mapped_header_size + n * sizeof(T);
+                if (::ftruncate(_fd, (off_t)_mapped) != 0) {
+                    throw std::system_error(errno, std::generic_category(), "Cannot size the mapped file");
+                }
+                map_bytes();
+                _capacity = n;
+                return buffer();
+            }
+
+            T* grow(uint64_t n) {
+                //
+                // Extends the file to 'n' elements and the mapping with it. The kernel moves
+                // the mapping if it cannot be extended where it is; the contents stay put
+                // in the file either way.
+                //
+                size_t bytes = mapped_header_size + n * sizeof(T);
+                if (::ftruncate(_fd, (off_t)bytes) != 0) {
+                    throw std::system_error(errno, std::generic_category(), "Cannot grow the mapped file");
+                }
+#ifdef __linux__
+                void* p = ::mremap(_base, _mapped, bytes, MREMAP_MAYMOVE);
+                if (p == MAP_FAILED) {
+                    throw std::system_error(errno, std::generic_category(), "Cannot remap the mapped file");
+                }
+                _base = static_cast<char*>(p);
+                _mapped = bytes;
+#else
+                unmap();
+                _mapped = bytes;
+                map_bytes();
+#endif
+                _capacity = n;
+                return buffer();
+            }
+
+            void unmap(void) {
+                if (_base != nullptr) {
+                    ::munmap(_base, _mapped);
+                    _base = nullptr;
+                }
+            }
+
+            void store_layout(uint64_t capacity, uint64_t front, uint64_t length) {
+                //
+                // Records the live range in the file header
+                //
+                mapped_header header;
+                std::memset(&header, 0, sizeof(header));
+                header.magic = mapped_magic;
+                header.element_size = sizeof(T);
+                header.element_align = alignof(T);
+                header.capacity = capacity;
+                header.front = front;
+                header.length = length;
+                header.checksum = mapped_checksum(header);
+                std::memcpy(_base, &header, sizeof(header));
+            }
+
+            void flush(void) {
+                if (::msync(_base, _mapped, MS_SYNC) != 0) {
+                    throw std::system_error(errno, std::generic_category(), "Cannot flush the mapped file");
+                }
+            }
+
+        private:
+            int _fd;
+            char* _base;
+            size_t _mapped;
+            uint64_t _capacity;
+            uint64_t _front;
+            uint64_t _length;
+
+            void map_bytes(void) {
+                void* p = ::mmap(nullptr, _mapped, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+                if (p == MAP_FAILED) {
+                    throw std::system_error(errno, std::generic_category(), "Cannot map the file");
+                }
+                _base = static_cast<char*>(p);
+            }
+
+            void close(void) {
+                unmap();
+                if (_fd >= 0) {
+                    ::close(_fd);
+                    _fd = -1;
+                }
+            }
+        };
+
+        template <typename T>
+        struct mapped_file_holder {
+            //
+            // Base class of MappedVector, so that the file is opened before (and closed
+            // after) the Vector base that uses it
+            //
+            mapped_file_holder(const std::string& path, uint64_t initial_capacity) : _file(path, initial_capacity) {}
+
+            mapped_file<T> _file;
+        };
+    }
+
+    template <typename U, typename T>
+    class mapped_allocator {
+    public:
+        //
+        // Allocator of a MappedVector. The element buffer (U == T) is the file mapping;
+        // it is grown in place through reallocate(), which makes a Vector extend the file
+        // instead of allocating a second buffer. Everything else the vector allocates,
+        // i.e. its control blocks, comes from the heap.
+        //
+        typedef U value_type;
+
+        template <typename V>
+        struct rebind {
+            typedef mapped_allocator<V, T> other;
+        };
+
+        explicit mapped_allocator(detail::mapped_file<T>* file) : _file(file) {}
+
+        template <typename V>
+        mapped_allocator(const mapped_allocator<V, T>& other) : _file(other._file) {}
+
+        U* allocate(size_t n) {
+            if constexpr (std::is_same<U, T>::value) {
+                return _file->map(n);
+            }
+            else {
+                return std::allocator<U>().allocate(n);
+            }
+        }
+
+        void deallocate(U* p, size_t n) {
+            if constexpr (std::is_same<U, T>::value) {
+                _file->unmap();
+            }
+            else {
+                std::allocator<U>().deallocate(p, n);
+            }
+        }
+
+        template <typename V = U, typename = typename std::enable_if<std::is_same<V, T>::value>::type>
+        V* reallocate(V*, size_t, size_t new_n) {
+            return _file->grow(new_n);
+        }
+
+        template <typename V>
+        bool operator==(const mapped_allocator<V, T>& other) const {
+            return _file == other._file;
+        }
+
+        template <typename V>
+        bool operator!=(const mapped_allocator<V, T>& other) const {
+            return _file != other._file;
+        }
+
+        detail::mapped_file<T>* _file;
+    };
+
+    template <typename T, typename Checking = default_checking, typename Growth = growth::doubling>
+    class MappedVector : private detail::mapped_file_holder<T>, public Vector<T, Checking, mapped_allocator<T, T>, Growth> {
+        typedef detail::mapped_file_holder<T> holder;
+        typedef Vector<T, Checking, mapped_allocator<T, T>, Growth> base;
+
+        static_assert(std::is_trivially_copyable<T>::value, "MappedVector elements are stored as raw bytes in a file");
+        static_assert(alignof(T) <= detail::mapped_header_size, "The elements start one cache line into the mapping");
+
+    public:
+        //
+        // A Vector whose buffer is a shared mapping of the file at 'path', so the
+        // elements survive the process. Growth extends the file and remaps it (with
+        // mremap on Linux, which usually needs no copy at all). Opening an existing file
+        // only validates its header - magic, element size and alignment, checksum - and
+        // maps it: the live range is back without constructing or reading a single
+        // element. The header is written by sync() and by the destructor, so after a
+        // crash only the live range is as of the last sync(): the kernel writes dirty
+        // pages back whenever it likes, and the elements in that range hold whatever was
+        // last written to them, before or after the sync, possibly only in part.
+        //
+        explicit MappedVector(const std::string& path, uint64_t initial_capacity = base::initial_size) :
+            holder(path, initial_capacity),
+            base(this->_file.buffer(), this->_file.capacity(), this->_file.front(), this->_file.length(),
+                mapped_allocator<T, T>(&this->_file)) {}
+
+        MappedVector(const MappedVector&) = delete;
+        MappedVector& operator=(const MappedVector&) = delete;
+
+        ~MappedVector() {
+            store_layout();
+        }
+
+        void sync(void) {
+            //
+            // Records the current live range in the header and writes everything to disk
+            //
+            store_layout();
+            this->_file.flush();
+        }
+
+    private:
+        void store_layout(void) {
+            if (this->_buffer != nullptr) {
+                this->_file.store_layout(this->_buffer_end - this->_buffer, this->_front - this->_buffer, this->_length);
+            }
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,260 @@
+#ifndef _MEMORY_RESOURCE_H_
+#define _MEMORY_RESOURCE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "Vector.h"
+
+namespace epl
+{
+    //
+    // Memory resources for epl::Vector. Both are unsynchronized: a resource must only
+    // be used from one thread at a time, which is the common case of a per-request
+    // arena or pool.
+    //
+
+    class arena_resource : public std::pmr::memory_resource {
+    public:
+        //
+        // Monotonic arena. Allocation bumps a pointer inside the current chunk and
+        // deallocation is a no-op; all memory is given back at once by reset() or
+        // by the destructor. Chunks grow geometrically, just like the vectors that
+        // allocate from them.
+        //
+        explicit arena_resource(size_t initial_chunk = 64 * 1024,
+            std::pmr::memory_resource* upstream = std::pmr::new_delete_resource()) :
+            _upstream(upstream), _next_chunk(initial_chunk < 256 ? 256 : initial_chunk),
+            _cur(nullptr), _cur_end(nullptr), _allocated(0) {}
+
+        arena_resource(const arena_resource&) = delete;
+        arena_resource& operator=(const arena_resource&) = delete;
+
+        ~arena_resource() {
+            release();
+        }
+
+        void reset(void) {
+            //
+            // Frees everything handed out so far. The largest chunk is kept around so
+            // that the next request running on this arena does not go back upstream.
+            //
+            if (_chunks.empty()) {
+                return;
+            }
+            size_t largest = 0;
+            for (size_t k = 1; k < _chunks.size(); k++) {
+                if (_chunks[k].size > _chunks[largest].size) {
+                    largest = k;
+                }
+            }
+            chunk keep = _chunks[largest];
+            for (size_t k = 0; k < _chunks.size(); k++) {
+                if (k != largest) {
+                    _upstream->deallocate(_chunks[k].ptr, _chunks[k].size, alignof(std::max_align_t));
+                }
+            }
+            _chunks.clear();
+            _chunks.push_back(keep);
+            _cur = static_cast<char*>(keep.ptr);
+            _cur_end = _cur + keep.size;
+            _allocated = 0;
+        }
+
+        void release(void) {
+            //
+            // Returns every chunk to the upstream resource
+            //
+            for (size_t k = 0; k < _chunks.size(); k++) {
+                _upstream->deallocate(_chunks[k].ptr, _chunks[k].size, alignof(std::max_align_t));
+            }
+            _chunks.clear();
+            _cur = nullptr;
+            _cur_end = nullptr;
+            _allocated = 0;
+        }
+
+        size_t bytes_allocated(void) const {
+            //
+            // Bytes handed out since construction or the last reset()
+            //
+            return _allocated;
+        }
+
+    protected:
+        void* do_allocate(size_t bytes, size_t alignment) override {
+            char* p = align_up(_cur, alignment);
+            if (_cur == nullptr || p + bytes > _cur_end) {
+                new_chunk(bytes + alignment);
+                p = align_up(_cur, alignment);
+            }
+            _cur = p + bytes;
+            _allocated += bytes;
+            return p;
+        }
+
+        void do_deallocate(void*, size_t, size_t) override {
+            //
+            // Monotonic - memory only comes back on reset()
+            //
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+
+    private:
+        struct chunk {
+            void* ptr;
+            size_t size;
+        };
+
+        std::pmr::memory_resource* _upstream;
+        std::vector<chunk> _chunks;
+        size_t _next_chunk;
+        char *_cur, *_cur_end;
+        size_t _allocated;
+
+        static char* align_up(char* p, size_t alignment) {
+            uintptr_t v = reinterpret_cast<uintptr_t>(p);
+            return reinterpret_cast<char*>((v + alignment - 1) & ~(uintptr_t)(alignment - 1));
+        }
+
+        void new_chunk(size_t at_least) {
+            size_t size = _next_chunk;
+            while (size < at_least) {
+                size = size * 2;
+            }
+            void* p = _upstream->allocate(size, alignof(std::max_align_t));
+            _chunks.push_back(chunk{ p, size });
+            _cur = static_cast<char*>(p);
+            _cur_end = _cur + size;
+            _next_chunk = size * 2;
+        }
+    };
+
+    class doubling_pool_resource : public std::pmr::memory_resource {
+    public:
+        //
+        // Size class pool. Every request is rounded up to a power of two and served from
+        // a free list for that size class. A Vector doubles its capacity on growth, so
+        // the buffer it releases while growing is exactly the size class the next
+        // vector of the same size will ask for, and steady-state workloads stop hitting
+        // the upstream resource altogether. Requests above max_block go straight upstream.
+        //
+        static const size_t min_shift = 4;
+        static const size_t num_classes = 28;
+
+        explicit doubling_pool_resource(size_t max_block = (size_t)1 << 24,
+            std::pmr::memory_resource* upstream = std::pmr::new_delete_resource()) :
+            _upstream(upstream), _max_block(max_block) {
+            for (size_t k = 0; k < num_classes; k++) {
+                _free[k] = nullptr;
+            }
+        }
+
+        doubling_pool_resource(const doubling_pool_resource&) = delete;
+        doubling_pool_resource& operator=(const doubling_pool_resource&) = delete;
+
+        ~doubling_pool_resource() {
+            release();
+        }
+
+        void release(void) {
+            //
+            // Returns every block ever obtained from upstream, whether free or not
+            //
+            for (size_t k = 0; k < _blocks.size(); k++) {
+                _upstream->deallocate(_blocks[k].ptr, _blocks[k].size, _blocks[k].alignment);
+            }
+            _blocks.clear();
+            for (size_t k = 0; k < num_classes; k++) {
+                _free[k] = nullptr;
+            }
+        }
+
+    protected:
+        void* do_allocate(size_t bytes, size_t alignment) override {
+            size_t cls = size_class(bytes);
+            if (cls >= num_classes || class_size(cls) > _max_block || alignment > class_align(cls)) {
+                return _upstream->allocate(bytes, alignment);
+            }
+            if (_free[cls] != nullptr) {
+                free_block* blk = _free[cls];
+                _free[cls] = blk->next;
+                return blk;
+            }
+            void* p = _upstream->allocate(class_size(cls), class_align(cls));
+            _blocks.push_back(block{ p, class_size(cls), class_align(cls) });
+            return p;
+        }
+
+        void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+            size_t cls = size_class(bytes);
+            if (cls >= num_classes || class_size(cls) > _max_block || alignment > class_align(cls)) {
+                _upstream->deallocate(p, bytes, alignment);
+                return;
+            }
+            free_block* blk = static_cast<free_block*>(p);
+            blk->next = _free[cls];
+            _free[cls] = blk;
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+
+    private:
+        struct free_block {
+            free_block* next;
+        };
+
+        struct block {
+            void* ptr;
+            size_t size;
+            size_t alignment;
+        };
+
+        std::pmr::memory_resource* _upstream;
+        size_t _max_block;
+        free_block* _free[num_classes];
+        std::vector<block> _blocks;
+
+        static size_t size_class(size_t bytes) {
+            size_t cls = 0;
+            while (class_size(cls) < bytes && cls < num_classes) {
+                cls++;
+            }
+            return cls;
+        }
+
+        static size_t class_size(size_t cls) {
+            return (size_t)1 << (cls + min_shift);
+        }
+
+        static size_t class_align(size_t cls) {
+            //
+            // Blocks are aligned to their own size, capped at a page
+            //
+            size_t size = class_size(cls);
+            return size < 4096 ? size : 4096;
+        }
+    };
+
+    namespace pmr
+    {
+        //
+        // Vector drawing all of its memory (buffer and control blocks) from a
+        // std::pmr::memory_resource, e.g.
+        //
+        //   epl::arena_resource arena;
+        //   epl::pmr::Vector<int> v(&arena);
+        //
+        template <typename T, typename Checking = default_checking>
+        using Vector = epl::Vector<T, Checking, std::pmr::polymorphic_allocator<T>>;
+    }
+}
+
+#endif
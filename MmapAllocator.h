@@ -0,0 +1,166 @@
+#ifndef _MMAP_ALLOCATOR_H_
+#define _MMAP_ALLOCATOR_H_
+
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "Vector.h"
+
+namespace epl
+{
+    namespace detail
+    {
+        inline size_t page_size(void) {
+            static const size_t size = (size_t)::sysconf(_SC_PAGESIZE);
+            return size;
+        }
+
+        inline size_t round_to_pages(size_t bytes) {
+            size_t page = page_size();
+            return (bytes + page - 1) / page * page;
+        }
+    }
+
+    template <typename T, size_t Threshold = (size_t)1 << 21, bool HugePages = false>
+    class mmap_allocator {
+    public:
+        //
+        // Stateless allocator for big buffers that grow. Blocks of at least Threshold
+        // bytes are private anonymous mappings, smaller ones come from malloc (or from the
+        // aligned operator new for over-aligned types, e.g. the concurrent control blocks).
+        // Both kinds can be resized in place through reallocate(): mappings with mremap,
+        // which extends them where the address space allows and otherwise moves the pages
+        // instead of copying them, and malloc blocks with realloc. A Vector of trivially
+        // relocatable elements detects reallocate() and grows through it, so growing a
+        // large buffer no longer copies the elements.
+        //
+        // With HugePages the mappings are advised as transparent huge pages
+        // (MADV_HUGEPAGE), which cuts the TLB misses of scans over large buffers where
+        // the kernel has THP enabled in madvise mode.
+        //
+        typedef T value_type;
+
+        static const size_t threshold = Threshold;
+
+        template <typename U>
+        struct rebind {
+            typedef mmap_allocator<U, Threshold, HugePages> other;
+        };
+
+        mmap_allocator(void) = default;
+
+        template <typename U>
+        mmap_allocator(const mmap_allocator<U, Threshold, HugePages>&) {}
+
+        T* allocate(size_t n) {
+            size_t bytes = n * sizeof(T);
+            if (!mapped(bytes)) {
+                if constexpr (over_aligned) {
+                    return static_cast<T*>(::operator new(bytes, std::align_val_t(alignof(T))));
+                }
+                void* p = std::malloc(bytes > 0 ? bytes : 1);
+                if (p == nullptr) {
+                    throw std::bad_alloc();
+                }
+                return static_cast<T*>(p);
+            }
+            void* p = ::mmap(nullptr, detail::round_to_pages(bytes), PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (p == MAP_FAILED) {
+                throw std::bad_alloc();
+            }
+            advise(p, bytes);
+            return static_cast<T*>(p);
+        }
+
+        void deallocate(T* p, size_t n) {
+            size_t bytes = n * sizeof(T);
+            if (mapped(bytes)) {
+                ::munmap(p, detail::round_to_pages(bytes));
+            }
+            else if constexpr (over_aligned) {
+                ::operator delete(p, bytes, std::align_val_t(alignof(T)));
+            }
+            else {
+                std::free(p);
+            }
+        }
+
+        T* reallocate(T* p, size_t old_n, size_t new_n) {
+            //
+            // Resizes the block 'p' of old_n elements to new_n elements, keeping its
+            // contents. On failure 'p' is left as it was and std::bad_alloc is thrown.
+            //
+            size_t old_bytes = old_n * sizeof(T);
+            size_t new_bytes = new_n * sizeof(T);
+            if (mapped(old_bytes) && mapped(new_bytes)) {
+#ifdef __linux__
+                void* q = ::mremap(p, detail::round_to_pages(old_bytes), detail::round_to_pages(new_bytes), MREMAP_MAYMOVE);
+                if (q == MAP_FAILED) {
+                    throw std::bad_alloc();
+                }
+                advise(q, new_bytes);
+                return static_cast<T*>(q);
+#endif
+            }
+            else if (!over_aligned && !mapped(old_bytes) && !mapped(new_bytes)) {
+                void* q = std::realloc(p, new_bytes > 0 ? new_bytes : 1);
+                if (q == nullptr) {
+                    throw std::bad_alloc();
+                }
+                return static_cast<T*>(q);
+            }
+            //
+            // Crossing the threshold (or no mremap, or no realloc): copy into a new block
+            //
+            T* q = allocate(new_n);
+            std::memcpy(static_cast<void*>(q), static_cast<const void*>(p), old_bytes < new_bytes ? old_bytes : new_bytes);
+            deallocate(p, old_n);
+            return q;
+        }
+
+        template <typename U>
+        bool operator==(const mmap_allocator<U, Threshold, HugePages>&) const {
+            return true;
+        }
+
+        template <typename U>
+        bool operator!=(const mmap_allocator<U, Threshold, HugePages>&) const {
+            return false;
+        }
+
+    private:
+        static const bool over_aligned = alignof(T) > alignof(std::max_align_t);
+
+        static bool mapped(size_t bytes) {
+            return bytes >= Threshold;
+        }
+
+        static void advise(void* p, size_t bytes) {
+#ifdef MADV_HUGEPAGE
+            if constexpr (HugePages) {
+                ::madvise(p, detail::round_to_pages(bytes), MADV_HUGEPAGE);
+            }
+#else
+            (void)p;
+            (void)bytes;
+#endif
+        }
+    };
+
+    //
+    // Vector whose large buffers grow in place (see mmap_allocator)
+    //
+    template <typename T, typename Checking = default_checking, typename Growth = growth::doubling>
+    using MmapVector = Vector<T, Checking, mmap_allocator<T>, Growth>;
+
+    template <typename T, typename Checking = default_checking, typename Growth = growth::doubling>
+    using HugePageVector = Vector<T, Checking, mmap_allocator<T, (size_t)1 << 21, true>, Growth>;
+}
+
+#endif
@@ -0,0 +1,256 @@
+#ifndef _PARALLEL_H_
+#define _PARALLEL_H_
+
+#include <atomic>
+#include <memory>
+#include <optional>
+
+#include "ThreadPool.h"
+#include "Vector.h"
+
+namespace epl
+{
+    namespace parallel
+    {
+        //
+        // Parallel algorithms over epl::Vector. The live range of a vector is one
+        // contiguous run of cells, so each algorithm splits [_front, _back) into chunks
+        // and runs them on a ThreadPool, working on raw pointers inside a chunk. The
+        // checking policy of the vector is honoured once per chunk instead of once per
+        // element: with checking::full or checking::concurrent every chunk first checks
+        // that the vector has not been changed since the algorithm started, and throws
+        // invalid_iterator (like an invalidated iterator would) if it has.
+        //
+        // Element functions run concurrently on several threads and must be safe to do so.
+        // The algorithms take a checked iterator on the calling thread only; running several
+        // of them on the same vector from different threads at once needs checking::concurrent
+        // (or a policy without a control block), as for any other concurrent iteration.
+        //
+
+        //
+        // Chunks are sized so that each thread gets several of them (leaving room for
+        // stealing to even out the load), but never so small that scheduling dominates
+        //
+        static const uint64_t min_grain = 4096;
+        static const uint64_t chunks_per_thread = 4;
+
+        namespace detail
+        {
+            inline uint64_t grain_for(uint64_t n, const ThreadPool& pool) {
+                uint64_t threads = (uint64_t)pool.size() + 1;
+                uint64_t grain = n / (threads * chunks_per_thread);
+                return grain < min_grain ? min_grain : grain;
+            }
+
+            template <typename V, bool = V::checking_policy::tracks_versions>
+            class chunk_guard {
+            public:
+                //
+                // Holds an iterator to the vector for the duration of the algorithm. Any
+                // change to the vector invalidates it, which check() then reports.
+                //
+                explicit chunk_guard(const V& v) : _it(v.begin()) {}
+
+                void check(void) const {
+                    epl::detail::vector_access::validate(_it);
+                }
+
+            private:
+                typename V::const_iterator _it;
+            };
+
+            template <typename V>
+            class chunk_guard<V, false> {
+            public:
+                //
+                // Nothing to check without version tracking
+                //
+                explicit chunk_guard(const V&) {}
+
+                void check(void) const {}
+            };
+        }
+
+        template <typename T, typename C, typename A, typename G, typename F>
+        void for_each(Vector<T, C, A, G>& v, F f, ThreadPool& pool = ThreadPool::instance()) {
+            //
+            // Calls f(element) for every element; f may modify the element
+            //
+            typedef Vector<T, C, A, G> vector_type;
+            detail::chunk_guard<vector_type> guard(v);
+            T* front = epl::detail::vector_access::front(v);
+            uint64_t n = v.size();
+            pool.parallel_for(0, n, detail::grain_for(n, pool), [&](uint64_t lo, uint64_t hi) {
+                guard.check();
+                for (T* p = front + lo; p != front + hi; ++p) {
+                    f(*p);
+                }
+            });
+        }
+
+        template <typename T, typename C, typename A, typename G, typename F>
+        void for_each(const Vector<T, C, A, G>& v, F f, ThreadPool& pool = ThreadPool::instance()) {
+            typedef Vector<T, C, A, G> vector_type;
+            detail::chunk_guard<vector_type> guard(v);
+            const T* front = epl::detail::vector_access::front(v);
+            uint64_t n = v.size();
+            pool.parallel_for(0, n, detail::grain_for(n, pool), [&](uint64_t lo, uint64_t hi) {
+                guard.check();
+                for (const T* p = front + lo; p != front + hi; ++p) {
+                    f(*p);
+                }
+            });
+        }
+
+        template <typename T, typename C, typename A, typename G,
+            typename U, typename C2, typename A2, typename G2, typename F>
+        void transform(const Vector<T, C, A, G>& in, Vector<U, C2, A2, G2>& out, F f,
+            ThreadPool& pool = ThreadPool::instance()) {
+            //
+            // Makes out[k] = f(in[k]) for every element of 'in'. 'out' is first resized to
+            // the size of 'in' (so U has to be default constructible), which invalidates its
+            // iterators. 'in' and 'out' may be the same vector.
+            //
+            typedef Vector<T, C, A, G> in_type;
+            typedef Vector<U, C2, A2, G2> out_type;
+            uint64_t n = in.size();
+            out.resize(n);
+            detail::chunk_guard<in_type> in_guard(in);
+            detail::chunk_guard<out_type> out_guard(out);
+            const T* src = epl::detail::vector_access::front(in);
+            U* dest = epl::detail::vector_access::front(out);
+            pool.parallel_for(0, n, detail::grain_for(n, pool), [&](uint64_t lo, uint64_t hi) {
+                in_guard.check();
+                out_guard.check();
+                for (uint64_t k = lo; k < hi; k++) {
+                    dest[k] = f(src[k]);
+                }
+            });
+        }
+
+        template <typename T, typename C, typename A, typename G, typename R, typename BinaryOp>
+        R reduce(const Vector<T, C, A, G>& v, R init, BinaryOp op, ThreadPool& pool = ThreadPool::instance()) {
+            //
+            // Folds the elements with 'op', starting from 'init'. Every chunk is folded on
+            // its own and the partial results are combined in chunk order, so 'op' has to
+            // be associative but need not be commutative; the grouping (and hence the
+            // rounding of floating point sums) depends on the chunk size.
+            //
+            typedef Vector<T, C, A, G> vector_type;
+            detail::chunk_guard<vector_type> guard(v);
+            const T* front = epl::detail::vector_access::front(v);
+            uint64_t n = v.size();
+            uint64_t grain = detail::grain_for(n, pool);
+            uint64_t chunks = n == 0 ? 0 : (n - 1) / grain + 1;
+            std::unique_ptr<std::optional<R>[]> partials(new std::optional<R>[chunks]);
+            pool.parallel_for(0, n, grain, [&](uint64_t lo, uint64_t hi) {
+                guard.check();
+                R acc(front[lo]);
+                for (uint64_t k = lo + 1; k < hi; k++) {
+                    acc = op(std::move(acc), front[k]);
+                }
+                partials[lo / grain].emplace(std::move(acc));
+            });
+            for (uint64_t c = 0; c < chunks; c++) {
+                init = op(std::move(init), std::move(*partials[c]));
+            }
+            return init;
+        }
+
+        template <typename T, typename C, typename A, typename G>
+        T reduce(const Vector<T, C, A, G>& v, ThreadPool& pool = ThreadPool::instance()) {
+            //
+            // Sum of the elements
+            //
+            return reduce(v, T{}, [](const T& a, const T& b) { return a + b; }, pool);
+        }
+
+        template <typename T, typename C, typename A, typename G, typename Pred>
+        uint64_t count_if(const Vector<T, C, A, G>& v, Pred pred, ThreadPool& pool = ThreadPool::instance()) {
+            //
+            // Number of elements for which pred(element) holds
+            //
+            typedef Vector<T, C, A, G> vector_type;
+            detail::chunk_guard<vector_type> guard(v);
+            const T* front = epl::detail::vector_access::front(v);
+            uint64_t n = v.size();
+            std::atomic<uint64_t> count(0);
+            pool.parallel_for(0, n, detail::grain_for(n, pool), [&](uint64_t lo, uint64_t hi) {
+                guard.check();
+                uint64_t local = 0;
+                for (uint64_t k = lo; k < hi; k++) {
+                    if (pred(front[k])) {
+                        local++;
+                    }
+                }
+                count.fetch_add(local, std::memory_order_relaxed);
+            });
+            return count.load(std::memory_order_relaxed);
+        }
+
+        template <typename T, typename C, typename A, typename G,
+            typename U, typename C2, typename A2, typename G2, typename Pred>
+        uint64_t copy_if(const Vector<T, C, A, G>& in, Vector<U, C2, A2, G2>& out, Pred pred,
+            ThreadPool& pool = ThreadPool::instance()) {
+            //
+            // Appends the elements of 'in' for which pred(element) holds to 'out', in their
+            // original order, and returns how many were appended. Runs in two passes: the
+            // first counts the matches of every chunk, and after 'out' has been grown by the
+            // total (U has to be default constructible) the second copies each chunk's
+            // matches to its own offset. 'pred' is therefore called twice per element and
+            // must give the same answer both times. 'in' and 'out' may be the same vector.
+            //
+            typedef Vector<T, C, A, G> in_type;
+            typedef Vector<U, C2, A2, G2> out_type;
+            uint64_t n = in.size();
+            uint64_t grain = detail::grain_for(n, pool);
+            uint64_t chunks = n == 0 ? 0 : (n - 1) / grain + 1;
+            std::unique_ptr<uint64_t[]> offsets(new uint64_t[chunks + 1]);
+            {
+                detail::chunk_guard<in_type> guard(in);
+                const T* src = epl::detail::vector_access::front(in);
+                pool.parallel_for(0, n, grain, [&](uint64_t lo, uint64_t hi) {
+                    guard.check();
+                    uint64_t local = 0;
+                    for (uint64_t k = lo; k < hi; k++) {
+                        if (pred(src[k])) {
+                            local++;
+                        }
+                    }
+                    offsets[lo / grain + 1] = local;
+                });
+            }
+            //
+            // Turn the per chunk counts into the offsets the chunks write at
+            //
+            uint64_t start = out.size();
+            offsets[0] = start;
+            for (uint64_t c = 1; c <= chunks; c++) {
+                offsets[c] += offsets[c - 1];
+            }
+            uint64_t total = offsets[chunks] - start;
+            if (total == 0) {
+                return 0;
+            }
+            out.resize(start + total);
+            detail::chunk_guard<in_type> in_guard(in);
+            detail::chunk_guard<out_type> out_guard(out);
+            const T* src = epl::detail::vector_access::front(in);
+            U* dest = epl::detail::vector_access::front(out);
+            pool.parallel_for(0, n, grain, [&](uint64_t lo, uint64_t hi) {
+                in_guard.check();
+                out_guard.check();
+                U* at = dest + offsets[lo / grain];
+                for (uint64_t k = lo; k < hi; k++) {
+                    if (pred(src[k])) {
+                        *at = src[k];
+                        ++at;
+                    }
+                }
+            });
+            return total;
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,433 @@
+#ifndef _RING_QUEUE_H_
+#define _RING_QUEUE_H_
+
+#include <atomic>
+#include <utility>
+
+#include "Vector.h"
+
+namespace epl
+{
+    namespace detail
+    {
+        inline uint64_t ring_capacity(uint64_t n) {
+            //
+            // Rounds a requested capacity up to a power of two (at least 2), so that a
+            // cursor can be mapped to a cell with a mask instead of a division
+            //
+            uint64_t capacity = 2;
+            while (capacity < n) {
+                capacity = capacity * 2;
+            }
+            return capacity;
+        }
+    }
+
+    template <typename T, typename Alloc = std::allocator<T>>
+    class RingQueue {
+        typedef std::allocator_traits<Alloc> alloc_traits;
+
+    public:
+        //
+        // Fixed capacity, lock-free queue for exactly one producer thread and one consumer
+        // thread. It is Vector's double-ended raw buffer with the reallocation taken out:
+        // the producer pushes at _back, the consumer pops at _front, and both cursors only
+        // ever grow, wrapping around the buffer modulo its (power of two) capacity.
+        //
+        // Each cursor lives on its own cache line, next to a cached copy of the other
+        // side's cursor. A side only re-reads the other cursor (a cache miss) when its
+        // cached copy says the queue is full or empty, and the batch operations publish
+        // their cursor once per batch rather than once per element.
+        //
+        explicit RingQueue(uint64_t capacity, const Alloc& allocator = Alloc()) :
+            _alloc(allocator), _capacity(detail::ring_capacity(capacity)), _mask(_capacity - 1) {
+            _buffer = alloc_traits::allocate(_alloc, (size_t)_capacity);
+            _front.store(0, std::memory_order_relaxed);
+            _back.store(0, std::memory_order_relaxed);
+            _cached_front = 0;
+            _cached_back = 0;
+        }
+
+        RingQueue(const RingQueue&) = delete;
+        RingQueue& operator=(const RingQueue&) = delete;
+
+        ~RingQueue() {
+            //
+            // Destructs whatever is still queued. Must not race with either side.
+            //
+            uint64_t front = _front.load(std::memory_order_relaxed);
+            uint64_t back = _back.load(std::memory_order_relaxed);
+            if (!std::is_trivially_destructible<T>::value) {
+                for (uint64_t k = front; k != back; k++) {
+                    _buffer[k & _mask].T::~T();
+                }
+            }
+            alloc_traits::deallocate(_alloc, _buffer, (size_t)_capacity);
+        }
+
+        template <typename... Args>
+        bool try_emplace(Args&&... args) {
+            //
+            // Producer side. Constructs an element at the back, or returns false if the
+            // queue is full.
+            //
+            uint64_t back = _back.load(std::memory_order_relaxed);
+            if (back - _cached_front == _capacity) {
+                _cached_front = _front.load(std::memory_order_acquire);
+                if (back - _cached_front == _capacity) {
+                    return false;
+                }
+            }
+            new (_buffer + (back & _mask)) T{ std::forward<Args>(args)... };
+            _back.store(back + 1, std::memory_order_release);
+            return true;
+        }
+
+        bool try_push(const T& val) {
+            return try_emplace(val);
+        }
+
+        bool try_push(T&& val) {
+            return try_emplace(std::move(val));
+        }
+
+        bool try_pop(T& out) {
+            //
+            // Consumer side. Moves the front element into 'out', or returns false if the
+            // queue is empty.
+            //
+            uint64_t front = _front.load(std::memory_order_relaxed);
+            if (front == _cached_back) {
+                _cached_back = _back.load(std::memory_order_acquire);
+                if (front == _cached_back) {
+                    return false;
+                }
+            }
+            T* cell = _buffer + (front & _mask);
+            out = std::move(*cell);
+            cell->T::~T();
+            _front.store(front + 1, std::memory_order_release);
+            return true;
+        }
+
+        template <typename InputIt>
+        uint64_t push_bulk(InputIt first, uint64_t n) {
+            //
+            // Producer side. Copies up to 'n' elements read from 'first' into the queue and
+            // returns how many fit. The consumer sees the whole batch at once. If a copy
+            // throws, the ones already made are destroyed and the queue is as it was.
+            //
+            uint64_t back = _back.load(std::memory_order_relaxed);
+            uint64_t room = _capacity - (back - _cached_front);
+            if (room < n) {
+                _cached_front = _front.load(std::memory_order_acquire);
+                room = _capacity - (back - _cached_front);
+            }
+            uint64_t count = n < room ? n : room;
+            uint64_t k = 0;
+            try {
+                for (; k < count; ++k, ++first) {
+                    new (_buffer + ((back + k) & _mask)) T{ *first };
+                }
+            }
+            catch (...) {
+                while (k > 0) {
+                    k--;
+                    _buffer[(back + k) & _mask].T::~T();
+                }
+                throw;
+            }
+            if (count > 0) {
+                _back.store(back + count, std::memory_order_release);
+            }
+            return count;
+        }
+
+        template <typename OutputIt>
+        uint64_t pop_bulk(OutputIt out, uint64_t n) {
+            //
+            // Consumer side. Moves up to 'n' elements to 'out' and returns how many there
+            // were. The producer gets all of the freed cells back at once. If a move
+            // throws, the elements already moved out are gone from the queue and the one
+            // that failed stays at the front, as with try_pop.
+            //
+            uint64_t front = _front.load(std::memory_order_relaxed);
+            uint64_t available = _cached_back - front;
+            if (available < n) {
+                _cached_back = _back.load(std::memory_order_acquire);
+                available = _cached_back - front;
+            }
+            uint64_t count = n < available ? n : available;
+            uint64_t k = 0;
+            try {
+                for (; k < count; ++k, ++out) {
+                    T* cell = _buffer + ((front + k) & _mask);
+                    *out = std::move(*cell);
+                    cell->T::~T();
+                }
+            }
+            catch (...) {
+                if (k > 0) {
+                    _front.store(front + k, std::memory_order_release);
+                }
+                throw;
+            }
+            if (count > 0) {
+                _front.store(front + count, std::memory_order_release);
+            }
+            return count;
+        }
+
+        uint64_t size(void) const {
+            //
+            // Number of queued elements. Exact only when neither side is running.
+            //
+            uint64_t front = _front.load(std::memory_order_acquire);
+            uint64_t back = _back.load(std::memory_order_acquire);
+            return back - front;
+        }
+
+        bool empty(void) const {
+            return size() == 0;
+        }
+
+        uint64_t capacity(void) const {
+            return _capacity;
+        }
+
+    private:
+        Alloc _alloc;
+        T* _buffer;
+        uint64_t _capacity;
+        uint64_t _mask;
+        //
+        // Consumer cursor, and the consumer's copy of the producer cursor
+        //
+        alignas(cache_line_size) std::atomic<uint64_t> _front;
+        uint64_t _cached_back;
+        //
+        // Producer cursor, and the producer's copy of the consumer cursor
+        //
+        alignas(cache_line_size) std::atomic<uint64_t> _back;
+        uint64_t _cached_front;
+        //
+        // Keeps whatever follows the queue in memory off the producer's line
+        //
+        alignas(cache_line_size) char _pad[1];
+    };
+
+    template <typename T, typename Alloc = std::allocator<T>>
+    class MPMCRingQueue {
+        struct Cell {
+            //
+            // A cell is free for the producer claiming position p when _sequence == p,
+            // and holds an element for the consumer claiming position p when
+            // _sequence == p + 1
+            //
+            std::atomic<uint64_t> _sequence;
+            //
+            // False for a tombstone: a cell whose producer's constructor threw. It is
+            // published like a filled cell (so the position is not lost) and consumers
+            // skip it.
+            //
+            bool _filled;
+            alignas(T) unsigned char _storage[sizeof(T)];
+
+            T* value(void) {
+                return reinterpret_cast<T*>(_storage);
+            }
+        };
+
+        typedef typename std::allocator_traits<Alloc>::template rebind_alloc<Cell> cell_allocator;
+        typedef std::allocator_traits<cell_allocator> cell_traits;
+
+    public:
+        //
+        // Fixed capacity, lock-free queue for any number of producers and consumers
+        // (D. Vyukov's bounded MPMC queue). Producers claim a position at _back and
+        // consumers at _front with a compare-and-swap; the per cell sequence number
+        // tells whether the cell at a claimed position is ready, so producers and
+        // consumers never wait on each other's cursor.
+        //
+        // A claimed position must always be published, or the consumers that reach it
+        // would wait on it forever. If constructing an element throws, the cell is
+        // published as a tombstone that consumers skip, and the exception propagates;
+        // if moving an element out to the consumer throws, the element is dropped and
+        // its cell freed before the exception propagates.
+        //
+        explicit MPMCRingQueue(uint64_t capacity, const Alloc& allocator = Alloc()) :
+            _alloc(allocator), _capacity(detail::ring_capacity(capacity)), _mask(_capacity - 1) {
+            _cells = cell_traits::allocate(_alloc, (size_t)_capacity);
+            for (uint64_t k = 0; k < _capacity; k++) {
+                new (&_cells[k]._sequence) std::atomic<uint64_t>(k);
+            }
+            _front.store(0, std::memory_order_relaxed);
+            _back.store(0, std::memory_order_relaxed);
+        }
+
+        MPMCRingQueue(const MPMCRingQueue&) = delete;
+        MPMCRingQueue& operator=(const MPMCRingQueue&) = delete;
+
+        ~MPMCRingQueue() {
+            //
+            // Destructs whatever is still queued. Must not race with any producer or consumer.
+            //
+            uint64_t front = _front.load(std::memory_order_relaxed);
+            uint64_t back = _back.load(std::memory_order_relaxed);
+            for (uint64_t k = front; k != back; k++) {
+                if (_cells[k & _mask]._filled) {
+                    _cells[k & _mask].value()->T::~T();
+                }
+            }
+            cell_traits::deallocate(_alloc, _cells, (size_t)_capacity);
+        }
+
+        template <typename... Args>
+        bool try_emplace(Args&&... args) {
+            uint64_t pos = _back.load(std::memory_order_relaxed);
+            for (;;) {
+                Cell& cell = _cells[pos & _mask];
+                uint64_t seq = cell._sequence.load(std::memory_order_acquire);
+                int64_t diff = (int64_t)(seq - pos);
+                if (diff == 0) {
+                    if (_back.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        try {
+                            new (cell.value()) T{ std::forward<Args>(args)... };
+                        }
+                        catch (...) {
+                            cell._filled = false;
+                            cell._sequence.store(pos + 1, std::memory_order_release);
+                            throw;
+                        }
+                        cell._filled = true;
+                        cell._sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0) {
+                    //
+                    // The cell still holds the element from one lap ago: full
+                    //
+                    return false;
+                }
+                else {
+                    pos = _back.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        bool try_push(const T& val) {
+            return try_emplace(val);
+        }
+
+        bool try_push(T&& val) {
+            return try_emplace(std::move(val));
+        }
+
+        bool try_pop(T& out) {
+            return pop_into(out);
+        }
+
+        template <typename InputIt>
+        uint64_t push_bulk(InputIt first, uint64_t n) {
+            //
+            // Pushes up to 'n' elements read from 'first', stopping when the queue is full,
+            // and returns how many were pushed. With several producers the elements of one
+            // batch may be interleaved with those of other producers.
+            //
+            uint64_t count = 0;
+            for (; count < n; ++count, ++first) {
+                if (!try_emplace(*first)) {
+                    break;
+                }
+            }
+            return count;
+        }
+
+        template <typename OutputIt>
+        uint64_t pop_bulk(OutputIt out, uint64_t n) {
+            //
+            // Pops up to 'n' elements into 'out', stopping when the queue is empty
+            //
+            uint64_t count = 0;
+            for (; count < n; ++count, ++out) {
+                if (!pop_into(*out)) {
+                    break;
+                }
+            }
+            return count;
+        }
+
+        uint64_t size(void) const {
+            //
+            // Number of claimed but not yet consumed positions. Approximate while
+            // producers or consumers are running.
+            //
+            uint64_t front = _front.load(std::memory_order_acquire);
+            uint64_t back = _back.load(std::memory_order_acquire);
+            return back > front ? back - front : 0;
+        }
+
+        bool empty(void) const {
+            return size() == 0;
+        }
+
+        uint64_t capacity(void) const {
+            return _capacity;
+        }
+
+    private:
+        cell_allocator _alloc;
+        Cell* _cells;
+        uint64_t _capacity;
+        uint64_t _mask;
+        alignas(cache_line_size) std::atomic<uint64_t> _front;
+        alignas(cache_line_size) std::atomic<uint64_t> _back;
+        alignas(cache_line_size) char _pad[1];
+
+        template <typename Out>
+        bool pop_into(Out&& out) {
+            //
+            // Claims the front position and moves its element to 'out', or returns
+            // false if the queue is empty. Tombstones are claimed and skipped.
+            //
+            uint64_t pos = _front.load(std::memory_order_relaxed);
+            for (;;) {
+                Cell& cell = _cells[pos & _mask];
+                uint64_t seq = cell._sequence.load(std::memory_order_acquire);
+                int64_t diff = (int64_t)(seq - (pos + 1));
+                if (diff == 0) {
+                    if (_front.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        if (!cell._filled) {
+                            cell._sequence.store(pos + _capacity, std::memory_order_release);
+                            pos = _front.load(std::memory_order_relaxed);
+                            continue;
+                        }
+                        try {
+                            out = std::move(*cell.value());
+                        }
+                        catch (...) {
+                            cell.value()->T::~T();
+                            cell._sequence.store(pos + _capacity, std::memory_order_release);
+                            throw;
+                        }
+                        cell.value()->T::~T();
+                        cell._sequence.store(pos + _capacity, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (diff < 0) {
+                    //
+                    // No producer has filled this cell yet: empty
+                    //
+                    return false;
+                }
+                else {
+                    pos = _front.load(std::memory_order_relaxed);
+                }
+            }
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,816 @@
+#ifndef _SEGMENTED_VECTOR_H_
+#define _SEGMENTED_VECTOR_H_
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "Vector.h"
+
+namespace epl
+{
+    namespace detail
+    {
+        constexpr uint64_t segment_length(size_t element_size, size_t segment_bytes) {
+            //
+            // Largest power of two number of elements that fits in 'segment_bytes' (at least 1)
+            //
+            uint64_t n = 1;
+            while (n * 2 * element_size <= segment_bytes) {
+                n *= 2;
+            }
+            return n;
+        }
+
+        constexpr unsigned log2_of(uint64_t n) {
+            unsigned k = 0;
+            while (((uint64_t)1 << k) < n) {
+                k++;
+            }
+            return k;
+        }
+    }
+
+    template <typename T, typename Checking = default_checking, typename Alloc = std::allocator<T>,
+        size_t SegmentBytes = 4096>
+    class SegmentedVector {
+        typedef std::allocator_traits<Alloc> alloc_traits;
+        typedef typename alloc_traits::template rebind_alloc<T*> map_allocator;
+        typedef Vector<T*, checking::none, map_allocator> segment_map;
+
+    public:
+        //
+        // A double-ended vector whose elements live in fixed size segments instead of one
+        // buffer, like a deque with a block map. The map is itself an epl::Vector of segment
+        // pointers, with room at both ends.
+        //
+        // Growing at either end adds one segment (or reuses an empty one from the other
+        // end) and never moves an element, so push_back and push_front are O(1) and the
+        // address of an element stays the same until it is popped. Peak memory is the live
+        // data plus at most one partly used segment per end and the map, which holds one
+        // pointer per segment; there is no transient 2x footprint while growing.
+        //
+        // The interface and the invalidation rules are those of Vector: with a checking
+        // policy that tracks versions every push and pop invalidates outstanding iterators
+        // and using one throws invalid_iterator with the same severities - except that
+        // MODERATE is never raised for a push, as no push moves the elements. Iterators
+        // refer to the container, so they must not outlive it (or a move out of it).
+        //
+        typedef Alloc allocator_type;
+        typedef Checking checking_policy;
+
+        static const uint64_t segment_size = detail::segment_length(sizeof(T), SegmentBytes);
+
+        struct CtrlBlk {
+        public:
+            //
+            // Control block shared with the iterators, as in Vector. Element positions are
+            // slots: slot numbers never change while an element is in the container, so
+            // the cells removed by a pop are recorded as a slot range.
+            //
+            typedef typename alloc_traits::template rebind_alloc<CtrlBlk> ctrl_allocator;
+            typedef std::allocator_traits<ctrl_allocator> ctrl_traits;
+
+            typedef enum {
+                PUSH_BACK,
+                POP_BACK,
+                PUSH_FRONT,
+                POP_FRONT,
+                EMPLACE_BACK,
+                COPY_ASSIGN,
+                MOVE_ASSIGN,
+                DESTROY,
+                NONE
+            } invalidate_reason;
+
+            typedef typename std::conditional<Checking::atomic_refs, std::atomic<uint64_t>, uint64_t>::type counter_type;
+
+            counter_type _version;
+            alignas(Checking::atomic_refs ? cache_line_size : alignof(counter_type)) counter_type _refs;
+            invalidate_reason _reason;
+            int64_t _location, _location_end;
+            ctrl_allocator _alloc;
+
+            CtrlBlk(uint64_t version, const ctrl_allocator& alloc) : _alloc(alloc) {
+                this->_version = version;
+                this->_refs = Checking::atomic_refs ? 1 : 0;
+                this->_reason = NONE;
+                this->_location = 0;
+                this->_location_end = 0;
+            }
+
+            static CtrlBlk* create(uint64_t version, const Alloc& alloc) {
+                ctrl_allocator a(alloc);
+                CtrlBlk* blk = ctrl_traits::allocate(a, 1);
+                new (blk) CtrlBlk(version, a);
+                return blk;
+            }
+
+            static void release(CtrlBlk* blk) {
+                ctrl_allocator a(blk->_alloc);
+                blk->~CtrlBlk();
+                ctrl_traits::deallocate(a, blk, 1);
+            }
+
+            uint64_t version() const {
+                if constexpr (Checking::atomic_refs) {
+                    return this->_version.load(std::memory_order_acquire);
+                }
+                else {
+                    return this->_version;
+                }
+            }
+
+            void set_version(uint64_t version) {
+                if constexpr (Checking::atomic_refs) {
+                    this->_version.store(version, std::memory_order_release);
+                }
+                else {
+                    this->_version = version;
+                }
+            }
+
+            void incRef() {
+                if constexpr (Checking::atomic_refs) {
+                    this->_refs.fetch_add(1, std::memory_order_relaxed);
+                }
+                else {
+                    this->_refs++;
+                }
+            }
+
+            bool decRef() {
+                if constexpr (Checking::atomic_refs) {
+                    return this->_refs.fetch_sub(1, std::memory_order_acq_rel) == 1;
+                }
+                else {
+                    this->_refs--;
+                    return this->_version == INT_MIN && this->_refs == 0;
+                }
+            }
+
+            bool shared() const {
+                if constexpr (Checking::atomic_refs) {
+                    return this->_refs.load(std::memory_order_acquire) > 1;
+                }
+                else {
+                    return this->_refs > 0;
+                }
+            }
+
+            static void abandon(CtrlBlk* blk) {
+                if constexpr (Checking::atomic_refs) {
+                    if (blk->_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                        release(blk);
+                    }
+                }
+                else {
+                    if (blk->_refs == 0) {
+                        release(blk);
+                    }
+                }
+            }
+
+            void invalidate(invalidate_reason reason, int64_t location, int64_t location_end) {
+                this->_reason = reason;
+                this->_location = location;
+                this->_location_end = location_end;
+                set_version(INT_MIN);
+            }
+        };
+
+        template <bool Const>
+        struct segment_iterator {
+            //
+            // Iterator over the slots of a SegmentedVector. What it checks depends on the
+            // checking policy, as for Vector: with tracks_versions it holds the control
+            // block and validates on every use, with checks_bounds it range checks
+            // dereferences against the live range it was created with, and otherwise it
+            // checks nothing.
+            //
+            typedef typename std::conditional<Const, const SegmentedVector, SegmentedVector>::type owner_type;
+
+            using value_type = T;
+            using iterator_category = std::random_access_iterator_tag;
+            using reference = typename std::conditional<Const, const T&, T&>::type;
+            using pointer = typename std::conditional<Const, const T*, T*>::type;
+            using difference_type = int64_t;
+
+            segment_iterator(void) : _owner(nullptr), _slot(0), _begin(0), _end(0), _ctrlBlk(nullptr) {}
+
+            segment_iterator(owner_type* owner, int64_t slot, CtrlBlk* ctrlBlk) :
+                _owner(owner), _slot(slot), _begin(owner->_front), _end(owner->_back), _ctrlBlk(ctrlBlk) {
+                if (_ctrlBlk != nullptr) {
+                    _ctrlBlk->incRef();
+                }
+            }
+
+            segment_iterator(const segment_iterator& other) :
+                _owner(other._owner), _slot(other._slot), _begin(other._begin), _end(other._end), _ctrlBlk(other._ctrlBlk) {
+                if (_ctrlBlk != nullptr) {
+                    _ctrlBlk->incRef();
+                }
+            }
+
+            template <bool C = Const, typename = typename std::enable_if<C>::type>
+            segment_iterator(const segment_iterator<false>& other) :
+                _owner(other._owner), _slot(other._slot), _begin(other._begin), _end(other._end), _ctrlBlk(other._ctrlBlk) {
+                if (_ctrlBlk != nullptr) {
+                    _ctrlBlk->incRef();
+                }
+            }
+
+            segment_iterator& operator=(const segment_iterator& rhs) {
+                if (this != &rhs) {
+                    release();
+                    _owner = rhs._owner;
+                    _slot = rhs._slot;
+                    _begin = rhs._begin;
+                    _end = rhs._end;
+                    _ctrlBlk = rhs._ctrlBlk;
+                    if (_ctrlBlk != nullptr) {
+                        _ctrlBlk->incRef();
+                    }
+                }
+                return *this;
+            }
+
+            ~segment_iterator() {
+                release();
+            }
+
+            reference operator*(void) const {
+                validate_deref();
+                return *_owner->slot(_slot);
+            }
+
+            pointer operator->(void) const {
+                validate_deref();
+                return _owner->slot(_slot);
+            }
+
+            reference operator[](int64_t offset) const {
+                return *(*this + offset);
+            }
+
+            bool operator==(const segment_iterator& rhs) const {
+                validate_base();
+                return _slot == rhs._slot;
+            }
+
+            bool operator!=(const segment_iterator& rhs) const {
+                return !(*this == rhs);
+            }
+
+            bool operator<(const segment_iterator& rhs) const {
+                validate_base();
+                return _slot < rhs._slot;
+            }
+
+            bool operator>(const segment_iterator& rhs) const {
+                return rhs < *this;
+            }
+
+            bool operator<=(const segment_iterator& rhs) const {
+                return !(rhs < *this);
+            }
+
+            bool operator>=(const segment_iterator& rhs) const {
+                return !(*this < rhs);
+            }
+
+            int64_t operator-(const segment_iterator& rhs) const {
+                validate_base();
+                return _slot - rhs._slot;
+            }
+
+            segment_iterator operator+(int64_t offset) const {
+                validate_base();
+                segment_iterator t{ *this };
+                t._slot += offset;
+                return t;
+            }
+
+            segment_iterator operator-(int64_t offset) const {
+                return *this + -offset;
+            }
+
+            friend segment_iterator operator+(int64_t offset, const segment_iterator& it) {
+                return it + offset;
+            }
+
+            segment_iterator& operator+=(int64_t offset) {
+                validate_base();
+                _slot += offset;
+                return *this;
+            }
+
+            segment_iterator& operator-=(int64_t offset) {
+                return *this += -offset;
+            }
+
+            segment_iterator& operator++(void) {
+                validate_base();
+                _slot++;
+                return *this;
+            }
+
+            segment_iterator& operator--(void) {
+                validate_base();
+                _slot--;
+                return *this;
+            }
+
+            segment_iterator operator++(int) {
+                segment_iterator old{ *this };
+                ++*this;
+                return old;
+            }
+
+            segment_iterator operator--(int) {
+                segment_iterator old{ *this };
+                --*this;
+                return old;
+            }
+
+            owner_type* _owner;
+            int64_t _slot, _begin, _end;
+            CtrlBlk* _ctrlBlk;
+
+        private:
+            void validate_base(void) const {
+                //
+                // Same diagnosis as Vector's checked iterators. The elements never move, so
+                // a push only shifts indices (WARNING at the front, MILD at the back).
+                //
+                if constexpr (Checking::tracks_versions) {
+                    if (_ctrlBlk != nullptr && _ctrlBlk->version() == INT_MIN) {
+                        typename CtrlBlk::invalidate_reason reason = _ctrlBlk->_reason;
+                        if (reason == CtrlBlk::DESTROY) {
+                            throw invalid_iterator(invalid_iterator::Severity_level::SEVERE);
+                        }
+                        else if (reason == CtrlBlk::COPY_ASSIGN || reason == CtrlBlk::MOVE_ASSIGN) {
+                            throw invalid_iterator(invalid_iterator::Severity_level::MODERATE);
+                        }
+                        else if ((reason == CtrlBlk::POP_BACK || reason == CtrlBlk::POP_FRONT) &&
+                            _slot >= _ctrlBlk->_location && _slot < _ctrlBlk->_location_end) {
+                            throw invalid_iterator(invalid_iterator::Severity_level::SEVERE);
+                        }
+                        else if (reason == CtrlBlk::POP_FRONT || reason == CtrlBlk::PUSH_FRONT) {
+                            throw invalid_iterator(invalid_iterator::Severity_level::WARNING);
+                        }
+                        else {
+                            throw invalid_iterator(invalid_iterator::Severity_level::MILD);
+                        }
+                    }
+                }
+            }
+
+            void validate_deref(void) const {
+                //
+                // Out of range dereferences throw std::out_of_range, unless the iterator is
+                // also invalid with SEVERE
+                //
+                if constexpr (Checking::checks_bounds) {
+                    bool isOutOfRange = _owner == nullptr || _slot < _begin || _slot >= _end;
+                    try {
+                        validate_base();
+                    }
+                    catch (epl::invalid_iterator& ex) {
+                        if (!isOutOfRange || ex.level == invalid_iterator::SEVERE) {
+                            throw ex;
+                        }
+                    }
+                    if (isOutOfRange) {
+                        throw std::out_of_range("Dereferencing pointer out of valid range.");
+                    }
+                }
+            }
+
+            void release(void) {
+                if (_ctrlBlk == nullptr) {
+                    return;
+                }
+                if (_ctrlBlk->decRef()) {
+                    CtrlBlk::release(_ctrlBlk);
+                }
+                _ctrlBlk = nullptr;
+            }
+        };
+
+        typedef segment_iterator<false> iterator;
+        typedef segment_iterator<true> const_iterator;
+
+        SegmentedVector(void) : _map(map_allocator(_alloc)) {
+            init_empty();
+        }
+
+        explicit SegmentedVector(const Alloc& allocator) : _alloc(allocator), _map(map_allocator(_alloc)) {
+            init_empty();
+        }
+
+        SegmentedVector(std::initializer_list<T> init_list, const Alloc& allocator = Alloc()) :
+            _alloc(allocator), _map(map_allocator(_alloc)) {
+            init_empty();
+            copy_from(init_list.begin(), init_list.size());
+        }
+
+        SegmentedVector(const SegmentedVector& other) :
+            _alloc(alloc_traits::select_on_container_copy_construction(other._alloc)), _map(map_allocator(_alloc)) {
+            //
+            // The copy is packed from the first slot of its first segment
+            //
+            init_empty();
+            copy_from(other.begin_unchecked(), other._length);
+        }
+
+        SegmentedVector(SegmentedVector&& other) : _alloc(std::move(other._alloc)), _map(map_allocator(_alloc)) {
+            //
+            // Takes over the segments. Iterators refer to their container, so the ones of
+            // the rhs are invalidated rather than carried over.
+            //
+            init_empty();
+            take_segments(other);
+        }
+
+        SegmentedVector& operator=(const SegmentedVector& other) {
+            if (this != &other) {
+                destroy(CtrlBlk::COPY_ASSIGN);
+                if constexpr (alloc_traits::propagate_on_container_copy_assignment::value) {
+                    _alloc = other._alloc;
+                    _map = segment_map(map_allocator(_alloc));
+                }
+                init_empty();
+                copy_from(other.begin_unchecked(), other._length);
+            }
+            return *this;
+        }
+
+        SegmentedVector& operator=(SegmentedVector&& other) {
+            if (this == &other) {
+                return *this;
+            }
+            destroy(CtrlBlk::MOVE_ASSIGN);
+            if constexpr (alloc_traits::propagate_on_container_move_assignment::value) {
+                _alloc = std::move(other._alloc);
+                _map = segment_map(map_allocator(_alloc));
+            }
+            init_empty();
+            if (alloc_traits::propagate_on_container_move_assignment::value || _alloc == other._alloc) {
+                take_segments(other);
+            }
+            else {
+                //
+                // The segments of the rhs belong to a different allocator: move the
+                // elements one by one
+                //
+                reserve(other._length);
+                for (int64_t s = other._front; s < other._back; s++) {
+                    push_back(std::move(*other.slot(s)));
+                }
+            }
+            return *this;
+        }
+
+        ~SegmentedVector(void) {
+            destroy(CtrlBlk::DESTROY);
+        }
+
+        allocator_type get_allocator(void) const {
+            return _alloc;
+        }
+
+        uint64_t size(void) const {
+            return _length;
+        }
+
+        uint64_t capacity(void) const {
+            //
+            // Total number of cells in the segments, free cells at both ends included
+            //
+            return _map.size() * segment_size;
+        }
+
+        uint64_t segments(void) const {
+            return _map.size();
+        }
+
+        T& operator[](uint64_t k) {
+            //
+            // Range checked like Vector::operator[]
+            //
+            if (k >= _length) {
+                throw std::out_of_range("Array Index out of Range.");
+            }
+            return *slot(_front + (int64_t)k);
+        }
+
+        const T& operator[](uint64_t k) const {
+            if (k >= _length) {
+                throw std::out_of_range("Array Index out of Range.");
+            }
+            return *slot(_front + (int64_t)k);
+        }
+
+        iterator begin(void) {
+            return iterator(this, _front, iterator_ctrlBlk());
+        }
+
+        iterator end(void) {
+            return iterator(this, _back, iterator_ctrlBlk());
+        }
+
+        const_iterator begin(void) const {
+            return const_iterator(this, _front, iterator_ctrlBlk());
+        }
+
+        const_iterator end(void) const {
+            return const_iterator(this, _back, iterator_ctrlBlk());
+        }
+
+        template <typename... Args>
+        void emplace_back(Args&&... args) {
+            insert_back(CtrlBlk::EMPLACE_BACK, std::forward<Args>(args)...);
+        }
+
+        void push_back(const T& val) {
+            insert_back(CtrlBlk::PUSH_BACK, val);
+        }
+
+        void push_back(T&& val) {
+            insert_back(CtrlBlk::PUSH_BACK, std::move(val));
+        }
+
+        void push_front(const T& val) {
+            insert_front(CtrlBlk::PUSH_FRONT, val);
+        }
+
+        void push_front(T&& val) {
+            insert_front(CtrlBlk::PUSH_FRONT, std::move(val));
+        }
+
+        void pop_back(void) {
+            //
+            // Segments are kept when they become empty, like the buffer of a Vector
+            //
+            if (_length == 0) {
+                throw std::out_of_range("Cannot invoke pop_back() when the container is empty.");
+            }
+            _back--;
+            slot(_back)->T::~T();
+            _length--;
+            update_ctrlBlk(CtrlBlk::POP_BACK, _back, _back + 1);
+        }
+
+        void pop_front(void) {
+            if (_length == 0) {
+                throw std::out_of_range("Cannot invoke pop_front() when the container is empty.");
+            }
+            slot(_front)->T::~T();
+            _front++;
+            _length--;
+            update_ctrlBlk(CtrlBlk::POP_FRONT, _front - 1, _front);
+        }
+
+        void reserve(uint64_t n) {
+            //
+            // Makes sure that 'n' elements fit from the current front without adding a
+            // segment. Nothing moves, so iterators stay valid.
+            //
+            while ((uint64_t)(map_end() - _front) < n) {
+                add_back_segment();
+            }
+        }
+
+        void reserve_front(uint64_t n) {
+            while ((uint64_t)(_back - _first) < n) {
+                add_front_segment();
+            }
+        }
+
+    private:
+        static const unsigned segment_shift = detail::log2_of(segment_size);
+        static const uint64_t segment_mask = segment_size - 1;
+
+        Alloc _alloc;
+        //
+        // Segment k holds slots [_first + k * segment_size, _first + (k + 1) * segment_size)
+        //
+        segment_map _map;
+        int64_t _first;
+        //
+        // The live range is slots [_front, _back)
+        //
+        int64_t _front;
+        int64_t _back;
+        uint64_t _length;
+        mutable CtrlBlk* _ctrlBlk;
+
+        void init_empty(void) {
+            _first = 0;
+            _front = 0;
+            _back = 0;
+            _length = 0;
+            if constexpr (Checking::atomic_refs) {
+                _ctrlBlk = CtrlBlk::create(1, _alloc);
+            }
+            else {
+                _ctrlBlk = nullptr;
+            }
+        }
+
+        T* slot(int64_t s) const {
+            uint64_t offset = (uint64_t)(s - _first);
+            return detail::vector_access::front(_map)[offset >> segment_shift] + (offset & segment_mask);
+        }
+
+        int64_t map_end(void) const {
+            return _first + (int64_t)(_map.size() * segment_size);
+        }
+
+        T* allocate_segment(void) {
+            return alloc_traits::allocate(_alloc, (size_t)segment_size);
+        }
+
+        void add_back_segment(void) {
+            //
+            // Appends a segment to the map. A segment at the front that holds no live slot
+            // is moved over instead of allocating a new one, so a queue (push at one end,
+            // pop at the other) runs in a fixed number of segments.
+            //
+            if (_map.size() > 0 && _front - _first >= (int64_t)segment_size) {
+                _map.push_back(_map[0]);
+                _map.pop_front();
+                _first += segment_size;
+                return;
+            }
+            T* segment = allocate_segment();
+            try {
+                _map.push_back(segment);
+            }
+            catch (...) {
+                alloc_traits::deallocate(_alloc, segment, (size_t)segment_size);
+                throw;
+            }
+        }
+
+        void add_front_segment(void) {
+            if (_map.size() > 0 && map_end() - _back >= (int64_t)segment_size) {
+                _map.push_front(_map[_map.size() - 1]);
+                _map.pop_back();
+                _first -= segment_size;
+                return;
+            }
+            T* segment = allocate_segment();
+            try {
+                _map.push_front(segment);
+            }
+            catch (...) {
+                alloc_traits::deallocate(_alloc, segment, (size_t)segment_size);
+                throw;
+            }
+            _first -= segment_size;
+        }
+
+        template <typename... Args>
+        void insert_back(typename CtrlBlk::invalidate_reason reason, Args&&... args) {
+            if (_back == map_end()) {
+                add_back_segment();
+            }
+            new (slot(_back)) T{ std::forward<Args>(args)... };
+            _back++;
+            _length++;
+            update_ctrlBlk(reason, 0, 0);
+        }
+
+        template <typename... Args>
+        void insert_front(typename CtrlBlk::invalidate_reason reason, Args&&... args) {
+            if (_front == _first) {
+                add_front_segment();
+            }
+            new (slot(_front - 1)) T{ std::forward<Args>(args)... };
+            _front--;
+            _length++;
+            update_ctrlBlk(reason, 0, 0);
+        }
+
+        template <typename It>
+        void copy_from(It first, uint64_t n) {
+            reserve(n);
+            try {
+                for (uint64_t k = 0; k < n; ++k, ++first) {
+                    new (slot(_back)) T{ *first };
+                    _back++;
+                    _length++;
+                }
+            }
+            catch (...) {
+                destroy(CtrlBlk::DESTROY);
+                throw;
+            }
+        }
+
+        struct raw_iterator {
+            //
+            // Unchecked forward walk over the slots, used for copying
+            //
+            const SegmentedVector* _owner;
+            int64_t _slot;
+
+            const T& operator*(void) const {
+                return *_owner->slot(_slot);
+            }
+
+            raw_iterator& operator++(void) {
+                _slot++;
+                return *this;
+            }
+        };
+
+        raw_iterator begin_unchecked(void) const {
+            return raw_iterator{ this, _front };
+        }
+
+        void take_segments(SegmentedVector& other) {
+            _map = std::move(other._map);
+            _first = other._first;
+            _front = other._front;
+            _back = other._back;
+            _length = other._length;
+            other._first = 0;
+            other._front = 0;
+            other._back = 0;
+            other._length = 0;
+            other.update_ctrlBlk(CtrlBlk::MOVE_ASSIGN, 0, 0);
+        }
+
+        CtrlBlk* iterator_ctrlBlk(void) const {
+            //
+            // The control block iterators share, created on first use as in Vector
+            //
+            if constexpr (Checking::tracks_versions) {
+                if (_ctrlBlk == nullptr) {
+                    _ctrlBlk = CtrlBlk::create(1, _alloc);
+                }
+                return _ctrlBlk;
+            }
+            else {
+                return nullptr;
+            }
+        }
+
+        void update_ctrlBlk(typename CtrlBlk::invalidate_reason reason, int64_t location, int64_t location_end) {
+            //
+            // Bumps the version, moving to a new block if iterators hold the current one
+            //
+            if (_ctrlBlk == nullptr) {
+                return;
+            }
+            uint64_t version = _ctrlBlk->version();
+            if (!_ctrlBlk->shared()) {
+                _ctrlBlk->set_version(version + 1);
+            }
+            else {
+                CtrlBlk* old = _ctrlBlk;
+                _ctrlBlk = CtrlBlk::create(version + 1, _alloc);
+                old->invalidate(reason, location, location_end);
+                CtrlBlk::abandon(old);
+            }
+        }
+
+        void destroy(typename CtrlBlk::invalidate_reason reason) {
+            //
+            // Destroys the elements and frees the segments. The map keeps its buffer.
+            //
+            if (!std::is_trivially_destructible<T>::value) {
+                for (int64_t s = _front; s < _back; s++) {
+                    slot(s)->T::~T();
+                }
+            }
+            for (uint64_t k = 0; k < _map.size(); k++) {
+                alloc_traits::deallocate(_alloc, _map[k], (size_t)segment_size);
+            }
+            while (_map.size() > 0) {
+                _map.pop_back();
+            }
+            _first = 0;
+            _front = 0;
+            _back = 0;
+            _length = 0;
+            if (_ctrlBlk != nullptr) {
+                _ctrlBlk->invalidate(reason, 0, 0);
+                CtrlBlk::abandon(_ctrlBlk);
+                _ctrlBlk = nullptr;
+            }
+        }
+    };
+}
+
+#endif
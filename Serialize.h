@@ -0,0 +1,514 @@
+#ifndef _SERIALIZE_H_
+#define _SERIALIZE_H_
+
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+
+#include <poll.h>
+#include <unistd.h>
+
+#include "Vector.h"
+
+namespace epl
+{
+    //
+    // Binary serialization of Vectors to file descriptors and standard streams. Every
+    // serialized vector starts with a small header (magic, element size, element count,
+    // format), followed by either
+    //
+    //   raw   - the bytes of the live range, for trivially copyable T without a codec.
+    //           Written with one write straight from [_front, _back) and read straight
+    //           into the free cells of the target vector: no staging copy either way.
+    //   codec - the elements as encoded by a user supplied codec, in frames of at most
+    //           serialize_chunk_size bytes, each preceded by its length and the last one
+    //           followed by an empty frame.
+    //
+    // A codec for T is any object with
+    //
+    //   void encode(const T& value, epl::byte_writer& out);
+    //   T decode(epl::byte_reader& in);
+    //
+    // While a codec stream is decoded, a background thread already reads the next frame,
+    // so I/O overlaps the construction of the elements. If decoding stops early, that
+    // thread is called off: on a file descriptor it only ever blocks in poll() with a
+    // timeout, so a pipe or socket whose writer keeps it open does not hold it up. A
+    // std::istream cannot be interrupted; one that may block must eventually deliver
+    // its data, reach its end or fail. Framing also means that reading
+    // never consumes bytes past the end of the vector, so several vectors (or other data)
+    // can share a stream. Numbers are stored in native byte order.
+    //
+    static const size_t serialize_chunk_size = (size_t)1 << 20;
+
+    //
+    // How often a prefetching thread waiting on a file descriptor checks whether it was
+    // called off
+    //
+    static const int serialize_poll_ms = 10;
+
+    namespace detail
+    {
+        struct serial_header {
+            uint64_t magic;
+            uint64_t element_size;
+            uint64_t count;
+            uint64_t format;
+        };
+
+        static const uint64_t serial_magic = 0x31305253564c5045ULL; // "EPLVSR01"
+        static const uint64_t serial_raw = 0;
+        static const uint64_t serial_codec = 1;
+
+        inline void write_fd(int fd, const void* data, size_t n) {
+            const char* p = static_cast<const char*>(data);
+            while (n > 0) {
+                ssize_t done = ::write(fd, p, n);
+                if (done < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    throw std::system_error(errno, std::generic_category(), "Serialization write failed");
+                }
+                p += done;
+                n -= (size_t)done;
+            }
+        }
+
+        inline bool wait_readable(int fd, const std::atomic<bool>& stop) {
+            //
+            // Waits until 'fd' has data (or an error or hangup for read() to report), and
+            // returns false instead once 'stop' is set
+            //
+            pollfd pfd;
+            pfd.fd = fd;
+            pfd.events = POLLIN;
+            for (;;) {
+                if (stop.load(std::memory_order_relaxed)) {
+                    return false;
+                }
+                pfd.revents = 0;
+                int ready = ::poll(&pfd, 1, serialize_poll_ms);
+                if (ready > 0 || (ready < 0 && errno != EINTR)) {
+                    return true;
+                }
+            }
+        }
+
+        inline void read_fd(int fd, void* data, size_t n, const std::atomic<bool>* stop = nullptr) {
+            char* p = static_cast<char*>(data);
+            while (n > 0) {
+                if (stop != nullptr && !wait_readable(fd, *stop)) {
+                    throw std::runtime_error("Deserialization read was stopped");
+                }
+                ssize_t done = ::read(fd, p, n);
+                if (done < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    throw std::system_error(errno, std::generic_category(), "Deserialization read failed");
+                }
+                if (done == 0) {
+                    throw std::runtime_error("Serialized Vector is truncated");
+                }
+                p += done;
+                n -= (size_t)done;
+            }
+        }
+
+        inline void write_stream(std::ostream& os, const void* data, size_t n) {
+            os.write(static_cast<const char*>(data), (std::streamsize)n);
+            if (!os) {
+                throw std::runtime_error("Serialization write failed");
+            }
+        }
+
+        inline void read_stream(std::istream& is, void* data, size_t n) {
+            is.read(static_cast<char*>(data), (std::streamsize)n);
+            if ((size_t)is.gcount() != n) {
+                throw std::runtime_error("Serialized Vector is truncated");
+            }
+        }
+
+        //
+        // The sink and source a (de)serialization works on: write all of / read exactly
+        // the given bytes, or throw
+        //
+        typedef std::function<void(const void*, size_t)> write_fn;
+        typedef std::function<void(void*, size_t)> read_fn;
+
+        inline write_fn fd_writer(int fd) {
+            return [fd](const void* data, size_t n) { write_fd(fd, data, n); };
+        }
+
+        inline read_fn fd_reader(int fd) {
+            return [fd](void* data, size_t n) { read_fd(fd, data, n); };
+        }
+
+        inline write_fn stream_writer(std::ostream& os) {
+            return [&os](const void* data, size_t n) { write_stream(os, data, n); };
+        }
+
+        inline read_fn stream_reader(std::istream& is) {
+            return [&is](void* data, size_t n) { read_stream(is, data, n); };
+        }
+
+        class frame_prefetcher {
+        public:
+            //
+            // Reads the frames of a codec stream on a background thread into two buffers:
+            // while the consumer works through one frame, the next one is being read.
+            // Given the file descriptor behind 'read', it reads that directly instead, so
+            // that the destructor can interrupt a read that is waiting for data.
+            //
+            explicit frame_prefetcher(const read_fn& read, int fd = -1) :
+                _read(read), _fd(fd), _consumed(0), _end(false), _stop(false) {
+                for (int k = 0; k < 2; k++) {
+                    _buffers[k].reset(new char[serialize_chunk_size]);
+                    _lengths[k] = 0;
+                    _ready[k] = false;
+                }
+                _thread = std::thread([this] { this->fill(); });
+            }
+
+            frame_prefetcher(const frame_prefetcher&) = delete;
+            frame_prefetcher& operator=(const frame_prefetcher&) = delete;
+
+            ~frame_prefetcher() {
+                {
+                    std::lock_guard<std::mutex> lock(_lock);
+                    _stop = true;
+                }
+                _changed.notify_all();
+                _thread.join();
+            }
+
+            bool next(const char*& data, size_t& length) {
+                //
+                // Hands out the next frame, and gives the previous one back to the reader.
+                // Returns false after the last frame.
+                //
+                std::unique_lock<std::mutex> lock(_lock);
+                if (_consumed > 0) {
+                    _ready[(_consumed - 1) % 2] = false;
+                    _changed.notify_all();
+                }
+                int slot = (int)(_consumed % 2);
+                _changed.wait(lock, [this, slot] { return _ready[slot] || _end || _error; });
+                if (!_ready[slot]) {
+                    if (_error) {
+                        std::rethrow_exception(_error);
+                    }
+                    return false;
+                }
+                data = _buffers[slot].get();
+                length = _lengths[slot];
+                _consumed++;
+                return true;
+            }
+
+        private:
+            read_fn _read;
+            int _fd;
+            std::unique_ptr<char[]> _buffers[2];
+            size_t _lengths[2];
+            bool _ready[2];
+            uint64_t _consumed;
+            bool _end;
+            //
+            // Set under _lock, but also polled without it by a read waiting on _fd
+            //
+            std::atomic<bool> _stop;
+            std::exception_ptr _error;
+            std::mutex _lock;
+            std::condition_variable _changed;
+            std::thread _thread;
+
+            void read(void* data, size_t n) {
+                if (_fd >= 0) {
+                    read_fd(_fd, data, n, &_stop);
+                }
+                else {
+                    _read(data, n);
+                }
+            }
+
+            void fill(void) {
+                try {
+                    for (uint64_t k = 0;; k++) {
+                        int slot = (int)(k % 2);
+                        {
+                            std::unique_lock<std::mutex> lock(_lock);
+                            _changed.wait(lock, [this, slot] { return !_ready[slot] || _stop; });
+                            if (_stop) {
+                                return;
+                            }
+                        }
+                        uint64_t length;
+                        read(&length, sizeof(length));
+                        if (length > serialize_chunk_size) {
+                            throw std::runtime_error("Serialized Vector has a corrupt frame");
+                        }
+                        if (length > 0) {
+                            read(_buffers[slot].get(), (size_t)length);
+                        }
+                        std::lock_guard<std::mutex> lock(_lock);
+                        if (length == 0) {
+                            _end = true;
+                        }
+                        else {
+                            _lengths[slot] = (size_t)length;
+                            _ready[slot] = true;
+                        }
+                        _changed.notify_all();
+                        if (length == 0) {
+                            return;
+                        }
+                    }
+                }
+                catch (...) {
+                    std::lock_guard<std::mutex> lock(_lock);
+                    _error = std::current_exception();
+                    _changed.notify_all();
+                }
+            }
+        };
+    }
+
+    class byte_writer {
+    public:
+        //
+        // Where a codec writes encoded elements. Bytes are collected into frames of
+        // serialize_chunk_size and handed to the sink a frame at a time.
+        //
+        explicit byte_writer(const detail::write_fn& sink) :
+            _sink(sink), _buffer(new char[serialize_chunk_size]), _used(0) {}
+
+        void write(const void* data, size_t n) {
+            const char* p = static_cast<const char*>(data);
+            while (n > 0) {
+                size_t room = serialize_chunk_size - _used;
+                size_t take = n < room ? n : room;
+                std::memcpy(_buffer.get() + _used, p, take);
+                _used += take;
+                p += take;
+                n -= take;
+                if (_used == serialize_chunk_size) {
+                    flush();
+                }
+            }
+        }
+
+        template <typename U>
+        void write_value(const U& value) {
+            static_assert(std::is_trivially_copyable<U>::value, "write_value copies raw bytes");
+            write(&value, sizeof(U));
+        }
+
+        void finish(void) {
+            //
+            // Writes out the last frame and the end marker
+            //
+            flush();
+            uint64_t end = 0;
+            _sink(&end, sizeof(end));
+        }
+
+    private:
+        detail::write_fn _sink;
+        std::unique_ptr<char[]> _buffer;
+        size_t _used;
+
+        void flush(void) {
+            if (_used == 0) {
+                return;
+            }
+            uint64_t length = _used;
+            _sink(&length, sizeof(length));
+            _sink(_buffer.get(), _used);
+            _used = 0;
+        }
+    };
+
+    class byte_reader {
+    public:
+        //
+        // Where a codec reads encoded elements from. Reads may span frames.
+        //
+        explicit byte_reader(const detail::read_fn& source, int fd = -1) :
+            _frames(source, fd), _data(nullptr), _length(0), _pos(0) {}
+
+        void read(void* data, size_t n) {
+            char* p = static_cast<char*>(data);
+            while (n > 0) {
+                if (_pos == _length) {
+                    if (!_frames.next(_data, _length)) {
+                        throw std::runtime_error("Serialized Vector is truncated");
+                    }
+                    _pos = 0;
+                }
+                size_t avail = _length - _pos;
+                size_t take = n < avail ? n : avail;
+                std::memcpy(p, _data + _pos, take);
+                _pos += take;
+                p += take;
+                n -= take;
+            }
+        }
+
+        template <typename U>
+        U read_value(void) {
+            static_assert(std::is_trivially_copyable<U>::value, "read_value copies raw bytes");
+            U value;
+            read(&value, sizeof(U));
+            return value;
+        }
+
+        void finish(void) {
+            //
+            // Expects the stream to be exhausted, and consumes its end marker
+            //
+            const char* data;
+            size_t length;
+            if (_pos != _length || _frames.next(data, length)) {
+                throw std::runtime_error("Serialized Vector has trailing data");
+            }
+        }
+
+    private:
+        detail::frame_prefetcher _frames;
+        const char* _data;
+        size_t _length;
+        size_t _pos;
+    };
+
+    namespace detail
+    {
+        template <typename T, typename C, typename A, typename G>
+        void serialize_raw(const Vector<T, C, A, G>& v, const write_fn& sink) {
+            static_assert(std::is_trivially_copyable<T>::value, "Elements that are not trivially copyable need a codec");
+            serial_header header = { serial_magic, sizeof(T), v.size(), serial_raw };
+            sink(&header, sizeof(header));
+            if (v.size() > 0) {
+                sink(vector_access::front(v), (size_t)v.size() * sizeof(T));
+            }
+        }
+
+        template <typename T, typename C, typename A, typename G, typename Codec>
+        void serialize_codec(const Vector<T, C, A, G>& v, const write_fn& sink, Codec& codec) {
+            serial_header header = { serial_magic, sizeof(T), v.size(), serial_codec };
+            sink(&header, sizeof(header));
+            byte_writer out(sink);
+            const T* front = vector_access::front(v);
+            for (uint64_t k = 0; k < v.size(); k++) {
+                codec.encode(front[k], out);
+            }
+            out.finish();
+        }
+
+        inline serial_header read_header(const read_fn& source, uint64_t format, size_t element_size) {
+            serial_header header;
+            source(&header, sizeof(header));
+            if (header.magic != serial_magic) {
+                throw std::runtime_error("Not a serialized Vector");
+            }
+            if (header.format != format) {
+                throw std::runtime_error(format == serial_raw ? "Serialized Vector needs a codec" :
+                    "Serialized Vector holds raw elements");
+            }
+            if (header.element_size != element_size) {
+                throw std::runtime_error("Serialized Vector holds elements of a different type");
+            }
+            return header;
+        }
+
+        template <typename T, typename C, typename A, typename G>
+        void deserialize_raw(Vector<T, C, A, G>& v, const read_fn& source) {
+            static_assert(std::is_trivially_copyable<T>::value, "Elements that are not trivially copyable need a codec");
+            serial_header header = read_header(source, serial_raw, sizeof(T));
+            //
+            // Read straight into the free cells after _back, then adopt them
+            //
+            v.reserve(v.size() + header.count);
+            T* dest = vector_access::back(v);
+            uint64_t done = 0;
+            while (done < header.count) {
+                uint64_t n = header.count - done;
+                uint64_t chunk = serialize_chunk_size / sizeof(T) > 0 ? serialize_chunk_size / sizeof(T) : 1;
+                n = n < chunk ? n : chunk;
+                source(dest + done, (size_t)n * sizeof(T));
+                done += n;
+            }
+            vector_access::commit_back(v, header.count);
+        }
+
+        template <typename T, typename C, typename A, typename G, typename Codec>
+        void deserialize_codec(Vector<T, C, A, G>& v, const read_fn& source, Codec& codec, int fd = -1) {
+            serial_header header = read_header(source, serial_codec, sizeof(T));
+            v.reserve(v.size() + header.count);
+            byte_reader in(source, fd);
+            for (uint64_t k = 0; k < header.count; k++) {
+                v.push_back(codec.decode(in));
+            }
+            in.finish();
+        }
+    }
+
+    template <typename T, typename C, typename A, typename G>
+    void serialize(const Vector<T, C, A, G>& v, int fd) {
+        detail::serialize_raw(v, detail::fd_writer(fd));
+    }
+
+    template <typename T, typename C, typename A, typename G>
+    void serialize(const Vector<T, C, A, G>& v, std::ostream& os) {
+        detail::serialize_raw(v, detail::stream_writer(os));
+    }
+
+    template <typename T, typename C, typename A, typename G, typename Codec>
+    void serialize(const Vector<T, C, A, G>& v, int fd, Codec codec) {
+        detail::serialize_codec(v, detail::fd_writer(fd), codec);
+    }
+
+    template <typename T, typename C, typename A, typename G, typename Codec>
+    void serialize(const Vector<T, C, A, G>& v, std::ostream& os, Codec codec) {
+        detail::serialize_codec(v, detail::stream_writer(os), codec);
+    }
+
+    //
+    // Deserialization appends the elements to 'v'. It throws std::runtime_error for a
+    // stream that is not a serialized vector of T in the expected format, or is cut
+    // short; 'v' keeps whatever elements were read before.
+    //
+    template <typename T, typename C, typename A, typename G>
+    void deserialize(Vector<T, C, A, G>& v, int fd) {
+        detail::deserialize_raw(v, detail::fd_reader(fd));
+    }
+
+    template <typename T, typename C, typename A, typename G>
+    void deserialize(Vector<T, C, A, G>& v, std::istream& is) {
+        detail::deserialize_raw(v, detail::stream_reader(is));
+    }
+
+    template <typename T, typename C, typename A, typename G, typename Codec>
+    void deserialize(Vector<T, C, A, G>& v, int fd, Codec codec) {
+        detail::deserialize_codec(v, detail::fd_reader(fd), codec, fd);
+    }
+
+    template <typename T, typename C, typename A, typename G, typename Codec>
+    void deserialize(Vector<T, C, A, G>& v, std::istream& is, Codec codec) {
+        detail::deserialize_codec(v, detail::stream_reader(is), codec);
+    }
+}
+
+#endif
@@ -0,0 +1,578 @@
+#ifndef _SIMD_H_
+#define _SIMD_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include "Span.h"
+#include "Vector.h"
+
+namespace epl
+{
+    namespace simd
+    {
+        //
+        // Vectorized numeric kernels over Vector<float>, Vector<double> and Vector<int32_t>
+        // (any checking policy, allocator or growth policy). The live range of a vector is
+        // one contiguous run of cells, so the kernels work on it directly, with unaligned
+        // loads: _front need not be aligned, since pushes and pops at the front move it.
+        // An AlignedVector keeps the loads on cache line boundaries in the common case.
+        //
+        // Every kernel is compiled for four instruction sets, and the widest one the CPU
+        // supports is picked once at run time:
+        //
+        //   SCALAR - one element at a time
+        //   SSE2   - 128 bit vectors (the x86-64 baseline; on other targets whatever
+        //            128 bit vectors compile to)
+        //   AVX2   - 256 bit vectors, with FMA
+        //   AVX512 - 512 bit vectors (AVX-512F)
+        //
+        // The kernels are written once with GCC vector extensions and instantiated per
+        // width inside functions carrying the matching target attribute, so the header
+        // needs GCC or Clang but no special compiler flags.
+        //
+        // Reductions keep several partial sums per lane, so float and double results may
+        // differ from a sequential loop in the last bits. Integer arithmetic wraps: the
+        // int32_t sums, products and differences are computed on the same bits as uint32_t.
+        //
+        typedef enum {
+            SCALAR,
+            SSE2,
+            AVX2,
+            AVX512
+        } isa_level;
+
+        namespace detail
+        {
+            template <typename T>
+            struct is_kernel_type : std::integral_constant<bool,
+                std::is_same<T, float>::value || std::is_same<T, double>::value || std::is_same<T, int32_t>::value> {};
+
+            template <typename T>
+            struct arithmetic_type {
+                //
+                // The type the sums and products of T are computed in; for int32_t that is
+                // uint32_t, whose overflow is defined to wrap where int32_t's is undefined
+                //
+                typedef T type;
+            };
+
+            template <>
+            struct arithmetic_type<int32_t> {
+                typedef uint32_t type;
+            };
+
+            template <typename T>
+            __attribute__((always_inline)) inline const typename arithmetic_type<T>::type* arithmetic(const T* p) {
+                return reinterpret_cast<const typename arithmetic_type<T>::type*>(p);
+            }
+
+            template <typename T>
+            __attribute__((always_inline)) inline typename arithmetic_type<T>::type* arithmetic(T* p) {
+                return reinterpret_cast<typename arithmetic_type<T>::type*>(p);
+            }
+
+            template <typename T, unsigned Bytes>
+            struct generic {
+                //
+                // The kernels for one element type and one vector width. Everything is forced
+                // inline, so that the code is generated for the instruction set of the
+                // (target specific) function it ends up in.
+                //
+                typedef T vec __attribute__((vector_size(Bytes)));
+                //
+                // The same vector, but only as aligned as T, for loads and stores at any
+                // element (and allowed to alias the elements)
+                //
+                typedef T uvec __attribute__((vector_size(Bytes), aligned(alignof(T)), may_alias));
+                static const uint64_t W = Bytes / sizeof(T);
+
+                __attribute__((always_inline)) static inline const uvec& at(const T* p) {
+                    return *reinterpret_cast<const uvec*>(p);
+                }
+
+                __attribute__((always_inline)) static inline uvec& at(T* p) {
+                    return *reinterpret_cast<uvec*>(p);
+                }
+
+                __attribute__((always_inline)) static inline T hsum(const vec& v) {
+                    T s = v[0];
+                    for (uint64_t j = 1; j < W; j++) {
+                        s += v[j];
+                    }
+                    return s;
+                }
+
+                __attribute__((always_inline)) static inline bool any(const vec& mask) {
+                    //
+                    // Whether any lane of a comparison result is set
+                    //
+                    uint64_t words[Bytes / sizeof(uint64_t) > 0 ? Bytes / sizeof(uint64_t) : 1] = {};
+                    memcpy(words, &mask, Bytes);
+                    uint64_t acc = 0;
+                    for (uint64_t j = 0; j < sizeof(words) / sizeof(uint64_t); j++) {
+                        acc |= words[j];
+                    }
+                    return acc != 0;
+                }
+
+                __attribute__((always_inline)) static inline T sum(const T* p, uint64_t n) {
+                    //
+                    // Four independent accumulators keep the adder pipeline busy
+                    //
+                    vec a0 = {}, a1 = {}, a2 = {}, a3 = {};
+                    uint64_t k = 0;
+                    for (; k + 4 * W <= n; k += 4 * W) {
+                        a0 += at(p + k);
+                        a1 += at(p + k + W);
+                        a2 += at(p + k + 2 * W);
+                        a3 += at(p + k + 3 * W);
+                    }
+                    for (; k + W <= n; k += W) {
+                        a0 += at(p + k);
+                    }
+                    a0 = (a0 + a1) + (a2 + a3);
+                    T s = hsum(a0);
+                    for (; k < n; k++) {
+                        s += p[k];
+                    }
+                    return s;
+                }
+
+                __attribute__((always_inline)) static inline T dot(const T* x, const T* y, uint64_t n) {
+                    vec a0 = {}, a1 = {}, a2 = {}, a3 = {};
+                    uint64_t k = 0;
+                    for (; k + 4 * W <= n; k += 4 * W) {
+                        a0 += at(x + k) * at(y + k);
+                        a1 += at(x + k + W) * at(y + k + W);
+                        a2 += at(x + k + 2 * W) * at(y + k + 2 * W);
+                        a3 += at(x + k + 3 * W) * at(y + k + 3 * W);
+                    }
+                    for (; k + W <= n; k += W) {
+                        a0 += at(x + k) * at(y + k);
+                    }
+                    a0 = (a0 + a1) + (a2 + a3);
+                    T s = hsum(a0);
+                    for (; k < n; k++) {
+                        s += x[k] * y[k];
+                    }
+                    return s;
+                }
+
+                __attribute__((always_inline)) static inline void axpy(T a, const T* x, T* y, uint64_t n) {
+                    vec va = {};
+                    va += a;
+                    uint64_t k = 0;
+                    for (; k + W <= n; k += W) {
+                        at(y + k) += va * at(x + k);
+                    }
+                    for (; k < n; k++) {
+                        y[k] += a * x[k];
+                    }
+                }
+
+                __attribute__((always_inline)) static inline T min(const T* p, uint64_t n) {
+                    //
+                    // Expects n > 0
+                    //
+                    uint64_t k = 0;
+                    T m = p[0];
+                    if (n >= 2 * W) {
+                        vec m0 = at(p), m1 = at(p + W);
+                        for (k = 2 * W; k + 2 * W <= n; k += 2 * W) {
+                            vec x0 = at(p + k), x1 = at(p + k + W);
+                            m0 = x0 < m0 ? x0 : m0;
+                            m1 = x1 < m1 ? x1 : m1;
+                        }
+                        m0 = m1 < m0 ? m1 : m0;
+                        for (uint64_t j = 0; j < W; j++) {
+                            m = m0[j] < m ? m0[j] : m;
+                        }
+                    }
+                    for (; k < n; k++) {
+                        m = p[k] < m ? p[k] : m;
+                    }
+                    return m;
+                }
+
+                __attribute__((always_inline)) static inline T max(const T* p, uint64_t n) {
+                    uint64_t k = 0;
+                    T m = p[0];
+                    if (n >= 2 * W) {
+                        vec m0 = at(p), m1 = at(p + W);
+                        for (k = 2 * W; k + 2 * W <= n; k += 2 * W) {
+                            vec x0 = at(p + k), x1 = at(p + k + W);
+                            m0 = m0 < x0 ? x0 : m0;
+                            m1 = m1 < x1 ? x1 : m1;
+                        }
+                        m0 = m0 < m1 ? m1 : m0;
+                        for (uint64_t j = 0; j < W; j++) {
+                            m = m < m0[j] ? m0[j] : m;
+                        }
+                    }
+                    for (; k < n; k++) {
+                        m = m < p[k] ? p[k] : m;
+                    }
+                    return m;
+                }
+
+                __attribute__((always_inline)) static inline uint64_t find(const T* p, uint64_t n, T value) {
+                    //
+                    // Compares 4 vectors at a time and only looks at single elements once a
+                    // block is known to contain a match
+                    //
+                    vec s = {};
+                    s += value;
+                    uint64_t k = 0;
+                    for (; k + 4 * W <= n; k += 4 * W) {
+                        vec hits = (vec)((at(p + k) == s) | (at(p + k + W) == s) |
+                            (at(p + k + 2 * W) == s) | (at(p + k + 3 * W) == s));
+                        if (any(hits)) {
+                            break;
+                        }
+                    }
+                    for (; k < n; k++) {
+                        if (p[k] == value) {
+                            return k;
+                        }
+                    }
+                    return n;
+                }
+
+                template <typename Op>
+                __attribute__((always_inline)) static inline void apply(const T* a, const T* b, T* out, uint64_t n) {
+                    //
+                    // out[k] = a[k] op b[k]. 'out' may be 'a' or 'b'.
+                    //
+                    uint64_t k = 0;
+                    for (; k + W <= n; k += W) {
+                        Op::run(at(out + k), at(a + k), at(b + k));
+                    }
+                    for (; k < n; k++) {
+                        Op::run(out[k], a[k], b[k]);
+                    }
+                }
+            };
+
+            struct plus {
+                template <typename V, typename U>
+                __attribute__((always_inline)) static inline void run(V& out, const U& a, const U& b) {
+                    out = a + b;
+                }
+            };
+
+            struct minus {
+                template <typename V, typename U>
+                __attribute__((always_inline)) static inline void run(V& out, const U& a, const U& b) {
+                    out = a - b;
+                }
+            };
+
+            struct multiplies {
+                template <typename V, typename U>
+                __attribute__((always_inline)) static inline void run(V& out, const U& a, const U& b) {
+                    out = a * b;
+                }
+            };
+
+            template <typename T>
+            struct kernel_table {
+                T (*sum)(const T*, uint64_t);
+                T (*dot)(const T*, const T*, uint64_t);
+                void (*axpy)(T, const T*, T*, uint64_t);
+                T (*min)(const T*, uint64_t);
+                T (*max)(const T*, uint64_t);
+                uint64_t (*find)(const T*, uint64_t, T);
+                void (*add)(const T*, const T*, T*, uint64_t);
+                void (*sub)(const T*, const T*, T*, uint64_t);
+                void (*mul)(const T*, const T*, T*, uint64_t);
+            };
+
+            template <typename T, unsigned Bytes>
+            struct baseline_kernels {
+                //
+                // Kernels needing nothing beyond the default target (scalar and SSE2)
+                //
+                typedef generic<T, Bytes> k;
+                typedef generic<typename arithmetic_type<T>::type, Bytes> a;
+
+                static T sum(const T* p, uint64_t n) { return (T)a::sum(arithmetic(p), n); }
+                static T dot(const T* x, const T* y, uint64_t n) { return (T)a::dot(arithmetic(x), arithmetic(y), n); }
+                static void axpy(T c, const T* x, T* y, uint64_t n) { a::axpy(c, arithmetic(x), arithmetic(y), n); }
+                static T min(const T* p, uint64_t n) { return k::min(p, n); }
+                static T max(const T* p, uint64_t n) { return k::max(p, n); }
+                static uint64_t find(const T* p, uint64_t n, T value) { return k::find(p, n, value); }
+                static void add(const T* x, const T* y, T* out, uint64_t n) { a::template apply<plus>(arithmetic(x), arithmetic(y), arithmetic(out), n); }
+                static void sub(const T* x, const T* y, T* out, uint64_t n) { a::template apply<minus>(arithmetic(x), arithmetic(y), arithmetic(out), n); }
+                static void mul(const T* x, const T* y, T* out, uint64_t n) { a::template apply<multiplies>(arithmetic(x), arithmetic(y), arithmetic(out), n); }
+            };
+
+#if defined(__x86_64__) || defined(__i386__)
+            template <typename T>
+            struct avx2_kernels {
+                typedef generic<T, 32> k;
+                typedef generic<typename arithmetic_type<T>::type, 32> a;
+
+                __attribute__((target("avx2,fma"))) static T sum(const T* p, uint64_t n) { return (T)a::sum(arithmetic(p), n); }
+                __attribute__((target("avx2,fma"))) static T dot(const T* x, const T* y, uint64_t n) { return (T)a::dot(arithmetic(x), arithmetic(y), n); }
+                __attribute__((target("avx2,fma"))) static void axpy(T c, const T* x, T* y, uint64_t n) { a::axpy(c, arithmetic(x), arithmetic(y), n); }
+                __attribute__((target("avx2,fma"))) static T min(const T* p, uint64_t n) { return k::min(p, n); }
+                __attribute__((target("avx2,fma"))) static T max(const T* p, uint64_t n) { return k::max(p, n); }
+                __attribute__((target("avx2,fma"))) static uint64_t find(const T* p, uint64_t n, T value) { return k::find(p, n, value); }
+                __attribute__((target("avx2,fma"))) static void add(const T* x, const T* y, T* out, uint64_t n) { a::template apply<plus>(arithmetic(x), arithmetic(y), arithmetic(out), n); }
+                __attribute__((target("avx2,fma"))) static void sub(const T* x, const T* y, T* out, uint64_t n) { a::template apply<minus>(arithmetic(x), arithmetic(y), arithmetic(out), n); }
+                __attribute__((target("avx2,fma"))) static void mul(const T* x, const T* y, T* out, uint64_t n) { a::template apply<multiplies>(arithmetic(x), arithmetic(y), arithmetic(out), n); }
+            };
+
+            template <typename T>
+            struct avx512_kernels {
+                typedef generic<T, 64> k;
+                typedef generic<typename arithmetic_type<T>::type, 64> a;
+
+                __attribute__((target("avx512f"))) static T sum(const T* p, uint64_t n) { return (T)a::sum(arithmetic(p), n); }
+                __attribute__((target("avx512f"))) static T dot(const T* x, const T* y, uint64_t n) { return (T)a::dot(arithmetic(x), arithmetic(y), n); }
+                __attribute__((target("avx512f"))) static void axpy(T c, const T* x, T* y, uint64_t n) { a::axpy(c, arithmetic(x), arithmetic(y), n); }
+                __attribute__((target("avx512f"))) static T min(const T* p, uint64_t n) { return k::min(p, n); }
+                __attribute__((target("avx512f"))) static T max(const T* p, uint64_t n) { return k::max(p, n); }
+                __attribute__((target("avx512f"))) static uint64_t find(const T* p, uint64_t n, T value) { return k::find(p, n, value); }
+                __attribute__((target("avx512f"))) static void add(const T* x, const T* y, T* out, uint64_t n) { a::template apply<plus>(arithmetic(x), arithmetic(y), arithmetic(out), n); }
+                __attribute__((target("avx512f"))) static void sub(const T* x, const T* y, T* out, uint64_t n) { a::template apply<minus>(arithmetic(x), arithmetic(y), arithmetic(out), n); }
+                __attribute__((target("avx512f"))) static void mul(const T* x, const T* y, T* out, uint64_t n) { a::template apply<multiplies>(arithmetic(x), arithmetic(y), arithmetic(out), n); }
+            };
+#else
+            //
+            // No wider vectors to dispatch to; the 128 bit kernels stand in
+            //
+            template <typename T>
+            struct avx2_kernels : baseline_kernels<T, 16> {};
+
+            template <typename T>
+            struct avx512_kernels : baseline_kernels<T, 16> {};
+#endif
+
+            template <typename T, typename K>
+            kernel_table<T> make_table(void) {
+                kernel_table<T> table = { &K::sum, &K::dot, &K::axpy, &K::min, &K::max, &K::find, &K::add, &K::sub, &K::mul };
+                return table;
+            }
+
+            inline isa_level detect_isa(void) {
+#if defined(__x86_64__) || defined(__i386__)
+                __builtin_cpu_init();
+                if (__builtin_cpu_supports("avx512f")) {
+                    return AVX512;
+                }
+                if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+                    return AVX2;
+                }
+                if (__builtin_cpu_supports("sse2")) {
+                    return SSE2;
+                }
+                return SCALAR;
+#else
+                return SSE2;
+#endif
+            }
+
+            inline std::atomic<int>& active_level(void) {
+                static std::atomic<int> level(detect_isa());
+                return level;
+            }
+
+            template <typename T>
+            const kernel_table<T>& kernels(void) {
+                static const kernel_table<T> tables[4] = {
+                    make_table<T, baseline_kernels<T, sizeof(T)>>(),
+                    make_table<T, baseline_kernels<T, 16>>(),
+                    make_table<T, avx2_kernels<T>>(),
+                    make_table<T, avx512_kernels<T>>()
+                };
+                return tables[active_level().load(std::memory_order_relaxed)];
+            }
+
+            template <typename T, typename C, typename A, typename G>
+            const T* data(const Vector<T, C, A, G>& v) {
+                static_assert(is_kernel_type<T>::value, "epl::simd kernels support float, double and int32_t elements");
+                return epl::detail::vector_access::front(v);
+            }
+
+            template <typename T, typename C, typename A, typename G>
+            T* data(Vector<T, C, A, G>& v) {
+                static_assert(is_kernel_type<T>::value, "epl::simd kernels support float, double and int32_t elements");
+                return epl::detail::vector_access::front(v);
+            }
+
+            template <typename T>
+            struct span_element {
+                typedef typename std::remove_const<T>::type type;
+                static_assert(is_kernel_type<type>::value, "epl::simd kernels support float, double and int32_t elements");
+            };
+
+            inline void check_sizes(uint64_t a, uint64_t b) {
+                if (a != b) {
+                    throw std::invalid_argument("Vector sizes differ.");
+                }
+            }
+        }
+
+        inline isa_level detected_isa(void) {
+            //
+            // The widest instruction set this CPU supports
+            //
+            static const isa_level level = detail::detect_isa();
+            return level;
+        }
+
+        inline isa_level active_isa(void) {
+            //
+            // The instruction set the kernels currently run with
+            //
+            return (isa_level)detail::active_level().load(std::memory_order_relaxed);
+        }
+
+        inline void limit_isa(isa_level level) {
+            //
+            // Restricts the kernels to 'level' (or what the CPU supports, if that is less),
+            // e.g. to compare the code paths against each other
+            //
+            isa_level supported = detected_isa();
+            detail::active_level().store(level < supported ? level : supported, std::memory_order_relaxed);
+        }
+
+        template <typename T, typename C, typename A, typename G>
+        T sum(const Vector<T, C, A, G>& v) {
+            return detail::kernels<T>().sum(detail::data(v), v.size());
+        }
+
+        template <typename T, typename C, typename A, typename G, typename C2, typename A2, typename G2>
+        T dot(const Vector<T, C, A, G>& x, const Vector<T, C2, A2, G2>& y) {
+            //
+            // Sum of x[k] * y[k]. Throws std::invalid_argument if the sizes differ.
+            //
+            detail::check_sizes(x.size(), y.size());
+            return detail::kernels<T>().dot(detail::data(x), detail::data(y), x.size());
+        }
+
+        template <typename T, typename C, typename A, typename G, typename C2, typename A2, typename G2>
+        void axpy(T a, const Vector<T, C, A, G>& x, Vector<T, C2, A2, G2>& y) {
+            //
+            // y[k] += a * x[k]. Throws std::invalid_argument if the sizes differ.
+            //
+            detail::check_sizes(x.size(), y.size());
+            detail::kernels<T>().axpy(a, detail::data(x), detail::data(y), x.size());
+        }
+
+        template <typename T, typename C, typename A, typename G>
+        T min(const Vector<T, C, A, G>& v) {
+            //
+            // Smallest element. Throws std::out_of_range for an empty vector.
+            //
+            if (v.size() == 0) {
+                throw std::out_of_range("Minimum of an empty Vector.");
+            }
+            return detail::kernels<T>().min(detail::data(v), v.size());
+        }
+
+        template <typename T, typename C, typename A, typename G>
+        T max(const Vector<T, C, A, G>& v) {
+            //
+            // Largest element. Throws std::out_of_range for an empty vector.
+            //
+            if (v.size() == 0) {
+                throw std::out_of_range("Maximum of an empty Vector.");
+            }
+            return detail::kernels<T>().max(detail::data(v), v.size());
+        }
+
+        template <typename T, typename C, typename A, typename G>
+        uint64_t find(const Vector<T, C, A, G>& v, T value) {
+            //
+            // Index of the first element equal to 'value', or size() if there is none
+            //
+            return detail::kernels<T>().find(detail::data(v), v.size(), value);
+        }
+
+        template <typename T, typename C, typename A, typename G, typename C2, typename A2, typename G2,
+            typename C3, typename A3, typename G3>
+        void add(const Vector<T, C, A, G>& a, const Vector<T, C2, A2, G2>& b, Vector<T, C3, A3, G3>& out) {
+            //
+            // out[k] = a[k] + b[k]. 'out' is resized to the size of the operands (which
+            // invalidates its iterators unless the size stays the same) and may be one of them.
+            //
+            detail::check_sizes(a.size(), b.size());
+            out.resize(a.size());
+            detail::kernels<T>().add(detail::data(a), detail::data(b), detail::data(out), a.size());
+        }
+
+        template <typename T, typename C, typename A, typename G, typename C2, typename A2, typename G2,
+            typename C3, typename A3, typename G3>
+        void sub(const Vector<T, C, A, G>& a, const Vector<T, C2, A2, G2>& b, Vector<T, C3, A3, G3>& out) {
+            //
+            // out[k] = a[k] - b[k], see add
+            //
+            detail::check_sizes(a.size(), b.size());
+            out.resize(a.size());
+            detail::kernels<T>().sub(detail::data(a), detail::data(b), detail::data(out), a.size());
+        }
+
+        template <typename T, typename C, typename A, typename G, typename C2, typename A2, typename G2,
+            typename C3, typename A3, typename G3>
+        void mul(const Vector<T, C, A, G>& a, const Vector<T, C2, A2, G2>& b, Vector<T, C3, A3, G3>& out) {
+            //
+            // out[k] = a[k] * b[k], see add
+            //
+            detail::check_sizes(a.size(), b.size());
+            out.resize(a.size());
+            detail::kernels<T>().mul(detail::data(a), detail::data(b), detail::data(out), a.size());
+        }
+
+        //
+        // The same kernels over contiguous spans, e.g. the columns of a SoAVector
+        //
+        template <typename T>
+        typename detail::span_element<T>::type sum(Span<T> s) {
+            return detail::kernels<typename detail::span_element<T>::type>().sum(s.data(), s.size());
+        }
+
+        template <typename T, typename U>
+        typename detail::span_element<T>::type dot(Span<T> x, Span<U> y) {
+            static_assert(std::is_same<typename detail::span_element<T>::type, typename detail::span_element<U>::type>::value,
+                "dot needs spans of the same element type");
+            detail::check_sizes(x.size(), y.size());
+            return detail::kernels<typename detail::span_element<T>::type>().dot(x.data(), y.data(), x.size());
+        }
+
+        template <typename T, typename U>
+        void axpy(typename detail::span_element<T>::type a, Span<T> x, Span<U> y) {
+            static_assert(std::is_same<typename detail::span_element<T>::type, U>::value,
+                "axpy needs a writable span of the same element type");
+            detail::check_sizes(x.size(), y.size());
+            detail::kernels<U>().axpy(a, x.data(), y.data(), x.size());
+        }
+
+        template <typename T>
+        typename detail::span_element<T>::type min(Span<T> s) {
+            if (s.size() == 0) {
+                throw std::out_of_range("Minimum of an empty Span.");
+            }
+            return detail::kernels<typename detail::span_element<T>::type>().min(s.data(), s.size());
+        }
+
+        template <typename T>
+        typename detail::span_element<T>::type max(Span<T> s) {
+            if (s.size() == 0) {
+                throw std::out_of_range("Maximum of an empty Span.");
+            }
+            return detail::kernels<typename detail::span_element<T>::type>().max(s.data(), s.size());
+        }
+
+        template <typename T>
+        uint64_t find(Span<T> s, typename detail::span_element<T>::type value) {
+            return detail::kernels<typename detail::span_element<T>::type>().find(s.data(), s.size(), value);
+        }
+    }
+}
+
+#endif
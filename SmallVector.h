@@ -0,0 +1,197 @@
+#ifndef _SMALL_VECTOR_H_
+#define _SMALL_VECTOR_H_
+
+#include "Vector.h"
+
+namespace epl
+{
+    template <typename T, uint64_t N, typename Checking = default_checking, typename Alloc = std::allocator<T>,
+        typename Growth = growth::doubling>
+    class SmallVector : public Vector<T, Checking, Alloc, Growth> {
+        typedef Vector<T, Checking, Alloc, Growth> base;
+        typedef std::allocator_traits<Alloc> alloc_traits;
+
+        static_assert(N > 0, "SmallVector needs room for at least one inline element");
+
+    public:
+        //
+        // A Vector that keeps up to N elements inside the object itself. It has the
+        // same double-ended layout, iterators and control block semantics as Vector;
+        // the only difference is that the buffer starts out as inline storage, so a
+        // vector that never grows past N elements (and is never iterated with checked
+        // iterators) performs no heap allocation at all. Growing past N moves the
+        // elements to a heap buffer exactly like a regular reallocation.
+        //
+        SmallVector(void) : base(inline_buffer(), N, Alloc()) {}
+
+        explicit SmallVector(const Alloc& allocator) : base(inline_buffer(), N, allocator) {}
+
+        explicit SmallVector(uint64_t n, const Alloc& allocator = Alloc()) : base(inline_buffer(), N, allocator) {
+            //
+            // 'n' value initialized elements, inline if they fit
+            //
+            if (n > N) {
+                this->alloc(n);
+            }
+            for (uint64_t k = 0; k < n; k++) {
+                new (this->_buffer + k) T{};
+            }
+            this->_back = this->_buffer + n;
+            this->_length = n;
+        }
+
+        SmallVector(std::initializer_list<T> init_list, const Alloc& allocator = Alloc()) : base(inline_buffer(), N, allocator) {
+            uint64_t n = init_list.end() - init_list.begin();
+            if (n > N) {
+                this->alloc(n);
+            }
+            for (auto iter = init_list.begin(); iter != init_list.end(); iter++) {
+                new (this->_back) T{ *iter };
+                this->_back++;
+            }
+            this->_length = n;
+        }
+
+        SmallVector(const SmallVector& other) :
+            base(inline_buffer(), N, alloc_traits::select_on_container_copy_construction(other.get_allocator())) {
+            copy_from(other);
+        }
+
+        SmallVector(SmallVector&& other) : base(inline_buffer(), N, other.get_allocator()) {
+            move_from(other);
+        }
+
+        SmallVector& operator=(const SmallVector& other) {
+            if (this != &other) {
+                this->destroy(base::CtrlBlk::COPY_ASSIGN);
+                if constexpr (alloc_traits::propagate_on_container_copy_assignment::value) {
+                    this->_alloc = other._alloc;
+                }
+                copy_from(other);
+            }
+            return *this;
+        }
+
+        SmallVector& operator=(SmallVector&& other) {
+            if (this != &other) {
+                this->destroy(base::CtrlBlk::MOVE_ASSIGN);
+                if constexpr (alloc_traits::propagate_on_container_move_assignment::value) {
+                    this->_alloc = other._alloc;
+                }
+                move_from(other);
+            }
+            return *this;
+        }
+
+        bool is_small(void) const {
+            //
+            // True while the elements still live in the inline storage
+            //
+            return this->is_inline();
+        }
+
+        static uint64_t inline_capacity(void) {
+            return N;
+        }
+
+    private:
+        alignas(T) unsigned char _storage[N * sizeof(T)];
+
+        T* inline_buffer(void) {
+            return reinterpret_cast<T*>(_storage);
+        }
+
+        void reset_to_inline(void) {
+            this->_buffer = inline_buffer();
+            this->_buffer_end = this->_buffer + N;
+            this->_front = this->_buffer;
+            this->_back = this->_buffer;
+            this->_length = 0;
+        }
+
+        void drop_ctrlBlk(void) {
+            //
+            // Lets go of the (unused) control block a freshly constructed vector may
+            // start out with, before it is replaced
+            //
+            if (this->_ctrlBlk != nullptr) {
+                base::CtrlBlk::abandon(this->_ctrlBlk);
+                this->_ctrlBlk = nullptr;
+            }
+        }
+
+        void copy_from(const SmallVector& other) {
+            //
+            // Expects this vector to hold no elements and no heap buffer. Copies that
+            // fit are packed at the start of the inline storage; larger ones get a heap
+            // buffer with the same layout as the rhs, just like Vector::copy.
+            //
+            drop_ctrlBlk();
+            if (other._length <= N) {
+                reset_to_inline();
+                this->_ctrlBlk = this->fresh_ctrlBlk();
+                for (uint64_t k = 0; k < other._length; k++) {
+                    new (this->_back) T{ other._front[k] };
+                    this->_back++;
+                }
+                this->_length = other._length;
+            }
+            else {
+                this->copy(other);
+            }
+        }
+
+        void move_from(SmallVector& other) {
+            //
+            // Expects this vector to hold no elements and no heap buffer, and its allocator
+            // to be settled already. A heap buffer of the rhs is simply adopted together
+            // with its control block, so iterators stay valid, and the rhs ends up empty
+            // on its inline storage. Inline elements have to be relocated into our own
+            // storage, which invalidates the iterators of the rhs and also leaves it
+            // empty.
+            //
+            // A heap buffer from an allocator that differs from ours (and does not
+            // propagate) cannot be adopted, since we would later free it through the
+            // wrong allocator. As in Vector's move assignment the elements are then moved
+            // one by one into our own memory, leaving the rhs holding moved-from elements.
+            //
+            drop_ctrlBlk();
+            if (!other.is_inline() && !(this->_alloc == other._alloc)) {
+                if (other._length <= N) {
+                    reset_to_inline();
+                    this->_ctrlBlk = this->fresh_ctrlBlk();
+                    for (uint64_t k = 0; k < other._length; k++) {
+                        new (this->_back) T{ std::move(other._front[k]) };
+                        this->_back++;
+                        this->_length++;
+                    }
+                }
+                else {
+                    this->move_elements(other);
+                }
+            }
+            else if (!other.is_inline()) {
+                this->_buffer = other._buffer;
+                this->_buffer_end = other._buffer_end;
+                this->_front = other._front;
+                this->_back = other._back;
+                this->_length = other._length;
+                this->_ctrlBlk = other._ctrlBlk;
+                other._ctrlBlk = other.fresh_ctrlBlk();
+                other.reset_to_inline();
+            }
+            else {
+                reset_to_inline();
+                this->_ctrlBlk = this->fresh_ctrlBlk();
+                this->_front = this->_buffer + (other._front - other._buffer);
+                this->_back = this->_front + other._length;
+                this->_length = other._length;
+                base::relocate(this->_front, other._front, other._length);
+                other.reset_to_inline();
+                other.update_ctrlBlk(base::CtrlBlk::MOVE_ASSIGN, nullptr, nullptr, nullptr);
+            }
+        }
+    };
+}
+
+#endif
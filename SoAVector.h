@@ -0,0 +1,309 @@
+#ifndef _SOA_VECTOR_H_
+#define _SOA_VECTOR_H_
+
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+#include "Span.h"
+#include "Vector.h"
+
+namespace epl
+{
+    template <typename... Ts>
+    class SoAVector {
+        static_assert(sizeof...(Ts) > 0, "A SoAVector needs at least one column");
+
+    public:
+        //
+        // Structure of arrays: a sequence of rows (Ts...) where each field lives in a
+        // column of its own. Every column is a double-ended Vector, and the columns are
+        // always pushed and popped together, so row k is element k of every column. A
+        // scan over one field only touches that field's bytes; column<I>() hands the
+        // column out as a contiguous Span (e.g. for the epl::simd kernels).
+        //
+        // The columns use checking::none; the container itself range checks row
+        // access, and its row iterators range check dereferences.
+        //
+        static const size_t columns = sizeof...(Ts);
+
+        template <size_t I>
+        using column_type = typename std::tuple_element<I, std::tuple<Ts...>>::type;
+
+        template <size_t I>
+        using column_vector_type = Vector<column_type<I>, checking::none>;
+
+        typedef std::tuple<Ts&...> reference;
+        typedef std::tuple<const Ts&...> const_reference;
+
+        template <bool Const>
+        struct row_iterator {
+            //
+            // Proxy iterator: dereferencing yields a tuple of references to the fields of
+            // one row, so 'for (auto [a, b] : soa)' binds straight to the column cells.
+            // It holds the container and a row index, so it stays usable across
+            // reallocations, but a push or pop at the front shifts the row it refers to.
+            //
+            typedef typename std::conditional<Const, const SoAVector, SoAVector>::type owner_type;
+
+            using value_type = std::tuple<Ts...>;
+            using iterator_category = std::random_access_iterator_tag;
+            using reference = typename std::conditional<Const, const_reference, SoAVector::reference>::type;
+            using pointer = void;
+            using difference_type = int64_t;
+
+            row_iterator(void) : _owner(nullptr), _index(0) {}
+
+            row_iterator(owner_type* owner, uint64_t index) : _owner(owner), _index(index) {}
+
+            template <bool C = Const, typename = typename std::enable_if<C>::type>
+            row_iterator(const row_iterator<false>& other) : _owner(other._owner), _index(other._index) {}
+
+            reference operator*(void) const {
+                return (*_owner)[_index];
+            }
+
+            bool operator==(const row_iterator& rhs) const {
+                return _index == rhs._index;
+            }
+
+            bool operator!=(const row_iterator& rhs) const {
+                return _index != rhs._index;
+            }
+
+            reference operator[](int64_t offset) const {
+                return (*_owner)[_index + offset];
+            }
+
+            bool operator<(const row_iterator& rhs) const {
+                return _index < rhs._index;
+            }
+
+            bool operator>(const row_iterator& rhs) const {
+                return _index > rhs._index;
+            }
+
+            bool operator<=(const row_iterator& rhs) const {
+                return _index <= rhs._index;
+            }
+
+            bool operator>=(const row_iterator& rhs) const {
+                return _index >= rhs._index;
+            }
+
+            int64_t operator-(const row_iterator& rhs) const {
+                return (int64_t)(_index - rhs._index);
+            }
+
+            row_iterator operator+(int64_t offset) const {
+                return row_iterator(_owner, _index + offset);
+            }
+
+            row_iterator operator-(int64_t offset) const {
+                return row_iterator(_owner, _index - offset);
+            }
+
+            friend row_iterator operator+(int64_t offset, const row_iterator& it) {
+                return it + offset;
+            }
+
+            row_iterator& operator+=(int64_t offset) {
+                _index += offset;
+                return *this;
+            }
+
+            row_iterator& operator-=(int64_t offset) {
+                _index -= offset;
+                return *this;
+            }
+
+            row_iterator& operator++(void) {
+                _index++;
+                return *this;
+            }
+
+            row_iterator& operator--(void) {
+                _index--;
+                return *this;
+            }
+
+            row_iterator operator++(int) {
+                row_iterator old = *this;
+                _index++;
+                return old;
+            }
+
+            row_iterator operator--(int) {
+                row_iterator old = *this;
+                _index--;
+                return old;
+            }
+
+            owner_type* _owner;
+            uint64_t _index;
+        };
+
+        typedef row_iterator<false> iterator;
+        typedef row_iterator<true> const_iterator;
+
+        SoAVector(void) {}
+
+        uint64_t size(void) const {
+            return std::get<0>(_columns).size();
+        }
+
+        void push_back(const Ts&... vals) {
+            push_back_from<0>(std::forward_as_tuple(vals...));
+        }
+
+        void push_back(Ts&&... vals) {
+            push_back_from<0>(std::forward_as_tuple(std::move(vals)...));
+        }
+
+        void push_front(const Ts&... vals) {
+            push_front_from<0>(std::forward_as_tuple(vals...));
+        }
+
+        void push_front(Ts&&... vals) {
+            push_front_from<0>(std::forward_as_tuple(std::move(vals)...));
+        }
+
+        void pop_back(void) {
+            std::apply([](auto&... column) { (column.pop_back(), ...); }, _columns);
+        }
+
+        void pop_front(void) {
+            std::apply([](auto&... column) { (column.pop_front(), ...); }, _columns);
+        }
+
+        void reserve(uint64_t n) {
+            //
+            // Room for 'n' rows from the current front in every column
+            //
+            std::apply([n](auto&... column) { (column.reserve(n), ...); }, _columns);
+        }
+
+        void reserve_front(uint64_t n) {
+            std::apply([n](auto&... column) { (column.reserve_front(n), ...); }, _columns);
+        }
+
+        reference operator[](uint64_t k) {
+            //
+            // The fields of row 'k'. Throws std::out_of_range if 'k' is not a row.
+            //
+            check_row(k);
+            return row(k, std::index_sequence_for<Ts...>());
+        }
+
+        const_reference operator[](uint64_t k) const {
+            check_row(k);
+            return row(k, std::index_sequence_for<Ts...>());
+        }
+
+        template <size_t I>
+        column_type<I>& get(uint64_t k) {
+            //
+            // Field I of row 'k', range checked
+            //
+            return std::get<I>(_columns)[k];
+        }
+
+        template <size_t I>
+        const column_type<I>& get(uint64_t k) const {
+            return std::get<I>(_columns)[k];
+        }
+
+        template <size_t I>
+        Span<column_type<I>> column(void) {
+            //
+            // Column I as a contiguous span. Valid until the next push or pop.
+            //
+            return Span<column_type<I>>(detail::vector_access::front(std::get<I>(_columns)), size());
+        }
+
+        template <size_t I>
+        Span<const column_type<I>> column(void) const {
+            return Span<const column_type<I>>(detail::vector_access::front(std::get<I>(_columns)), size());
+        }
+
+        template <size_t I>
+        const column_vector_type<I>& column_vector(void) const {
+            //
+            // Column I as the Vector it is stored in. Read only, since the columns must
+            // stay the same length.
+            //
+            return std::get<I>(_columns);
+        }
+
+        iterator begin(void) {
+            return iterator(this, 0);
+        }
+
+        iterator end(void) {
+            return iterator(this, size());
+        }
+
+        const_iterator begin(void) const {
+            return const_iterator(this, 0);
+        }
+
+        const_iterator end(void) const {
+            return const_iterator(this, size());
+        }
+
+    private:
+        std::tuple<Vector<Ts, checking::none>...> _columns;
+
+        void check_row(uint64_t k) const {
+            if (k >= size()) {
+                throw std::out_of_range("Row Index out of Range.");
+            }
+        }
+
+        template <size_t... Is>
+        reference row(uint64_t k, std::index_sequence<Is...>) {
+            return reference(detail::vector_access::front(std::get<Is>(_columns))[k]...);
+        }
+
+        template <size_t... Is>
+        const_reference row(uint64_t k, std::index_sequence<Is...>) const {
+            return const_reference(detail::vector_access::front(std::get<Is>(_columns))[k]...);
+        }
+
+        template <size_t I, typename Tuple>
+        void push_back_from(Tuple&& vals) {
+            //
+            // Pushes the fields one column at a time. If a column throws, the columns
+            // already pushed are popped again, so all columns keep the same length.
+            //
+            if constexpr (I < columns) {
+                std::get<I>(_columns).push_back(std::get<I>(std::move(vals)));
+                try {
+                    push_back_from<I + 1>(std::move(vals));
+                }
+                catch (...) {
+                    std::get<I>(_columns).pop_back();
+                    throw;
+                }
+            }
+        }
+
+        template <size_t I, typename Tuple>
+        void push_front_from(Tuple&& vals) {
+            if constexpr (I < columns) {
+                std::get<I>(_columns).push_front(std::get<I>(std::move(vals)));
+                try {
+                    push_front_from<I + 1>(std::move(vals));
+                }
+                catch (...) {
+                    std::get<I>(_columns).pop_front();
+                    throw;
+                }
+            }
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,621 @@
+#ifndef _SORT_H_
+#define _SORT_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "Parallel.h"
+#include "ThreadPool.h"
+#include "Vector.h"
+
+namespace epl
+{
+    //
+    // Sorting of epl::Vector. Going through the checked iterators costs a validation on
+    // every step, so these work on the contiguous run of cells [_front, _back) instead,
+    // with raw pointers, and report the reordering to the control block once at the end:
+    // iterators handed out before the sort then throw invalid_iterator (MILD). As with
+    // epl::parallel, every chunk of work first checks (with checking::full or
+    // checking::concurrent) that the vector has not been changed under the sort.
+    //
+    // Two algorithms are used:
+    //
+    //   radix sort - for integral and floating point elements, and for sort_by_key with
+    //                such a key. LSD, one byte per pass, and stable. Passes whose byte is
+    //                the same for every element are skipped, so small keys in wide types
+    //                take few passes. Each pass counts and scatters in parallel chunks.
+    //   merge sort - for everything else. Every chunk is sorted on its own (std::sort,
+    //                or std::stable_sort for stable_sort) and the sorted runs are merged
+    //                pairwise; each merge is split by output position (merge path), so
+    //                the last merges are as parallel as the first.
+    //
+    // Both need a scratch buffer as large as the vector. Vectors too small for either
+    // (below radix_threshold elements, or a single chunk of the merge sort) are handed to
+    // std::sort or std::stable_sort directly.
+    //
+    // Floating point keys are ordered by their bits: -0.0 comes before 0.0, and NaNs go
+    // to the ends according to their sign bit (std::sort leaves inputs with NaNs unsorted).
+    // Below radix_threshold the comparison sort compares those same bits, so the order
+    // does not depend on the size of the vector.
+    // If the comparison or the key function throws, the elements are moved back into the
+    // vector in an unspecified order before the exception is passed on. The one exception
+    // is a throw from within the std::sort or std::stable_sort of a chunk, which may leave
+    // the element it was moving in a moved-from state, as it does on its own.
+    //
+    static const uint64_t radix_threshold = 2048;
+
+    namespace detail
+    {
+        template <typename K, typename = void>
+        struct radix_key {
+            static const bool enabled = false;
+        };
+
+        template <typename K>
+        struct radix_key<K, typename std::enable_if<std::is_integral<K>::value && !std::is_same<K, bool>::value>::type> {
+            //
+            // Signed keys flip the sign bit, so that negative values order first
+            //
+            static const bool enabled = true;
+            typedef typename std::make_unsigned<K>::type bits_type;
+
+            static bits_type bits(K k) {
+                if constexpr (std::is_signed<K>::value) {
+                    return (bits_type)k ^ ((bits_type)1 << (sizeof(K) * 8 - 1));
+                }
+                return (bits_type)k;
+            }
+        };
+
+        template <>
+        struct radix_key<bool> {
+            static const bool enabled = true;
+            typedef uint8_t bits_type;
+
+            static bits_type bits(bool k) {
+                return k ? 1 : 0;
+            }
+        };
+
+        template <typename K, typename U>
+        struct radix_float {
+            //
+            // Positive values get the sign bit set, negative ones all their bits flipped,
+            // which orders the bit patterns like the values
+            //
+            static const bool enabled = true;
+            typedef U bits_type;
+
+            static bits_type bits(K k) {
+                U u;
+                std::memcpy(&u, &k, sizeof(U));
+                U sign = (U)1 << (sizeof(U) * 8 - 1);
+                return (u & sign) ? ~u : (u | sign);
+            }
+        };
+
+        template <>
+        struct radix_key<float> : radix_float<float, uint32_t> {};
+
+        template <>
+        struct radix_key<double> : radix_float<double, uint64_t> {};
+
+        template <typename T>
+        class scratch_buffer {
+        public:
+            //
+            // Uninitialized room for n elements. After construct_from() the cells hold
+            // live elements, which are destroyed along with the buffer.
+            //
+            scratch_buffer(uint64_t n) : _data(static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))))), _size(n), _constructed(false) {}
+
+            scratch_buffer(const scratch_buffer&) = delete;
+            scratch_buffer& operator=(const scratch_buffer&) = delete;
+
+            ~scratch_buffer() {
+                if (_constructed) {
+                    std::destroy(_data, _data + _size);
+                }
+                ::operator delete(_data, _size * sizeof(T), std::align_val_t(alignof(T)));
+            }
+
+            void construct_from(T* init) {
+                std::uninitialized_move(init, init + _size, _data);
+                _constructed = true;
+            }
+
+            T* get(void) const {
+                return _data;
+            }
+
+        private:
+            T* _data;
+            uint64_t _size;
+            bool _constructed;
+        };
+
+        template <typename T>
+        inline void relocate_item(T* dest, const T* src) {
+            std::memcpy(static_cast<void*>(dest), static_cast<const void*>(src), sizeof(T));
+        }
+
+        static const unsigned radix_buckets = 256;
+
+        template <typename Item, typename Bits>
+        void scatter(const Item* first, const Item* last, Item* dest, const uint64_t* offsets, Bits& bits, unsigned shift) {
+            //
+            // Moves the items of one chunk to their buckets. Writing to 256 places at once
+            // thrashes the TLB and the store buffers, so small items are gathered per bucket
+            // in a cache line sized block on the stack first, and written out a full block
+            // at a time.
+            //
+            uint64_t o[radix_buckets];
+            std::memcpy(o, offsets, sizeof(o));
+            const unsigned block = sizeof(Item) < cache_line_size ? (unsigned)(cache_line_size / sizeof(Item)) : 1;
+            if constexpr (block == 1) {
+                for (const Item* p = first; p != last; ++p) {
+                    relocate_item(dest + o[(unsigned)((bits(*p) >> shift) & 0xff)]++, p);
+                }
+            }
+            else {
+                alignas(cache_line_size) unsigned char storage[radix_buckets * block * sizeof(Item)];
+                Item* blocks = reinterpret_cast<Item*>(storage);
+                unsigned fill[radix_buckets] = {};
+                for (const Item* p = first; p != last; ++p) {
+                    unsigned bucket = (unsigned)((bits(*p) >> shift) & 0xff);
+                    relocate_item(blocks + bucket * block + fill[bucket], p);
+                    if (++fill[bucket] == block) {
+                        std::memcpy(static_cast<void*>(dest + o[bucket]), static_cast<const void*>(blocks + bucket * block), block * sizeof(Item));
+                        o[bucket] += block;
+                        fill[bucket] = 0;
+                    }
+                }
+                for (unsigned bucket = 0; bucket < radix_buckets; bucket++) {
+                    std::memcpy(static_cast<void*>(dest + o[bucket]), static_cast<const void*>(blocks + bucket * block), fill[bucket] * sizeof(Item));
+                }
+            }
+        }
+
+        template <typename Item, typename Bits, typename Guard>
+        void radix_sort(Item* data, uint64_t n, Bits bits, const Guard& guard, ThreadPool& pool) {
+            //
+            // LSD radix sort of n trivially copyable items on the bytes of bits(item).
+            // The items are scattered back and forth between 'data' and a scratch buffer,
+            // one pass per byte, and copied back at the end after an odd number of passes.
+            //
+            typedef decltype(bits(*data)) bits_type;
+            const unsigned digits = sizeof(bits_type);
+            uint64_t grain = parallel::detail::grain_for(n, pool);
+            uint64_t chunks = (n - 1) / grain + 1;
+            //
+            // counts[(chunk * digits + digit) * radix_buckets + bucket]: the first pass
+            // counts every digit at once, which tells which passes can be skipped
+            //
+            std::unique_ptr<uint64_t[]> counts(new uint64_t[chunks * digits * radix_buckets]());
+            pool.parallel_for(0, n, grain, [&](uint64_t lo, uint64_t hi) {
+                guard.check();
+                uint64_t* c = &counts[lo / grain * digits * radix_buckets];
+                for (uint64_t k = lo; k < hi; k++) {
+                    bits_type b = bits(data[k]);
+                    for (unsigned d = 0; d < digits; d++) {
+                        c[d * radix_buckets + (unsigned)((b >> (d * 8)) & 0xff)]++;
+                    }
+                }
+            });
+
+            scratch_buffer<Item> scratch(n);
+            Item* src = data;
+            Item* dest = scratch.get();
+            std::unique_ptr<uint64_t[]> offsets(new uint64_t[chunks * radix_buckets]);
+            //
+            // The per chunk counts describe the items as they were; after the first
+            // scatter they have to be taken again for every pass
+            //
+            bool counted = true;
+            try {
+                for (unsigned d = 0; d < digits; d++) {
+                    bool trivial = false;
+                    for (unsigned bucket = 0; bucket < radix_buckets && !trivial; bucket++) {
+                        uint64_t total = 0;
+                        for (uint64_t c = 0; c < chunks; c++) {
+                            total += counts[(c * digits + d) * radix_buckets + bucket];
+                        }
+                        trivial = total == n;
+                    }
+                    if (trivial) {
+                        continue;
+                    }
+                    if (!counted) {
+                        pool.parallel_for(0, n, grain, [&](uint64_t lo, uint64_t hi) {
+                            guard.check();
+                            uint64_t* c = &counts[(lo / grain * digits + d) * radix_buckets];
+                            std::fill(c, c + radix_buckets, 0);
+                            for (uint64_t k = lo; k < hi; k++) {
+                                c[(unsigned)((bits(src[k]) >> (d * 8)) & 0xff)]++;
+                            }
+                        });
+                    }
+                    counted = false;
+                    //
+                    // Bucket by bucket, the chunks write after each other, which keeps the sort stable
+                    //
+                    uint64_t at = 0;
+                    for (unsigned bucket = 0; bucket < radix_buckets; bucket++) {
+                        for (uint64_t c = 0; c < chunks; c++) {
+                            offsets[c * radix_buckets + bucket] = at;
+                            at += counts[(c * digits + d) * radix_buckets + bucket];
+                        }
+                    }
+                    pool.parallel_for(0, n, grain, [&](uint64_t lo, uint64_t hi) {
+                        guard.check();
+                        scatter(src + lo, src + hi, dest, &offsets[lo / grain * radix_buckets], bits, d * 8);
+                    });
+                    std::swap(src, dest);
+                }
+            }
+            catch (...) {
+                //
+                // A pass only reads from 'src', so all items are still there
+                //
+                if (src != data) {
+                    std::memcpy(static_cast<void*>(data), static_cast<const void*>(src), n * sizeof(Item));
+                }
+                throw;
+            }
+            if (src != data) {
+                pool.parallel_for(0, n, grain, [&](uint64_t lo, uint64_t hi) {
+                    std::memcpy(static_cast<void*>(data + lo), static_cast<const void*>(src + lo), (hi - lo) * sizeof(Item));
+                });
+            }
+        }
+
+        template <typename T, typename Key, typename Guard>
+        void radix_sort_by(T* data, uint64_t n, Key key, const Guard& guard, ThreadPool& pool) {
+            //
+            // Trivially copyable elements are scattered themselves. Others are sorted as
+            // (key bits, index) pairs, and then moved into place following the cycles of
+            // the permutation, each element being moved once; a sort that stops half way
+            // then still leaves every element in exactly one cell.
+            //
+            typedef radix_key<typename std::decay<decltype(key(*data))>::type> traits;
+            if constexpr (std::is_trivially_copyable<T>::value) {
+                radix_sort(data, n, [&key](const T& x) { return traits::bits(key(x)); }, guard, pool);
+            }
+            else {
+                struct keyed {
+                    typename traits::bits_type _bits;
+                    uint64_t _index;
+                };
+                std::unique_ptr<keyed[]> items(new keyed[n]);
+                pool.parallel_for(0, n, parallel::detail::grain_for(n, pool), [&](uint64_t lo, uint64_t hi) {
+                    guard.check();
+                    for (uint64_t k = lo; k < hi; k++) {
+                        items[k]._bits = traits::bits(key(data[k]));
+                        items[k]._index = k;
+                    }
+                });
+                radix_sort(items.get(), n, [](const keyed& x) { return x._bits; }, guard, pool);
+                guard.check();
+                for (uint64_t k = 0; k < n; k++) {
+                    if (items[k]._index == k) {
+                        continue;
+                    }
+                    T hole(std::move(data[k]));
+                    uint64_t at = k;
+                    while (items[at]._index != k) {
+                        uint64_t from = items[at]._index;
+                        data[at] = std::move(data[from]);
+                        items[at]._index = at;
+                        at = from;
+                    }
+                    data[at] = std::move(hole);
+                    items[at]._index = at;
+                }
+            }
+        }
+
+        template <typename T, typename Compare>
+        uint64_t merge_split(const T* a, uint64_t m, const T* b, uint64_t n, uint64_t k, Compare& comp) {
+            //
+            // Number of elements of 'a' among the first k outputs of the stable merge of
+            // a[0, m) and b[0, n) (the merge path). Equal elements are taken from 'a' first.
+            //
+            uint64_t lo = k > n ? k - n : 0;
+            uint64_t hi = k < m ? k : m;
+            while (lo < hi) {
+                uint64_t i = lo + (hi - lo) / 2;
+                if (!comp(b[k - i - 1], a[i])) {
+                    lo = i + 1;
+                }
+                else {
+                    hi = i;
+                }
+            }
+            return lo;
+        }
+
+        template <typename T>
+        T* move_runs(T* a, T* a_end, T* b, T* b_end, T* out) {
+            out = std::move(a, a_end, out);
+            return std::move(b, b_end, out);
+        }
+
+        template <typename T, typename Compare>
+        void merge_runs(T* a, T* a_end, T* b, T* b_end, T* out, Compare& comp) {
+            //
+            // std::merge of the moved elements of two runs. If comp throws, the elements
+            // not merged yet are moved after the merged ones before the exception is
+            // passed on, so that 'out' receives every element of both runs either way.
+            //
+            try {
+                while (a != a_end && b != b_end) {
+                    if (comp(*b, *a)) {
+                        *out++ = std::move(*b++);
+                    }
+                    else {
+                        *out++ = std::move(*a++);
+                    }
+                }
+            }
+            catch (...) {
+                move_runs(a, a_end, b, b_end, out);
+                throw;
+            }
+            move_runs(a, a_end, b, b_end, out);
+        }
+
+        template <bool Stable, typename T, typename Compare, typename Guard>
+        void merge_sort(T* data, uint64_t n, Compare comp, const Guard& guard, ThreadPool& pool) {
+            uint64_t grain = parallel::detail::grain_for(n, pool);
+            if (n <= grain) {
+                guard.check();
+                if constexpr (Stable) {
+                    std::stable_sort(data, data + n, comp);
+                }
+                else {
+                    std::sort(data, data + n, comp);
+                }
+                return;
+            }
+            pool.parallel_for(0, n, grain, [&](uint64_t lo, uint64_t hi) {
+                guard.check();
+                if constexpr (Stable) {
+                    std::stable_sort(data + lo, data + hi, comp);
+                }
+                else {
+                    std::sort(data + lo, data + hi, comp);
+                }
+            });
+            //
+            // The merges move the elements back and forth between 'data' and the scratch
+            // buffer. Unless T is trivially copyable the elements are first moved into the
+            // scratch buffer, so that both sides always hold live elements.
+            //
+            scratch_buffer<T> scratch(n);
+            T* src = data;
+            T* dest = scratch.get();
+            if constexpr (!std::is_trivially_copyable<T>::value) {
+                scratch.construct_from(data);
+                std::swap(src, dest);
+            }
+            //
+            // splits[c]: where the output position c * grain falls in the pair of runs it
+            // belongs to, as the number of elements taken from the first run. They are
+            // all found before the merges start, since the merges move from the elements
+            // the search compares.
+            //
+            uint64_t chunks = (n - 1) / grain + 1;
+            std::unique_ptr<uint64_t[]> splits(new uint64_t[chunks]);
+            //
+            // merged[c]: chunk c of the current pass has run, and its output range of
+            // 'dest' holds all of its elements
+            //
+            std::unique_ptr<bool[]> merged(new bool[chunks]);
+            auto give_back = [data, n](T* from) {
+                //
+                // Puts the elements back into the vector when the sort is abandoned
+                //
+                if (from != data) {
+                    std::move(from, from + n, data);
+                }
+            };
+            for (uint64_t width = grain; width < n; width *= 2) {
+                try {
+                    for (uint64_t c = 0; c < chunks; c++) {
+                        uint64_t at = c * grain;
+                        uint64_t base = at / (2 * width) * (2 * width);
+                        uint64_t mid = n - base < width ? n : base + width;
+                        uint64_t end = n - base < 2 * width ? n : base + 2 * width;
+                        splits[c] = merge_split(src + base, mid - base, src + mid, end - mid, at - base, comp);
+                    }
+                }
+                catch (...) {
+                    give_back(src);
+                    throw;
+                }
+                auto merge_chunk = [&](uint64_t lo, uint64_t hi, bool compare) {
+                    //
+                    // [lo, hi) of the output may span the ends of several pairs of runs.
+                    // Once a merge has thrown, the remaining pairs are only moved over.
+                    //
+                    std::exception_ptr error;
+                    for (uint64_t base = lo / (2 * width) * (2 * width); base < hi; base += 2 * width) {
+                        uint64_t mid = n - base < width ? n : base + width;
+                        uint64_t end = n - base < 2 * width ? n : base + 2 * width;
+                        uint64_t first = lo > base ? lo - base : 0;
+                        uint64_t last = hi < end ? hi - base : end - base;
+                        uint64_t i0 = lo > base ? splits[lo / grain] : 0;
+                        uint64_t i1 = hi < end ? splits[hi / grain] : mid - base;
+                        T* a = src + base + i0;
+                        T* a_end = src + base + i1;
+                        T* b = src + mid + (first - i0);
+                        T* b_end = src + mid + (last - i1);
+                        if (compare && !error) {
+                            try {
+                                merge_runs(a, a_end, b, b_end, dest + base + first, comp);
+                            }
+                            catch (...) {
+                                error = std::current_exception();
+                            }
+                        }
+                        else {
+                            move_runs(a, a_end, b, b_end, dest + base + first);
+                        }
+                    }
+                    merged[lo / grain] = true;
+                    if (error) {
+                        std::rethrow_exception(error);
+                    }
+                };
+                std::fill(merged.get(), merged.get() + chunks, false);
+                try {
+                    pool.parallel_for(0, n, grain, [&](uint64_t lo, uint64_t hi) {
+                        guard.check();
+                        merge_chunk(lo, hi, true);
+                    });
+                }
+                catch (...) {
+                    //
+                    // The chunks that never ran still have their elements in 'src'
+                    //
+                    for (uint64_t c = 0; c < chunks; c++) {
+                        if (!merged[c]) {
+                            merge_chunk(c * grain, n - c * grain < grain ? n : c * grain + grain, false);
+                        }
+                    }
+                    give_back(dest);
+                    throw;
+                }
+                std::swap(src, dest);
+            }
+            if (src != data) {
+                pool.parallel_for(0, n, grain, [&](uint64_t lo, uint64_t hi) {
+                    std::move(src + lo, src + hi, data + lo);
+                });
+            }
+        }
+
+        template <bool Stable, typename T, typename C, typename A, typename G, typename Compare>
+        void comparison_sort(Vector<T, C, A, G>& v, Compare comp, ThreadPool& pool) {
+            typedef Vector<T, C, A, G> vector_type;
+            uint64_t n = v.size();
+            if (n < 2) {
+                return;
+            }
+            T* data = epl::detail::vector_access::front(v);
+            try {
+                parallel::detail::chunk_guard<vector_type> guard(v);
+                merge_sort<Stable>(data, n, comp, guard, pool);
+            }
+            catch (...) {
+                epl::detail::vector_access::rearranged(v);
+                throw;
+            }
+            epl::detail::vector_access::rearranged(v);
+        }
+
+        template <typename T, typename C, typename A, typename G, typename Key>
+        void key_sort(Vector<T, C, A, G>& v, Key key, ThreadPool& pool) {
+            //
+            // Stable sort on key(element); radix sort if the key allows it
+            //
+            typedef Vector<T, C, A, G> vector_type;
+            typedef typename std::decay<decltype(key(std::declval<const T&>()))>::type key_type;
+            uint64_t n = v.size();
+            if (n < 2) {
+                return;
+            }
+            T* data = epl::detail::vector_access::front(v);
+            auto comp = [&key](const T& a, const T& b) {
+                if constexpr (std::is_floating_point<key_type>::value && radix_key<key_type>::enabled) {
+                    return radix_key<key_type>::bits(key(a)) < radix_key<key_type>::bits(key(b));
+                }
+                else {
+                    return key(a) < key(b);
+                }
+            };
+            try {
+                parallel::detail::chunk_guard<vector_type> guard(v);
+                if (radix_key<key_type>::enabled && n >= radix_threshold) {
+                    if constexpr (radix_key<key_type>::enabled) {
+                        radix_sort_by(data, n, key, guard, pool);
+                    }
+                }
+                else {
+                    merge_sort<true>(data, n, comp, guard, pool);
+                }
+            }
+            catch (...) {
+                epl::detail::vector_access::rearranged(v);
+                throw;
+            }
+            epl::detail::vector_access::rearranged(v);
+        }
+
+        struct identity_key {
+            template <typename T>
+            const T& operator()(const T& x) const {
+                return x;
+            }
+        };
+    }
+
+    template <typename T, typename C, typename A, typename G>
+    void sort(Vector<T, C, A, G>& v, ThreadPool& pool = ThreadPool::instance()) {
+        //
+        // Sorts the elements in ascending order (operator<)
+        //
+        if constexpr (detail::radix_key<T>::enabled) {
+            detail::key_sort(v, detail::identity_key(), pool);
+        }
+        else {
+            detail::comparison_sort<false>(v, std::less<T>(), pool);
+        }
+    }
+
+    template <typename T, typename C, typename A, typename G, typename Compare>
+    void sort(Vector<T, C, A, G>& v, Compare comp, ThreadPool& pool = ThreadPool::instance()) {
+        //
+        // Sorts the elements so that comp(later, earlier) never holds
+        //
+        detail::comparison_sort<false>(v, comp, pool);
+    }
+
+    template <typename T, typename C, typename A, typename G>
+    void stable_sort(Vector<T, C, A, G>& v, ThreadPool& pool = ThreadPool::instance()) {
+        //
+        // Like sort, but keeps equal elements in their original order
+        //
+        if constexpr (detail::radix_key<T>::enabled) {
+            detail::key_sort(v, detail::identity_key(), pool);
+        }
+        else {
+            detail::comparison_sort<true>(v, std::less<T>(), pool);
+        }
+    }
+
+    template <typename T, typename C, typename A, typename G, typename Compare>
+    void stable_sort(Vector<T, C, A, G>& v, Compare comp, ThreadPool& pool = ThreadPool::instance()) {
+        detail::comparison_sort<true>(v, comp, pool);
+    }
+
+    template <typename T, typename C, typename A, typename G, typename Key>
+    void sort_by_key(Vector<T, C, A, G>& v, Key key, ThreadPool& pool = ThreadPool::instance()) {
+        //
+        // Stable sort on key(element), which is called concurrently and several times
+        // per element. An integral or floating point key is radix sorted; any other key
+        // is compared with operator<.
+        //
+        detail::key_sort(v, key, pool);
+    }
+}
+
+#endif
@@ -0,0 +1,76 @@
+#ifndef _SPAN_H_
+#define _SPAN_H_
+
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+namespace epl
+{
+    template <typename T>
+    class Span {
+    public:
+        //
+        // Non-owning view of 'length' contiguous elements starting at 'data', e.g. one
+        // column of a SoAVector. A Span knows nothing about the container it came from:
+        // it is a plain pointer pair and becomes dangling as soon as the container
+        // reallocates. Span<T> converts to Span<const T>.
+        //
+        typedef T element_type;
+        typedef typename std::remove_const<T>::type value_type;
+        typedef T* iterator;
+
+        Span(void) : _data(nullptr), _length(0) {}
+
+        Span(T* data, uint64_t length) : _data(data), _length(length) {}
+
+        template <typename U, typename = typename std::enable_if<std::is_convertible<U(*)[], T(*)[]>::value>::type>
+        Span(const Span<U>& other) : _data(other.data()), _length(other.size()) {}
+
+        T* data(void) const {
+            return _data;
+        }
+
+        uint64_t size(void) const {
+            return _length;
+        }
+
+        bool empty(void) const {
+            return _length == 0;
+        }
+
+        T& operator[](uint64_t k) const {
+            //
+            // Range checked, like Vector::operator[]
+            //
+            if (k >= _length) {
+                throw std::out_of_range("Span Index out of Range.");
+            }
+            return _data[k];
+        }
+
+        T* begin(void) const {
+            return _data;
+        }
+
+        T* end(void) const {
+            return _data + _length;
+        }
+
+        Span subspan(uint64_t offset, uint64_t count) const {
+            //
+            // The 'count' elements starting at 'offset'
+            //
+            if (offset > _length || count > _length - offset) {
+                throw std::out_of_range("Subspan out of Range.");
+            }
+            return Span(_data + offset, count);
+        }
+
+    private:
+        T* _data;
+        uint64_t _length;
+    };
+}
+
+#endif
@@ -0,0 +1,411 @@
+#ifndef _STATIC_VECTOR_H_
+#define _STATIC_VECTOR_H_
+
+#include <cstdint>
+#include <initializer_list>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace epl
+{
+    namespace detail
+    {
+        //
+        // Element types a StaticVector can keep in a plain array: every cell holds a
+        // (default constructed) object whether it is in use or not, and a push simply
+        // assigns to it. That keeps StaticVector a literal type, usable in constant
+        // expressions.
+        //
+        template <typename T>
+        struct is_literal_cell : std::integral_constant<bool,
+            std::is_trivially_copyable<T>::value && std::is_trivially_destructible<T>::value &&
+            std::is_default_constructible<T>::value> {};
+
+        template <typename T, uint64_t N, bool = is_literal_cell<T>::value>
+        struct static_storage {
+            T _cells[N > 0 ? N : 1];
+            uint64_t _front;
+            uint64_t _back;
+
+            constexpr static_storage(void) : _cells{}, _front(0), _back(0) {}
+
+            constexpr T* cell(uint64_t k) {
+                return _cells + k;
+            }
+
+            constexpr const T* cell(uint64_t k) const {
+                return _cells + k;
+            }
+
+            template <typename... Args>
+            constexpr void construct(uint64_t k, Args&&... args) {
+                _cells[k] = T(std::forward<Args>(args)...);
+            }
+
+            constexpr void destroy(uint64_t, uint64_t) {}
+
+            constexpr void slide(uint64_t front) {
+                //
+                // Moves the elements so that they start at cell 'front'
+                //
+                uint64_t length = _back - _front;
+                if (front < _front) {
+                    for (uint64_t k = 0; k < length; k++) {
+                        _cells[front + k] = _cells[_front + k];
+                    }
+                }
+                else {
+                    for (uint64_t k = length; k > 0; k--) {
+                        _cells[front + k - 1] = _cells[_front + k - 1];
+                    }
+                }
+                _front = front;
+                _back = front + length;
+            }
+        };
+
+        template <typename T, uint64_t N>
+        struct static_storage<T, N, false> {
+            //
+            // Raw cells for everything else: elements are constructed in place when pushed
+            // and destroyed when popped, as in Vector's buffer
+            //
+            alignas(T) unsigned char _bytes[(N > 0 ? N : 1) * sizeof(T)];
+            uint64_t _front;
+            uint64_t _back;
+
+            static_storage(void) : _front(0), _back(0) {}
+
+            static_storage(const static_storage& other) : _front(other._front), _back(other._front) {
+                //
+                // If a copy throws, the elements copied so far are destroyed again, since
+                // no destructor runs for a partly constructed object
+                //
+                try {
+                    for (; _back < other._back; _back++) {
+                        construct(_back, *other.cell(_back));
+                    }
+                }
+                catch (...) {
+                    destroy(_front, _back);
+                    throw;
+                }
+            }
+
+            static_storage(static_storage&& other) : _front(other._front), _back(other._front) {
+                try {
+                    for (; _back < other._back; _back++) {
+                        construct(_back, std::move(*other.cell(_back)));
+                    }
+                }
+                catch (...) {
+                    destroy(_front, _back);
+                    throw;
+                }
+            }
+
+            static_storage& operator=(const static_storage& other) {
+                if (this != &other) {
+                    destroy(_front, _back);
+                    _front = other._front;
+                    for (_back = _front; _back < other._back; _back++) {
+                        construct(_back, *other.cell(_back));
+                    }
+                }
+                return *this;
+            }
+
+            static_storage& operator=(static_storage&& other) {
+                if (this != &other) {
+                    destroy(_front, _back);
+                    _front = other._front;
+                    for (_back = _front; _back < other._back; _back++) {
+                        construct(_back, std::move(*other.cell(_back)));
+                    }
+                }
+                return *this;
+            }
+
+            ~static_storage() {
+                destroy(_front, _back);
+            }
+
+            T* cell(uint64_t k) {
+                return std::launder(reinterpret_cast<T*>(_bytes) + k);
+            }
+
+            const T* cell(uint64_t k) const {
+                return std::launder(reinterpret_cast<const T*>(_bytes) + k);
+            }
+
+            template <typename... Args>
+            void construct(uint64_t k, Args&&... args) {
+                new (reinterpret_cast<T*>(_bytes) + k) T(std::forward<Args>(args)...);
+            }
+
+            void destroy(uint64_t first, uint64_t last) {
+                if (!std::is_trivially_destructible<T>::value) {
+                    for (; first < last; first++) {
+                        cell(first)->~T();
+                    }
+                }
+            }
+
+            void relocate(uint64_t to, uint64_t from) {
+                //
+                // Moves the element, or copies it if its move may throw and it can be copied
+                //
+                construct(to, std::move_if_noexcept(*cell(from)));
+                destroy(from, from + 1);
+            }
+
+            void slide(uint64_t front) {
+                //
+                // As above. The elements go over one at a time, so if one of them throws,
+                // those already moved are destroyed and the container is left holding the
+                // ones still in their old cells.
+                //
+                uint64_t length = _back - _front;
+                uint64_t k = 0;
+                if (front < _front) {
+                    try {
+                        for (; k < length; k++) {
+                            relocate(front + k, _front + k);
+                        }
+                    }
+                    catch (...) {
+                        destroy(front, front + k);
+                        _front += k;
+                        throw;
+                    }
+                }
+                else {
+                    k = length;
+                    try {
+                        for (; k > 0; k--) {
+                            relocate(front + k - 1, _front + k - 1);
+                        }
+                    }
+                    catch (...) {
+                        destroy(front + k, front + length);
+                        _back = _front + k;
+                        throw;
+                    }
+                }
+                _front = front;
+                _back = front + length;
+            }
+        };
+    }
+
+    template <typename T, uint64_t N>
+    class StaticVector : private detail::static_storage<T, N> {
+        typedef detail::static_storage<T, N> storage;
+
+    public:
+        //
+        // A double-ended vector of at most N elements, all stored inside the object: it
+        // never allocates, neither for elements nor for a control block, which makes it
+        // usable where the heap is off limits. Pushes and pops work at both ends as in
+        // Vector. When one end runs out of free cells while the other still has some,
+        // the elements slide over to split the free cells between the two ends (in place
+        // of Vector's reallocation); a push onto a full StaticVector throws
+        // std::length_error.
+        //
+        // Element types that are trivially copyable, trivially destructible and default
+        // constructible are kept in a plain array, and then every operation is constexpr:
+        // a table can be built at compile time, e.g.
+        //
+        //   constexpr auto table = [] {
+        //       epl::StaticVector<int, 16> t;
+        //       for (int k = 0; k < 16; k++) {
+        //           t.push_back(k * k);
+        //       }
+        //       return t;
+        //   }();
+        //
+        // and end up in read-only data. Other element types are constructed in place in
+        // raw cells, at run time only. A slide moves them with std::move_if_noexcept; if
+        // that still throws, the elements it had already moved are destroyed and the
+        // StaticVector keeps the others.
+        //
+        // Without a control block there are no iterator checks: iterators are plain
+        // pointers, as with checking::none, and a slide moves the elements under them.
+        // operator[] is range checked.
+        //
+        typedef T value_type;
+        typedef T* iterator;
+        typedef const T* const_iterator;
+
+        constexpr StaticVector(void) {}
+
+        constexpr StaticVector(std::initializer_list<T> init_list) {
+            if (init_list.size() > N) {
+                throw std::length_error("StaticVector capacity exceeded.");
+            }
+            for (const T* p = init_list.begin(); p != init_list.end(); ++p) {
+                this->construct(this->_back, *p);
+                this->_back++;
+            }
+        }
+
+        static constexpr uint64_t capacity(void) {
+            return N;
+        }
+
+        constexpr uint64_t size(void) const {
+            return this->_back - this->_front;
+        }
+
+        constexpr bool empty(void) const {
+            return this->_back == this->_front;
+        }
+
+        constexpr T& operator[](uint64_t k) {
+            if (k >= size()) {
+                throw std::out_of_range("Array Index out of Range.");
+            }
+            return *this->cell(this->_front + k);
+        }
+
+        constexpr const T& operator[](uint64_t k) const {
+            if (k >= size()) {
+                throw std::out_of_range("Array Index out of Range.");
+            }
+            return *this->cell(this->_front + k);
+        }
+
+        constexpr T& at_unchecked(uint64_t k) {
+            return *this->cell(this->_front + k);
+        }
+
+        constexpr const T& at_unchecked(uint64_t k) const {
+            return *this->cell(this->_front + k);
+        }
+
+        constexpr T* data(void) {
+            return this->cell(this->_front);
+        }
+
+        constexpr const T* data(void) const {
+            return this->cell(this->_front);
+        }
+
+        constexpr iterator begin(void) {
+            return this->cell(this->_front);
+        }
+
+        constexpr const_iterator begin(void) const {
+            return this->cell(this->_front);
+        }
+
+        constexpr iterator end(void) {
+            return this->cell(this->_back);
+        }
+
+        constexpr const_iterator end(void) const {
+            return this->cell(this->_back);
+        }
+
+        template <typename... Args>
+        constexpr void emplace_back(Args&&... args) {
+            if (this->_back == N) {
+                //
+                // The arguments may refer to an element that the slide moves
+                //
+                T val(std::forward<Args>(args)...);
+                make_room(true);
+                this->construct(this->_back, std::move(val));
+            }
+            else {
+                this->construct(this->_back, std::forward<Args>(args)...);
+            }
+            this->_back++;
+        }
+
+        template <typename... Args>
+        constexpr void emplace_front(Args&&... args) {
+            if (this->_front == 0) {
+                T val(std::forward<Args>(args)...);
+                make_room(false);
+                this->construct(this->_front - 1, std::move(val));
+            }
+            else {
+                this->construct(this->_front - 1, std::forward<Args>(args)...);
+            }
+            this->_front--;
+        }
+
+        constexpr void push_back(const T& val) {
+            emplace_back(val);
+        }
+
+        constexpr void push_back(T&& val) {
+            emplace_back(std::move(val));
+        }
+
+        constexpr void push_front(const T& val) {
+            emplace_front(val);
+        }
+
+        constexpr void push_front(T&& val) {
+            emplace_front(std::move(val));
+        }
+
+        constexpr void pop_back(void) {
+            if (empty()) {
+                throw std::out_of_range("Cannot invoke pop_back() when the container is empty.");
+            }
+            this->_back--;
+            this->destroy(this->_back, this->_back + 1);
+        }
+
+        constexpr void pop_front(void) {
+            if (empty()) {
+                throw std::out_of_range("Cannot invoke pop_front() when the container is empty.");
+            }
+            this->destroy(this->_front, this->_front + 1);
+            this->_front++;
+        }
+
+        constexpr void pop_back(uint64_t n) {
+            if (n > size()) {
+                throw std::out_of_range("Cannot pop_back() more elements than the container holds.");
+            }
+            this->destroy(this->_back - n, this->_back);
+            this->_back -= n;
+        }
+
+        constexpr void pop_front(uint64_t n) {
+            if (n > size()) {
+                throw std::out_of_range("Cannot pop_front() more elements than the container holds.");
+            }
+            this->destroy(this->_front, this->_front + n);
+            this->_front += n;
+        }
+
+        constexpr void clear(void) {
+            this->destroy(this->_front, this->_back);
+            this->_front = 0;
+            this->_back = 0;
+        }
+
+    private:
+        constexpr void make_room(bool at_back) {
+            //
+            // Slides the elements so that the free cells are split between the two ends,
+            // the end that ran out getting at least one
+            //
+            uint64_t length = size();
+            if (length == N) {
+                throw std::length_error("StaticVector capacity exceeded.");
+            }
+            uint64_t free = N - length;
+            this->slide(at_back ? free / 2 : free - free / 2);
+        }
+    };
+}
+
+#endif
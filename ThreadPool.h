@@ -0,0 +1,387 @@
+#ifndef _THREAD_POOL_H_
+#define _THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Vector.h"
+#include "WorkStealingDeque.h"
+
+namespace epl
+{
+    class ThreadPool {
+    public:
+        //
+        // Work stealing thread pool. Every worker owns a WorkStealingDeque of tasks: it
+        // pushes and takes work at the back of its own deque (most recently pushed, still
+        // warm in its cache) without locking, and once that is empty, steals from the
+        // front of the other workers' deques. Tasks submitted from threads outside the
+        // pool go to a shared inbox, the only place a lock is taken on the way to a task.
+        // A thread waiting for a parallel_for does not block either; it keeps running
+        // queued tasks until its own are done, so parallel_for may be nested freely
+        // inside tasks without deadlocking the pool.
+        //
+        // The thread calling parallel_for works along with the pool, so the default
+        // pool starts one worker less than there are hardware threads.
+        //
+        explicit ThreadPool(unsigned threads = default_threads()) :
+            _num_queues(threads), _inbox_size(0), _pending(0), _stop(false) {
+            _queues.reset(new worker_queue[threads == 0 ? 1 : threads]);
+            for (unsigned k = 0; k < threads; k++) {
+                _threads.emplace_back([this, k] { this->work(k); });
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        ~ThreadPool() {
+            //
+            // Runs whatever is still queued, then joins the workers
+            //
+            {
+                std::lock_guard<std::mutex> lock(_sleep_lock);
+                _stop = true;
+            }
+            _wake.notify_all();
+            for (size_t k = 0; k < _threads.size(); k++) {
+                _threads[k].join();
+            }
+        }
+
+        static ThreadPool& instance(void) {
+            //
+            // The pool used by the parallel algorithms when none is given explicitly
+            //
+            static ThreadPool pool;
+            return pool;
+        }
+
+        static unsigned default_threads(void) {
+            unsigned hw = std::thread::hardware_concurrency();
+            return hw > 1 ? hw - 1 : 0;
+        }
+
+        unsigned size(void) const {
+            //
+            // Number of worker threads (not counting callers that help out)
+            //
+            return _num_queues;
+        }
+
+        template <typename F>
+        void submit(F&& task) {
+            //
+            // Queues a task for any worker. A task submitted from a worker goes to that
+            // worker's own deque, one from elsewhere to the inbox. Without workers the
+            // task runs right away.
+            //
+            // Nobody waits for a submitted task, so nothing is there to rethrow its
+            // exceptions: if it throws, whichever thread ran it keeps the first such
+            // exception for take_error() and carries on with the next task.
+            //
+            if (_num_queues == 0) {
+                task_type t(std::forward<F>(task));
+                run(t);
+                return;
+            }
+            std::unique_ptr<task_type> t(new task_type(std::forward<F>(task)));
+            int own = own_queue();
+            if (own >= 0) {
+                push(own, std::move(t));
+            }
+            else {
+                std::lock_guard<std::mutex> lock(_inbox_lock);
+                push_inbox(std::move(t));
+            }
+            notify(false);
+        }
+
+        template <typename F>
+        void parallel_for(uint64_t first, uint64_t last, uint64_t grain, F&& body) {
+            //
+            // Calls body(lo, hi) for consecutive chunks [lo, hi) of at most 'grain' indices
+            // covering [first, last), and returns once all of them have run. The calling
+            // thread runs the first chunk itself and then helps with whatever is queued.
+            // If a chunk throws, the chunks that have not started yet are skipped and the
+            // first exception is rethrown here.
+            //
+            if (last <= first) {
+                return;
+            }
+            if (grain == 0) {
+                grain = 1;
+            }
+            uint64_t chunks = (last - first - 1) / grain + 1;
+            if (chunks == 1 || _num_queues == 0) {
+                for (uint64_t lo = first; lo < last; lo += grain) {
+                    body(lo, last - lo < grain ? last : lo + grain);
+                }
+                return;
+            }
+
+            join_state state;
+            state._remaining.store(chunks - 1, std::memory_order_relaxed);
+            auto run_chunk = [&state, &body](uint64_t lo, uint64_t hi) {
+                if (state._failed.load(std::memory_order_relaxed)) {
+                    return;
+                }
+                try {
+                    body(lo, hi);
+                }
+                catch (...) {
+                    state.fail(std::current_exception());
+                }
+            };
+            //
+            // From a worker the chunks go to its own deque, and idle workers steal them
+            // from there; from elsewhere the whole batch goes to the inbox under one lock.
+            // Chunks are pushed last to first, so the owner pops them in order and
+            // thieves take the far end of the range.
+            //
+            int own = own_queue();
+            std::unique_lock<std::mutex> inbox;
+            if (own < 0) {
+                inbox = std::unique_lock<std::mutex>(_inbox_lock);
+            }
+            for (uint64_t c = chunks - 1; c > 0; c--) {
+                uint64_t lo = first + c * grain;
+                uint64_t hi = last - lo < grain ? last : lo + grain;
+                std::unique_ptr<task_type> t(new task_type([&state, run_chunk, lo, hi] {
+                    run_chunk(lo, hi);
+                    state._remaining.fetch_sub(1, std::memory_order_release);
+                }));
+                if (own >= 0) {
+                    push(own, std::move(t));
+                }
+                else {
+                    push_inbox(std::move(t));
+                }
+            }
+            if (inbox.owns_lock()) {
+                inbox.unlock();
+            }
+            notify(true);
+
+            run_chunk(first, first + grain);
+            while (state._remaining.load(std::memory_order_acquire) != 0) {
+                if (!run_one()) {
+                    std::this_thread::yield();
+                }
+            }
+            if (state._error) {
+                std::rethrow_exception(state._error);
+            }
+        }
+
+        bool run_one(void) {
+            //
+            // Runs one queued task on the calling thread, if there is any. Returns
+            // whether a task was run.
+            //
+            task_type* task;
+            if (!take(own_queue(), task)) {
+                return false;
+            }
+            std::unique_ptr<task_type> owned(task);
+            run(*owned);
+            return true;
+        }
+
+        std::exception_ptr take_error(void) {
+            //
+            // Returns the first exception thrown by a submitted task since the last call,
+            // or a null pointer, and forgets it
+            //
+            std::lock_guard<std::mutex> lock(_error_lock);
+            std::exception_ptr error = _error;
+            _error = nullptr;
+            return error;
+        }
+
+    private:
+        typedef std::function<void()> task_type;
+        typedef WorkStealingDeque<task_type*> worker_queue;
+
+        struct join_state {
+            std::atomic<uint64_t> _remaining;
+            std::atomic<bool> _failed{ false };
+            std::mutex _error_lock;
+            std::exception_ptr _error;
+
+            void fail(std::exception_ptr error) {
+                std::lock_guard<std::mutex> lock(_error_lock);
+                if (!_error) {
+                    _error = error;
+                }
+                _failed.store(true, std::memory_order_relaxed);
+            }
+        };
+
+        struct worker_slot {
+            const ThreadPool* _pool;
+            unsigned _index;
+        };
+
+        std::unique_ptr<worker_queue[]> _queues;
+        unsigned _num_queues;
+        //
+        // Tasks submitted from outside the pool: only a worker may push to its deque
+        //
+        std::mutex _inbox_lock;
+        std::deque<task_type*> _inbox;
+        //
+        // Size of the inbox, so that workers can skip its lock while it is empty
+        //
+        std::atomic<uint64_t> _inbox_size;
+        std::vector<std::thread> _threads;
+        //
+        // Number of tasks sitting in the queues, incremented before a task is pushed
+        //
+        std::atomic<int64_t> _pending;
+        //
+        // First exception a submitted task threw, until take_error() picks it up
+        //
+        std::mutex _error_lock;
+        std::exception_ptr _error;
+        bool _stop;
+        std::mutex _sleep_lock;
+        std::condition_variable _wake;
+
+        static worker_slot& this_worker(void) {
+            static thread_local worker_slot slot{ nullptr, 0 };
+            return slot;
+        }
+
+        int own_queue(void) const {
+            //
+            // Index of the calling thread's queue, or -1 if it is not a worker of this pool
+            //
+            worker_slot& slot = this_worker();
+            return slot._pool == this ? (int)slot._index : -1;
+        }
+
+        void push(int own, std::unique_ptr<task_type> task) {
+            //
+            // Owner only, like WorkStealingDeque::push
+            //
+            _pending.fetch_add(1, std::memory_order_relaxed);
+            try {
+                _queues[own].push(task.get());
+            }
+            catch (...) {
+                _pending.fetch_sub(1, std::memory_order_relaxed);
+                throw;
+            }
+            task.release();
+        }
+
+        void push_inbox(std::unique_ptr<task_type> task) {
+            //
+            // Called with _inbox_lock held
+            //
+            _pending.fetch_add(1, std::memory_order_relaxed);
+            try {
+                _inbox.push_back(task.get());
+            }
+            catch (...) {
+                _pending.fetch_sub(1, std::memory_order_relaxed);
+                throw;
+            }
+            _inbox_size.store(_inbox.size(), std::memory_order_relaxed);
+            task.release();
+        }
+
+        void notify(bool all) {
+            //
+            // Taking the lock orders the push before a sleeping worker's check of _pending
+            //
+            {
+                std::lock_guard<std::mutex> lock(_sleep_lock);
+            }
+            if (all) {
+                _wake.notify_all();
+            }
+            else {
+                _wake.notify_one();
+            }
+        }
+
+        bool take(int own, task_type*& task) {
+            //
+            // Pops the newest task of our own deque, or takes the oldest task of the
+            // inbox, or steals the oldest task of another worker's deque
+            //
+            if (_num_queues == 0) {
+                return false;
+            }
+            if (own >= 0 && _queues[own].pop(task)) {
+                _pending.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+            if (_inbox_size.load(std::memory_order_relaxed) != 0) {
+                std::lock_guard<std::mutex> lock(_inbox_lock);
+                if (!_inbox.empty()) {
+                    task = _inbox.front();
+                    _inbox.pop_front();
+                    _inbox_size.store(_inbox.size(), std::memory_order_relaxed);
+                    _pending.fetch_sub(1, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+            unsigned start = own >= 0 ? (unsigned)own + 1 : 0;
+            for (unsigned k = 0; k < _num_queues; k++) {
+                unsigned q = (start + k) % _num_queues;
+                if ((int)q != own && _queues[q].steal(task)) {
+                    _pending.fetch_sub(1, std::memory_order_relaxed);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void run(task_type& task) {
+            //
+            // parallel_for's chunks catch their own exceptions; only a submitted task
+            // gets here with one
+            //
+            try {
+                task();
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lock(_error_lock);
+                if (!_error) {
+                    _error = std::current_exception();
+                }
+            }
+        }
+
+        void work(unsigned index) {
+            worker_slot& slot = this_worker();
+            slot._pool = this;
+            slot._index = index;
+            for (;;) {
+                if (run_one()) {
+                    continue;
+                }
+                std::unique_lock<std::mutex> lock(_sleep_lock);
+                _wake.wait(lock, [this] {
+                    return _stop || _pending.load(std::memory_order_relaxed) > 0;
+                });
+                if (_stop && _pending.load(std::memory_order_relaxed) <= 0) {
+                    return;
+                }
+            }
+        }
+    };
+}
+
+#endif
@@ -1,5 +1,19 @@
 #ifndef _VECTOR_H_
 #define _VECTOR_H_
+
+#include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+#ifdef _EPL_STATS_
+#include "VectorStats.h"
+#endif
 
 using namespace std;
 //
@@ -44,17 +58,190 @@ namespace epl
         }
     };
 
+    //
+    // Size assumed for a cache line when laying out data shared between threads
+    //
+    static const size_t cache_line_size = 64;
+
+    namespace checking {
+        //
+        // Checking policies for epl::Vector. The policy decides what the iterators
+        // handed out by the vector verify on every use:
+        //
+        //   full   - iterators share a control block with the vector and detect every
+        //            invalidation (the original semantics of the class)
+        //   bounds - iterators only range check dereferences against the live range
+        //            they were created with; no control block is ever allocated
+        //   none   - iterators are raw pointers and the vector keeps no control block
+        //   concurrent - same checks as full, but the control block is reference counted
+        //            atomically, so any number of threads may iterate the same vector at
+        //            once. Mutating the vector still requires exclusive access.
+        //
+        struct full {
+            static const bool tracks_versions = true;
+            static const bool checks_bounds = true;
+            static const bool atomic_refs = false;
+        };
+
+        struct bounds {
+            static const bool tracks_versions = false;
+            static const bool checks_bounds = true;
+            static const bool atomic_refs = false;
+        };
+
+        struct none {
+            static const bool tracks_versions = false;
+            static const bool checks_bounds = false;
+            static const bool atomic_refs = false;
+        };
+
+        struct concurrent {
+            static const bool tracks_versions = true;
+            static const bool checks_bounds = true;
+            static const bool atomic_refs = true;
+        };
+    }
+
+    //
+    // The policy used when none is given explicitly. Release builds can drop the
+    // checks for every vector at once by defining _EPL_UNCHECKED_ or _EPL_BOUNDS_CHECKED_.
+    //
+#if defined(_EPL_UNCHECKED_)
+    typedef checking::none default_checking;
+#elif defined(_EPL_BOUNDS_CHECKED_)
+    typedef checking::bounds default_checking;
+#else
+    typedef checking::full default_checking;
+#endif
+
+    namespace growth {
+        //
+        // Growth policies for epl::Vector. When an end of the buffer runs out of room the
+        // vector first tries to recenter: if the live range takes up no more than
+        // RecenterPercent of the buffer, it is slid back to the middle of the existing
+        // buffer instead of reallocating. Otherwise the buffer grows to
+        //
+        //   max(capacity * FactorNum / FactorDen, capacity + MinStep)
+        //
+        // cells, and GrowingEndPercent of the added cells go to the end that ran out of
+        // room, the rest to the other end. Setting RecenterPercent to 0 turns recentering off.
+        //
+        template <uint64_t FactorNum, uint64_t FactorDen, uint64_t MinStep,
+            uint64_t GrowingEndPercent, uint64_t RecenterPercent>
+        struct policy {
+            static_assert(FactorDen > 0 && FactorNum >= FactorDen, "The growth factor must be at least 1");
+            static_assert(MinStep > 0, "The minimum growth step must be positive");
+            static_assert(GrowingEndPercent <= 100, "The growing end share is a percentage");
+            static_assert(RecenterPercent < 100, "Recentering needs free cells to work with");
+
+            static uint64_t next_capacity(uint64_t capacity, uint64_t needed) {
+                uint64_t next = capacity / FactorDen * FactorNum + capacity % FactorDen * FactorNum / FactorDen;
+                if (next < capacity + MinStep) {
+                    next = capacity + MinStep;
+                }
+                return next < needed ? needed : next;
+            }
+
+            static uint64_t growing_end_share(uint64_t added) {
+                return added / 100 * GrowingEndPercent + added % 100 * GrowingEndPercent / 100;
+            }
+
+            static bool should_recenter(uint64_t length, uint64_t capacity) {
+                return length < capacity &&
+                    length <= capacity / 100 * RecenterPercent + capacity % 100 * RecenterPercent / 100;
+            }
+        };
+
+        //
+        // The classic behaviour: double, all new room at the end that ran out, and
+        // recenter sparse buffers so that alternating push_front/push_back does not
+        // reallocate on every switch of ends
+        //
+        typedef policy<2, 1, 8, 100, 50> doubling;
+        //
+        // Double and split the new room evenly - for workloads that grow at both ends
+        //
+        typedef policy<2, 1, 8, 50, 50> balanced;
+        //
+        // Grow by 1.5x - less slack for large vectors that grow at the back
+        //
+        typedef policy<3, 2, 8, 100, 50> compact;
+    }
+
+    template <typename T, typename Checking = default_checking, typename Alloc = std::allocator<T>,
+        typename Growth = growth::doubling>
+    class Vector;
+
+    namespace detail {
+        //
+        // Grants library code outside the class (the parallel algorithms) access to a
+        // vector's live range and to the validation of its checked iterators
+        //
+        struct vector_access;
+    }
+
+    //
+    // Trait describing whether an object of type T can be moved to a new address
+    // with a plain memcpy, after which the source bytes are simply forgotten (no
+    // destructor run). Every trivially copyable and trivially destructible type
+    // qualifies. Other types can opt in by specializing this trait, as long as
+    // they hold no pointers into themselves.
+    //
+    template <typename T>
+    struct is_trivially_relocatable : std::integral_constant<bool,
+        std::is_trivially_copyable<T>::value && std::is_trivially_destructible<T>::value> {};
+
+    //
+    // A Vector only holds pointers to its heap buffer and its control block,
+    // neither of which refer back to the Vector object itself. The allocator is
+    // assumed to be relocatable too, which holds for std::allocator and for
+    // std::pmr::polymorphic_allocator.
+    //
+    template <typename T, typename Checking, typename Alloc, typename Growth>
+    struct is_trivially_relocatable<Vector<T, Checking, Alloc, Growth>> : std::true_type {};
+
+    //
+    // Trait describing whether an allocator can resize a buffer in place. Such an
+    // allocator provides
+    //
+    //   T* reallocate(T* p, size_t old_n, size_t new_n)
+    //
+    // which takes over the buffer 'p' and returns a buffer of new_n elements starting
+    // with the bytes of the old_n elements of 'p' (at the same address if it could be
+    // extended). A Vector of trivially relocatable elements grows through it instead
+    // of allocating a new buffer and relocating into it.
+    //
+    template <typename Alloc, typename T, typename = void>
+    struct allocator_reallocates : std::false_type {};
+
+    template <typename Alloc, typename T>
+    struct allocator_reallocates<Alloc, T, std::void_t<decltype(
+        std::declval<Alloc&>().reallocate(std::declval<T*>(), size_t(), size_t()))>> : std::true_type {};
+
     template <typename It>
     struct iterator_traits {
         using value_type = typename It::value_type;
         using iterator_category = typename It::iterator_category;
     };
     
-    template <typename T>
+    template <typename T, typename Checking, typename Alloc, typename Growth>
     class Vector {
+        typedef std::allocator_traits<Alloc> alloc_traits;
+
     public:
+        typedef Alloc allocator_type;
+        typedef Checking checking_policy;
+
         struct CtrlBlk {
         public:
+            //
+            // Control blocks are allocated with the vector's allocator, rebound to CtrlBlk.
+            // A copy of it is kept in the block, since the last iterator using the block
+            // may be the one that has to free it, long after the vector is gone.
+            //
+            typedef typename alloc_traits::template rebind_alloc<CtrlBlk> ctrl_allocator;
+            typedef std::allocator_traits<ctrl_allocator> ctrl_traits;
+
             typedef enum {
                 PUSH_BACK,
                 POP_BACK,
@@ -67,52 +254,227 @@ namespace epl
                 NONE
             } invalidate_reason;
 
-            uint64_t _version;
-            uint64_t _refs;
+            //
+            // In the concurrent mode the version and the reference count are atomics, and
+            // the reference count sits on its own cache line: iterators of all threads read
+            // the version on every step, while the count is only written when iterators are
+            // copied or destroyed, so keeping them apart stops those writes from evicting
+            // the version out of every reader's cache.
+            //
+            typedef typename std::conditional<Checking::atomic_refs, std::atomic<uint64_t>, uint64_t>::type counter_type;
+
+            counter_type _version;
+            alignas(Checking::atomic_refs ? cache_line_size : alignof(counter_type)) counter_type _refs;
             invalidate_reason _reason;
-            T *_location, *_begin, *_end;
+            T *_location, *_location_end, *_begin, *_end;
+            ctrl_allocator _alloc;
 
             CtrlBlk() = delete;
             
-            explicit CtrlBlk(int64_t version) {
+            CtrlBlk(int64_t version, const ctrl_allocator& alloc) : _alloc(alloc) {
                 //
                 // The CtrlkBlk object can only be created with an integer version
                 // The default constructor has been deleted so that it cannot be 
                 // called ainwayi
                 //
+                //
+                // In the concurrent mode the vector itself holds a reference to its
+                // current block, so that the last owner to let go (vector or iterator,
+                // on whichever thread) is the one that frees it
+                //
                 this->_version = version;
-                this->_refs = 0;
+                this->_refs = Checking::atomic_refs ? 1 : 0;
                 this->_reason = NONE;
                 this->_location = nullptr;
+                this->_location_end = nullptr;
                 this->_begin = nullptr;
                 this->_end = nullptr;
             }
 
             ~CtrlBlk() {}
 
+            //
+            // A mutation while an iterator holds the current block has to move the vector
+            // to a new block, and the old one is freed once its last iterator is gone. So
+            // a loop that takes an iterator and mutates the vector would allocate and free
+            // a block on every pass. Instead, released blocks are kept (unconstructed) on a
+            // small per-thread free list and handed out again by create(). This is only
+            // done when all allocators of the type are equal, so that it does not matter
+            // which vector a cached block came from.
+            //
+            static const bool cached = ctrl_traits::is_always_equal::value &&
+                std::is_default_constructible<ctrl_allocator>::value;
+            static const uint32_t cache_limit = 32;
+
+            struct block_cache {
+                void* _head;
+                uint32_t _count;
+                bool _closed;
+            };
+
+            struct block_cache_drain {
+                //
+                // Frees the blocks cached by a thread when it exits. Later releases on the
+                // thread (from static destructors) go straight to the allocator.
+                //
+                ~block_cache_drain() {
+                    block_cache& cache = thread_cache();
+                    ctrl_allocator a;
+                    while (cache._head != nullptr) {
+                        void* next = *static_cast<void**>(cache._head);
+                        ctrl_traits::deallocate(a, static_cast<CtrlBlk*>(cache._head), 1);
+                        cache._head = next;
+                    }
+                    cache._count = 0;
+                    cache._closed = true;
+                }
+            };
+
+            static block_cache& thread_cache(void) {
+                static thread_local block_cache cache{ nullptr, 0, false };
+                return cache;
+            }
+
+            static CtrlBlk* create(int64_t version, const Alloc& alloc) {
+                //
+                // Allocates and constructs a control block through the allocator, or
+                // reuses a cached one
+                //
+                ctrl_allocator a(alloc);
+                CtrlBlk* blk = nullptr;
+                if constexpr (cached) {
+                    block_cache& cache = thread_cache();
+                    if (cache._head != nullptr) {
+                        blk = static_cast<CtrlBlk*>(cache._head);
+                        cache._head = *static_cast<void**>(cache._head);
+                        cache._count--;
+                    }
+                }
+                if (blk == nullptr) {
+                    blk = ctrl_traits::allocate(a, 1);
+                }
+                new (blk) CtrlBlk(version, a);
+                return blk;
+            }
+
+            static void release(CtrlBlk* blk) {
+                //
+                // Destructs the control block and hands its memory back to the
+                // allocator it came from, or to the cache
+                //
+                ctrl_allocator a(blk->_alloc);
+                blk->~CtrlBlk();
+                if constexpr (cached) {
+                    block_cache& cache = thread_cache();
+                    if (!cache._closed && cache._count < cache_limit) {
+                        static thread_local block_cache_drain drain;
+                        (void)drain;
+                        *reinterpret_cast<void**>(blk) = cache._head;
+                        cache._head = blk;
+                        cache._count++;
+                        return;
+                    }
+                }
+                ctrl_traits::deallocate(a, blk, 1);
+            }
+
+            uint64_t version() const {
+                if constexpr (Checking::atomic_refs) {
+                    return this->_version.load(std::memory_order_acquire);
+                }
+                else {
+                    return this->_version;
+                }
+            }
+
+            void set_version(uint64_t version) {
+                if constexpr (Checking::atomic_refs) {
+                    this->_version.store(version, std::memory_order_release);
+                }
+                else {
+                    this->_version = version;
+                }
+            }
+
             void incRef() {
-                this->_refs++;
+                if constexpr (Checking::atomic_refs) {
+                    this->_refs.fetch_add(1, std::memory_order_relaxed);
+                }
+                else {
+                    this->_refs++;
+                }
             }
 
-            void decRef() {
-                this->_refs--;
+            bool decRef() {
+                //
+                // Drops an iterator's reference. Returns true if the caller has to release
+                // the block: nobody else uses it any more and it cannot become current again.
+                //
+                if constexpr (Checking::atomic_refs) {
+                    return this->_refs.fetch_sub(1, std::memory_order_acq_rel) == 1;
+                }
+                else {
+                    this->_refs--;
+                    return this->_version == INT_MIN && this->_refs == 0;
+                }
+            }
+
+            bool shared() const {
+                //
+                // True if any iterator refers to this block
+                //
+                if constexpr (Checking::atomic_refs) {
+                    return this->_refs.load(std::memory_order_acquire) > 1;
+                }
+                else {
+                    return this->_refs > 0;
+                }
+            }
+
+            static void abandon(CtrlBlk* blk) {
+                //
+                // Called by the vector when it stops using an (already invalidated) block.
+                // The block is released right away unless iterators still refer to it;
+                // then the last of them releases it.
+                //
+                if constexpr (Checking::atomic_refs) {
+                    if (blk->_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                        release(blk);
+                    }
+                }
+                else {
+                    if (blk->_refs == 0) {
+                        release(blk);
+                    }
+                }
             }
 
             void invalidate(invalidate_reason reason, T* location, T* begin, T*end) {
+                invalidate(reason, location, location == nullptr ? nullptr : location + 1, begin, end);
+            }
+
+            void invalidate(invalidate_reason reason, T* location, T* location_end, T* begin, T*end) {
                 //
                 // Invalidating the CtrlBlk - storing the reason for invalidation 
                 // and also pertinent details about why it was invalidated. These details
                 // help while throwing exceptions when the invalid iterator is used later.
+                // [location, location_end) is the range of cells that were removed by a pop.
+                // The version is written last, so that a thread that sees the block
+                // invalidated also sees why.
                 // 
-                this->_version = INT_MIN;
                 this->_reason = reason;
                 this->_location = location;
+                this->_location_end = location_end;
                 this->_begin = begin;
                 this->_end = end;
+                set_version(INT_MIN);
             }
         };
         
-        struct const_iterator {
+        struct checked_const_iterator {
+            friend struct detail::vector_access;
+            friend class Vector;
+
         protected :
             T *_ptr, *_begin, *_end;
             CtrlBlk* _ctrlBlk;
@@ -120,14 +482,22 @@ namespace epl
             void validate_base() const {
                 //
                 // This method validates that the version of the vector is still okay
-                // to use. If not, then it throws an exception: invalid_iterator
+                // to use. If not, then it throws an exception: invalid_iterator.
+                // A default constructed iterator belongs to no vector and has nothing
+                // to validate (it may still be compared with another one).
                 //
-                if (this->_ctrlBlk->_version == INT_MIN) {
+                if (this->_ctrlBlk == nullptr) {
+                    return;
+                }
+                if (this->_ctrlBlk->version() == INT_MIN) {
                     //
                     // Iterator is invalid - check the various cases
                     // This function is called on the use of the value of the iterator
                     // Dereferencing uses a separate function
                     //
+#ifdef _EPL_STATS_
+                    detail::invalidation_thrown();
+#endif
                     if (this->_ctrlBlk->_reason == CtrlBlk::invalidate_reason::DESTROY) {
                         //
                         // Iterator's internal state has been deleted
@@ -143,7 +513,7 @@ namespace epl
                     }
                     else if ((this->_ctrlBlk->_reason == CtrlBlk::invalidate_reason::POP_BACK ||
                         this->_ctrlBlk->_reason == CtrlBlk::invalidate_reason::POP_FRONT) &&
-                        (_ptr == this->_ctrlBlk->_location)) {
+                        (_ptr >= this->_ctrlBlk->_location && _ptr < this->_ctrlBlk->_location_end)) {
                         //
                         // Iterator has been reallocated, but its not a destroy or an assignment
                         // This is the case when a push_back, push_front, pop_back or pop_front reallocates
@@ -177,13 +547,18 @@ namespace epl
             }
 
             void validate_deref() const {
+                validate_deref(this->_ptr);
+            }
+
+            void validate_deref(const T* ptr) const {
                 //
-                // This method validates the cases where an iterator is dereferenced. 
+                // This method validates the cases where an iterator is dereferenced
+                // (at 'ptr': the iterator itself, or an offset from it for operator[]).
                 // In case it is done out of bounds, an out_of_range exception is thrown
                 // In case the iterator is invalid, the more severe of the two exceptions is thrown
                 //
                 bool isOutOfRange = false;
-                if (this->_ptr == nullptr || this->_ptr < this->_begin || this->_ptr >= this->_end) {
+                if (ptr == nullptr || ptr < this->_begin || ptr >= this->_end) {
                     isOutOfRange = true;
                 }
                 //
@@ -213,17 +588,19 @@ namespace epl
             }
 
         public :
-            const_iterator() : _ctrlBlk(nullptr), _ptr(nullptr), _begin(nullptr), _end(nullptr) {}
+            checked_const_iterator() : _ptr(nullptr), _begin(nullptr), _end(nullptr), _ctrlBlk(nullptr) {}
 
-            const_iterator(const const_iterator& other) {
+            checked_const_iterator(const checked_const_iterator& other) {
                 this->_ctrlBlk = other._ctrlBlk;
                 this->_ptr = other._ptr;
                 this->_begin = other._begin;
                 this->_end = other._end;
-                this->_ctrlBlk->incRef();
+                if (this->_ctrlBlk != nullptr) {
+                    this->_ctrlBlk->incRef();
+                }
             }
 
-            const_iterator(T* ptr, T* begin, T* end, CtrlBlk* ctrlBlk) {
+            checked_const_iterator(T* ptr, T* begin, T* end, CtrlBlk* ctrlBlk) {
                 this->_ptr = ptr;
                 this->_begin = begin;
                 this->_end = end;
@@ -231,222 +608,643 @@ namespace epl
                 this->_ctrlBlk->incRef();
             }
 
+            checked_const_iterator& operator=(const checked_const_iterator& rhs) {
+                //
+                // Assignment moves this iterator over to the control block of the rhs,
+                // so the reference counts of both blocks have to be kept in step
+                //
+                if (this != &rhs) {
+                    release();
+                    this->_ctrlBlk = rhs._ctrlBlk;
+                    this->_ptr = rhs._ptr;
+                    this->_begin = rhs._begin;
+                    this->_end = rhs._end;
+                    if (this->_ctrlBlk != nullptr) {
+                        this->_ctrlBlk->incRef();
+                    }
+                }
+                return *this;
+            }
+
             using value_type = T;
             using iterator_category = std::random_access_iterator_tag;
-            using reference = T&;
-            using pointer = T*;
-            using difference_type = uint64_t;
+#if __cplusplus > 201703L
+            using iterator_concept = std::contiguous_iterator_tag;
+#endif
+            using reference = const T&;
+            using pointer = const T*;
+            using difference_type = int64_t;
 
             const T& operator*(void) const {
                 validate_deref();
                 return const_cast<const T&>(*_ptr);
             }
 
-            bool operator==(const_iterator& rhs) const {
+            const T* operator->(void) const {
+                validate_deref();
+                return _ptr;
+            }
+
+            const T& operator[](int64_t offset) const {
+                validate_deref(_ptr + offset);
+                return _ptr[offset];
+            }
+
+            bool operator==(const checked_const_iterator& rhs) const {
                 validate_base();
                 return _ptr == rhs._ptr;
             }
 
-            bool operator!=(const_iterator& rhs) const {
+            bool operator!=(const checked_const_iterator& rhs) const {
                 validate_base();
                 return !(*this == rhs);
             }
 
-            int64_t operator-(const_iterator& rhs) const {
+            int64_t operator-(const checked_const_iterator& rhs) const {
                 validate_base();
                 return (_ptr - rhs._ptr);
             }
 
-            const_iterator operator+(int64_t offset) const {
+            checked_const_iterator operator+(int64_t offset) const {
                 validate_base();
-                const_iterator t{ *this };
+                checked_const_iterator t{ *this };
                 t._ptr = t._ptr + offset;
                 return t;
             }
 
-            const_iterator& operator++(void) {
+            checked_const_iterator& operator++(void) {
                 validate_base();
                 _ptr = _ptr + 1;
                 return *this;
             }
 
-            const_iterator& operator--(void) {
+            checked_const_iterator& operator--(void) {
                 validate_base();
                 _ptr = _ptr - 1;
                 return *this;
             }
 
-            ~const_iterator() {
+            checked_const_iterator operator++(int) {
+                checked_const_iterator t{ *this };
+                ++*this;
+                return t;
+            }
+
+            checked_const_iterator operator--(int) {
+                checked_const_iterator t{ *this };
+                --*this;
+                return t;
+            }
+
+            checked_const_iterator& operator+=(int64_t offset) {
+                validate_base();
+                _ptr = _ptr + offset;
+                return *this;
+            }
+
+            checked_const_iterator& operator-=(int64_t offset) {
+                validate_base();
+                _ptr = _ptr - offset;
+                return *this;
+            }
+
+            checked_const_iterator operator-(int64_t offset) const {
+                return *this + (-offset);
+            }
+
+            friend checked_const_iterator operator+(int64_t offset, const checked_const_iterator& it) {
+                return it + offset;
+            }
+
+            bool operator<(const checked_const_iterator& rhs) const {
+                validate_base();
+                return _ptr < rhs._ptr;
+            }
+
+            bool operator>(const checked_const_iterator& rhs) const {
+                return rhs < *this;
+            }
+
+            bool operator<=(const checked_const_iterator& rhs) const {
+                return !(rhs < *this);
+            }
+
+            bool operator>=(const checked_const_iterator& rhs) const {
+                return !(*this < rhs);
+            }
+
+            ~checked_const_iterator() {
+                release();
+            }
+
+        private :
+            void release() {
                 //
-                // The destructor of the const_iterator object
+                // Drops this iterator's reference to its control block.
                 // It decrements the control block, and destructs it only if
                 // the version is invalid and the refcount is 0 - this means that neither
                 // the vector nor any other iterator is using this block.
                 //
-                this->_ctrlBlk->decRef();
-                if (this->_ctrlBlk->_version == INT_MIN &&
-                    this->_ctrlBlk->_refs == 0) {
-                    delete(this->_ctrlBlk);
+                if (this->_ctrlBlk == nullptr) {
+                    return;
+                }
+                if (this->_ctrlBlk->decRef()) {
+                    CtrlBlk::release(this->_ctrlBlk);
                 }
+                this->_ctrlBlk = nullptr;
             }
         };
 
-        struct iterator : public const_iterator {
+        struct checked_iterator : public checked_const_iterator {
         public:
-            iterator() = delete;
-            
-            iterator(T* ptr, T* begin, T* end, CtrlBlk* ctrlBlk) : const_iterator(ptr, begin, end, ctrlBlk) {}
+            checked_iterator() = default;
 
-            iterator(const iterator& other) : const_iterator(other) {};
+            checked_iterator(T* ptr, T* begin, T* end, CtrlBlk* ctrlBlk) : checked_const_iterator(ptr, begin, end, ctrlBlk) {}
 
-            T& operator*(void) {
-                validate_deref();
-                return *_ptr;
+            checked_iterator(const checked_iterator& other) : checked_const_iterator(other) {};
+
+            checked_iterator& operator=(const checked_iterator& rhs) {
+                checked_const_iterator::operator=(rhs);
+                return *this;
             }
 
-            iterator& operator++(void) {
-                validate_base();
-                _ptr = _ptr + 1;
+            using reference = T&;
+            using pointer = T*;
+            using checked_const_iterator::operator-;
+
+            T& operator*(void) const {
+                this->validate_deref();
+                return *this->_ptr;
+            }
+
+            T* operator->(void) const {
+                this->validate_deref();
+                return this->_ptr;
+            }
+
+            T& operator[](int64_t offset) const {
+                this->validate_deref(this->_ptr + offset);
+                return this->_ptr[offset];
+            }
+
+            checked_iterator operator+(int64_t offset) const {
+                this->validate_base();
+                checked_iterator t{ *this };
+                t._ptr = t._ptr + offset;
+                return t;
+            }
+
+            checked_iterator operator-(int64_t offset) const {
+                return *this + (-offset);
+            }
+
+            friend checked_iterator operator+(int64_t offset, const checked_iterator& it) {
+                return it + offset;
+            }
+
+            checked_iterator& operator++(void) {
+                this->validate_base();
+                this->_ptr = this->_ptr + 1;
                 return *this;
             }
 
-            iterator& operator--(void) {
-                validate_base();
-                _ptr = _ptr - 1;
+            checked_iterator& operator--(void) {
+                this->validate_base();
+                this->_ptr = this->_ptr - 1;
                 return *this;
             }
-            
-            operator const_iterator() {
-                return *(static_cast<const_iterator*>(this));
-            } 
 
-            ~iterator() {
+            checked_iterator operator++(int) {
+                checked_iterator t{ *this };
+                ++*this;
+                return t;
             }
-            
 
-//            iterator& operator=(iterator& rhs)
-//            {
-//                _ptr = rhs._ptr;
-//                return *this;
-//            }
-        };
-        
-        Vector(void) {
-            //
-            // Creates an array with a minimum capacity of 8, and length equal to 0
-            // Must not call T::T(void).
-            //
-            init(0);
-#ifdef _DBG_
-            cout << "epl::Vector::Default constructor of Vector. Created vector of size: 8" << endl;
-#endif
-        }
+            checked_iterator operator--(int) {
+                checked_iterator t{ *this };
+                --*this;
+                return t;
+            }
 
-        explicit Vector(uint64_t n) {
-            //
-            // Create an array with capacity and length exactly equal to 'n'. 
-            // Initialize the 'n' objects using T::T(void). As a special case, if 'n' is 
-            // equal to zero, duplicates the behavior of Vector(void)
-            //
-            init(n);
-#ifdef _DBG_
-            cout << "epl::Vector::Explicit constructor of Vector. Created vector of size: " << n << endl;
-#endif
-        }
+            checked_iterator& operator+=(int64_t offset) {
+                checked_const_iterator::operator+=(offset);
+                return *this;
+            }
 
-        Vector(const Vector& other) {
-            //
-            // Copy constructor - calls the private copy method
-            //
-#ifdef _DBG_
-            cout << "epl::Vector::Copy constructor called." << endl;
-#endif 
-            copy(other);
-        }
+            checked_iterator& operator-=(int64_t offset) {
+                checked_const_iterator::operator-=(offset);
+                return *this;
+            }
 
-        Vector(Vector&& other) {
-            //
-            // Move constructor - shallow copying the data from the Vector on the 
-            // rhs and setting all the state on the rhs to such values that will make its 
-            // destruction a no-op.
-            //
-#ifdef _DBG_
-            cout << "epl::Vector::Move constructor called." << endl;
-#endif
-            this->_buffer = other._buffer;
-            this->_buffer_end = other._buffer_end;
-            this->_front = other._front;
-            this->_back = other._back;
-            this->_length = other._length;
-            this->_ctrlBlk = other._ctrlBlk;
-            other._buffer = nullptr;
-            other._buffer_end = nullptr;
-            other._front = nullptr;
-            other._back = nullptr;
-            other._length = 0;
-            other._ctrlBlk = nullptr;
-        }
+            ~checked_iterator() {
+            }
+        };
+
+        struct bounded_const_iterator {
+            friend class Vector;
 
-        Vector(std::initializer_list<T> init_list) {
+        protected :
             //
-            // A constructor for the vector with a std::initializer_list as the argument
-            // The constructor iterates over the contents of the list and calls 
-            // the emplace_back method of the vector which takes care of amortized doubling
+            // Iterator for checking::bounds. It remembers the live range of the vector at the
+            // time it was created and only range checks dereferences against it; there is no
+            // control block and hence no invalidation diagnostics.
             //
-            alloc(init_list.end() - init_list.begin());
-            this->_ctrlBlk = new CtrlBlk(1);
-            for (auto iter = init_list.begin(); iter != init_list.end(); iter++) {
-                this->emplace_back(*iter);
+            T *_ptr, *_begin, *_end;
+
+            void validate_deref() const {
+                validate_deref(this->_ptr);
             }
-        }
- 
-        Vector& operator=(const Vector& other) {
-            //
-            // Copy assignment operator
-            //
-#ifdef _DBG_
-            cout << "epl::Vector::Copy assignment operator called." << endl;
-#endif
-            if (this != &other) {
-                destroy(CtrlBlk::COPY_ASSIGN);
-                copy(other);
+
+            void validate_deref(const T* ptr) const {
+                if (ptr < this->_begin || ptr >= this->_end) {
+                    throw std::out_of_range("Dereferencing pointer out of valid range.");
+                }
             }
-            return *this;
-        }
 
-        Vector& operator=(Vector&& other) {
-            //
-            // Move assignment operator - swapping state with the rhs
-            // When the rhs gets cleaned, the earlier state of this object will be cleaned
-            //
-#ifdef _DBG_
-            cout << "epl::Vector::Move assignment operator called." << endl;
-#endif
-            std::swap(_buffer, other._buffer);
-            std::swap(_front, other._front);
-            std::swap(_back, other._back);
-            std::swap(_buffer_end, other._buffer_end);
-            std::swap(_length, other._length);
-            std::swap(_ctrlBlk, other._ctrlBlk);
-            other.update_ctrlBlk(CtrlBlk::MOVE_ASSIGN);
-        }
+        public :
+            friend struct detail::vector_access;
 
-        ~Vector(void) {
-            // 
-            // Destructor - simply calls the private destruction method
-            //
-#ifdef _DBG_
-            cout << "epl::Vector::Destructor called." << endl;
+            bounded_const_iterator() : _ptr(nullptr), _begin(nullptr), _end(nullptr) {}
+
+            bounded_const_iterator(T* ptr, T* begin, T* end) : _ptr(ptr), _begin(begin), _end(end) {}
+
+            using value_type = T;
+            using iterator_category = std::random_access_iterator_tag;
+#if __cplusplus > 201703L
+            using iterator_concept = std::contiguous_iterator_tag;
 #endif
-            destroy(CtrlBlk::DESTROY);
-        }
+            using reference = const T&;
+            using pointer = const T*;
+            using difference_type = int64_t;
 
-        uint64_t size(void) const {
-            //
-            // Method to return the number of elements in the Vector
-            // Follows the below illustrated scheme
-            // -----------------------------------------
-            // |   | o | o | o | o | o |   |   |   |   |
+            const T& operator*(void) const {
+                validate_deref();
+                return *_ptr;
+            }
+
+            const T* operator->(void) const {
+                validate_deref();
+                return _ptr;
+            }
+
+            const T& operator[](int64_t offset) const {
+                validate_deref(_ptr + offset);
+                return _ptr[offset];
+            }
+
+            bool operator==(const bounded_const_iterator& rhs) const {
+                return _ptr == rhs._ptr;
+            }
+
+            bool operator!=(const bounded_const_iterator& rhs) const {
+                return _ptr != rhs._ptr;
+            }
+
+            int64_t operator-(const bounded_const_iterator& rhs) const {
+                return (_ptr - rhs._ptr);
+            }
+
+            bounded_const_iterator operator+(int64_t offset) const {
+                return bounded_const_iterator(_ptr + offset, _begin, _end);
+            }
+
+            bounded_const_iterator& operator++(void) {
+                _ptr = _ptr + 1;
+                return *this;
+            }
+
+            bounded_const_iterator& operator--(void) {
+                _ptr = _ptr - 1;
+                return *this;
+            }
+
+            bounded_const_iterator operator++(int) {
+                bounded_const_iterator t{ *this };
+                _ptr = _ptr + 1;
+                return t;
+            }
+
+            bounded_const_iterator operator--(int) {
+                bounded_const_iterator t{ *this };
+                _ptr = _ptr - 1;
+                return t;
+            }
+
+            bounded_const_iterator& operator+=(int64_t offset) {
+                _ptr = _ptr + offset;
+                return *this;
+            }
+
+            bounded_const_iterator& operator-=(int64_t offset) {
+                _ptr = _ptr - offset;
+                return *this;
+            }
+
+            bounded_const_iterator operator-(int64_t offset) const {
+                return bounded_const_iterator(_ptr - offset, _begin, _end);
+            }
+
+            friend bounded_const_iterator operator+(int64_t offset, const bounded_const_iterator& it) {
+                return it + offset;
+            }
+
+            bool operator<(const bounded_const_iterator& rhs) const {
+                return _ptr < rhs._ptr;
+            }
+
+            bool operator>(const bounded_const_iterator& rhs) const {
+                return _ptr > rhs._ptr;
+            }
+
+            bool operator<=(const bounded_const_iterator& rhs) const {
+                return _ptr <= rhs._ptr;
+            }
+
+            bool operator>=(const bounded_const_iterator& rhs) const {
+                return _ptr >= rhs._ptr;
+            }
+        };
+
+        struct bounded_iterator : public bounded_const_iterator {
+        public:
+            bounded_iterator() = default;
+
+            bounded_iterator(T* ptr, T* begin, T* end) : bounded_const_iterator(ptr, begin, end) {}
+
+            using reference = T&;
+            using pointer = T*;
+            using bounded_const_iterator::operator-;
+
+            T& operator*(void) const {
+                this->validate_deref();
+                return *this->_ptr;
+            }
+
+            T* operator->(void) const {
+                this->validate_deref();
+                return this->_ptr;
+            }
+
+            T& operator[](int64_t offset) const {
+                this->validate_deref(this->_ptr + offset);
+                return this->_ptr[offset];
+            }
+
+            bounded_iterator operator+(int64_t offset) const {
+                return bounded_iterator(this->_ptr + offset, this->_begin, this->_end);
+            }
+
+            bounded_iterator operator-(int64_t offset) const {
+                return bounded_iterator(this->_ptr - offset, this->_begin, this->_end);
+            }
+
+            friend bounded_iterator operator+(int64_t offset, const bounded_iterator& it) {
+                return it + offset;
+            }
+
+            bounded_iterator& operator++(void) {
+                this->_ptr = this->_ptr + 1;
+                return *this;
+            }
+
+            bounded_iterator& operator--(void) {
+                this->_ptr = this->_ptr - 1;
+                return *this;
+            }
+
+            bounded_iterator operator++(int) {
+                bounded_iterator t{ *this };
+                this->_ptr = this->_ptr + 1;
+                return t;
+            }
+
+            bounded_iterator operator--(int) {
+                bounded_iterator t{ *this };
+                this->_ptr = this->_ptr - 1;
+                return t;
+            }
+
+            bounded_iterator& operator+=(int64_t offset) {
+                this->_ptr = this->_ptr + offset;
+                return *this;
+            }
+
+            bounded_iterator& operator-=(int64_t offset) {
+                this->_ptr = this->_ptr - offset;
+                return *this;
+            }
+        };
+
+        //
+        // The iterator types handed out by the vector depend on the checking policy:
+        // checking::full uses the control block checked iterators, checking::bounds
+        // the range checked ones, and checking::none plain pointers.
+        //
+        typedef typename std::conditional<Checking::tracks_versions, checked_const_iterator,
+            typename std::conditional<Checking::checks_bounds, bounded_const_iterator, const T*>::type>::type const_iterator;
+        typedef typename std::conditional<Checking::tracks_versions, checked_iterator,
+            typename std::conditional<Checking::checks_bounds, bounded_iterator, T*>::type>::type iterator;
+        
+        Vector(void) {
+            //
+            // Creates an array with a minimum capacity of 8, and length equal to 0
+            // Must not call T::T(void).
+            //
+            init_empty();
+#ifdef _DBG_
+            cout << "epl::Vector::Default constructor of Vector. Created vector of size: 8" << endl;
+#endif
+        }
+
+        explicit Vector(const Alloc& allocator) : _alloc(allocator) {
+            //
+            // Same as above, but all memory comes from the given allocator
+            //
+            init_empty();
+#ifdef _DBG_
+            cout << "epl::Vector::Default constructor of Vector. Created vector of size: 8" << endl;
+#endif
+        }
+
+        explicit Vector(uint64_t n) {
+            //
+            // Create an array with capacity and length exactly equal to 'n'. 
+            // Initialize the 'n' objects using T::T(void). As a special case, if 'n' is 
+            // equal to zero, duplicates the behavior of Vector(void)
+            //
+            init(n);
+#ifdef _DBG_
+            cout << "epl::Vector::Explicit constructor of Vector. Created vector of size: " << n << endl;
+#endif
+        }
+
+        Vector(uint64_t n, const Alloc& allocator) : _alloc(allocator) {
+            //
+            // Same as above, but all memory comes from the given allocator
+            //
+            init(n);
+        }
+
+        Vector(const Vector& other) : _alloc(alloc_traits::select_on_container_copy_construction(other._alloc)) {
+            //
+            // Copy constructor - calls the private copy method
+            //
+#ifdef _DBG_
+            cout << "epl::Vector::Copy constructor called." << endl;
+#endif 
+            copy(other);
+        }
+
+        Vector(Vector&& other) : _alloc(std::move(other._alloc)) {
+            //
+            // Move constructor - shallow copying the data from the Vector on the 
+            // rhs and setting all the state on the rhs to such values that will make its 
+            // destruction a no-op.
+            //
+#ifdef _DBG_
+            cout << "epl::Vector::Move constructor called." << endl;
+#endif
+            if (other.is_inline()) {
+                //
+                // The elements live inside the rhs object (a SmallVector), so they have to
+                // be moved over to a heap buffer of our own. The rhs is left empty on its
+                // inline storage, and its iterators are invalidated.
+                //
+                alloc(other._buffer_end - other._buffer);
+                _front = _buffer + (other._front - other._buffer);
+                _back = _front + other._length;
+                _length = other._length;
+                _ctrlBlk = fresh_ctrlBlk();
+                relocate(_front, other._front, other._length);
+                other._front = other._buffer;
+                other._back = other._buffer;
+                other._length = 0;
+                other.update_ctrlBlk(CtrlBlk::MOVE_ASSIGN, nullptr, nullptr, nullptr);
+                return;
+            }
+            this->_buffer = other._buffer;
+            this->_buffer_end = other._buffer_end;
+            this->_front = other._front;
+            this->_back = other._back;
+            this->_length = other._length;
+            this->_ctrlBlk = other._ctrlBlk;
+            other._buffer = nullptr;
+            other._buffer_end = nullptr;
+            other._front = nullptr;
+            other._back = nullptr;
+            other._length = 0;
+            other._ctrlBlk = other.fresh_ctrlBlk();
+#ifdef _EPL_STATS_
+            this->_stats.capacity(this->_buffer_end - this->_buffer);
+#endif
+        }
+
+        Vector(std::initializer_list<T> init_list, const Alloc& allocator = Alloc()) : _alloc(allocator) {
+            //
+            // A constructor for the vector with a std::initializer_list as the argument
+            // The buffer is sized to the list once and the elements are copy constructed
+            // straight into it
+            //
+            init_range(init_list.begin(), init_list.end());
+        }
+
+        template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+        Vector(InputIt first, InputIt last, const Alloc& allocator = Alloc()) : _alloc(allocator) {
+            //
+            // Range constructor. Forward ranges are measured first so the buffer is
+            // allocated exactly once; single pass ranges grow by doubling as they go.
+            //
+            init_range(first, last);
+        }
+ 
+        Vector& operator=(const Vector& other) {
+            //
+            // Copy assignment operator
+            //
+#ifdef _DBG_
+            cout << "epl::Vector::Copy assignment operator called." << endl;
+#endif
+            if (this != &other) {
+                destroy(CtrlBlk::COPY_ASSIGN);
+                if constexpr (alloc_traits::propagate_on_container_copy_assignment::value) {
+                    _alloc = other._alloc;
+                }
+                copy(other);
+            }
+            return *this;
+        }
+
+        Vector& operator=(Vector&& other) {
+            //
+            // Move assignment operator - swapping state with the rhs
+            // When the rhs gets cleaned, the earlier state of this object will be cleaned
+            //
+#ifdef _DBG_
+            cout << "epl::Vector::Move assignment operator called." << endl;
+#endif
+            if (this == &other) {
+                return *this;
+            }
+            if ((!alloc_traits::propagate_on_container_move_assignment::value && !(_alloc == other._alloc)) ||
+                is_inline() || other.is_inline()) {
+                //
+                // The buffer of the rhs belongs to a different allocator, or one of the two
+                // buffers is embedded in a SmallVector, so buffers cannot be swapped. Move the
+                // elements one by one into memory from our own allocator instead, which leaves
+                // the rhs holding moved-from elements.
+                //
+                destroy(CtrlBlk::MOVE_ASSIGN);
+                move_elements(other);
+                return *this;
+            }
+            std::swap(_buffer, other._buffer);
+            std::swap(_front, other._front);
+            std::swap(_back, other._back);
+            std::swap(_buffer_end, other._buffer_end);
+            std::swap(_length, other._length);
+            std::swap(_ctrlBlk, other._ctrlBlk);
+            if constexpr (alloc_traits::propagate_on_container_move_assignment::value) {
+                std::swap(_alloc, other._alloc);
+            }
+            other.update_ctrlBlk(CtrlBlk::MOVE_ASSIGN, nullptr, nullptr, nullptr);
+            return *this;
+        }
+
+        ~Vector(void) {
+            // 
+            // Destructor - simply calls the private destruction method
+            //
+#ifdef _DBG_
+            cout << "epl::Vector::Destructor called." << endl;
+#endif
+            destroy(CtrlBlk::DESTROY);
+        }
+
+        allocator_type get_allocator(void) const {
+            //
+            // Returns a copy of the allocator used for the buffer and the control blocks
+            //
+            return _alloc;
+        }
+
+#ifdef _EPL_STATS_
+        vector_stats stats(void) const {
+            //
+            // The counters of this vector (see VectorStats.h) and its current layout
+            //
+            if (_buffer == nullptr) {
+                return _stats.snapshot(0, 0, 0, 0);
+            }
+            return _stats.snapshot(_buffer_end - _buffer, _length, _front - _buffer, _buffer_end - _back);
+        }
+#endif
+
+        uint64_t size(void) const {
+            //
+            // Method to return the number of elements in the Vector
+            // Follows the below illustrated scheme
+            // -----------------------------------------
+            // |   | o | o | o | o | o |   |   |   |   |
             // -----------------------------------------
             //   0   1   2   3   4   5   6   7   8   9
             //       ^                   ^
@@ -490,33 +1288,75 @@ namespace epl
                 return const_cast<const T&>(_front[k]);
             }
         }
+
+        T* data(void) {
+            //
+            // Pointer to the first element; the live range is the 'size()' contiguous
+            // elements from there. Like any raw pointer it is not checked: it stays
+            // valid until the next change to the vector.
+            //
+            return _front;
+        }
+
+        const T* data(void) const {
+            return _front;
+        }
+
+        T& at_unchecked(uint64_t k) {
+            //
+            // Element 'k' without the range check of operator[]. 'k' has to be less
+            // than size().
+            //
+            return _front[k];
+        }
+
+        const T& at_unchecked(uint64_t k) const {
+            return _front[k];
+        }
+
+        template <typename F>
+        void for_each_checked(F f) {
+            //
+            // Calls f(element) for every element, front to back, over raw pointers. The
+            // control block is checked once before the loop and once after it, instead
+            // of on every step as when looping over the iterators. f must not change the
+            // vector: a change is reported when the loop is done (with the
+            // invalid_iterator an iterator held across it would throw), not prevented.
+            //
+            for_each_checked_impl<T>(*this, f);
+        }
+
+        template <typename F>
+        void for_each_checked(F f) const {
+            for_each_checked_impl<const T>(*this, f);
+        }
         
         iterator begin() {
             //
             // Returns an iterator to the _front of the vector
             //
-            return iterator(_front, _front, _back, _ctrlBlk);
+            return make_iterator<iterator>(_front);
         }
 
         const_iterator begin() const {
             //
             // Returns a const iterator to the _front of the vector
             //
-            return const_iterator(_front, _front, _back, _ctrlBlk);
+            return make_iterator<const_iterator>(_front);
         }
 
         iterator end() {
             //
             // Returns an iterator to the _back of the vector
             //
-            return iterator(_back, _front, _back, _ctrlBlk);
+            return make_iterator<iterator>(_back);
         }
 
         const_iterator end() const {
             //
             // Returns a const iterator to the _back of the vector
             //
-            return const_iterator(_back, _front, _back, _ctrlBlk);
+            return make_iterator<const_iterator>(_back);
         }
 
         template <typename... Args>
@@ -527,291 +1367,418 @@ namespace epl
             // constructor calls) this method directly calls the constructor by forwarding the
             // arguments to the constructor in place.
             //
-            T* new_ptr = _buffer, *old_front = _front, *old_back = _back;
-            uint64_t current_buffer_size = (_buffer_end - _buffer), offset = 0, old_buffer_size, old_length = _length;
-            old_buffer_size = current_buffer_size;
-
-            if (_back == _buffer_end) {
-                //
-                // The next point to insert the object is past the last cell
-                // Amortized doubling of the array is in order
-                // In this case _front and _back do not change, as all new memory is to the end
-                //
-                current_buffer_size = current_buffer_size * 2;
-                new_ptr = (T *) operator new ((size_t)current_buffer_size * sizeof(T));
-                _front = new_ptr + (_front - _buffer);
-                _back = new_ptr + (_back - _buffer);
-                _buffer_end = new_ptr + current_buffer_size;
-#ifdef _DBG_
-                cout << "epl::Vector::emplace_back(Args...) reallocated to new size: " << current_buffer_size << endl;
+            insert_back(CtrlBlk::invalidate_reason::EMPLACE_BACK, std::forward<Args>(args)...);
+#ifdef _DBG_ 
+            cout << "epl::Vector::emplace_back(Args...) called. Pushed to: " << (_back - 1 - _buffer) << endl;
 #endif
-            }
+        }
+        
+        void push_back(const T& val) {
             //
-            // Copy constructing the object at the last location - check??!
+            // Adds a new value to the end of the array, growing the buffer according to the
+            // growth policy if there is no room at the back. The argument is copy constructed.
             //
-            _length++;
-            new (_back)T{ std::forward<Args>(args)... };
+            insert_back(CtrlBlk::invalidate_reason::PUSH_BACK, val);
 #ifdef _DBG_ 
-            cout << "epl::Vector::emplace_back(Args...) called. Pushed to: " << (_back - new_ptr) / sizeof(T) << endl;
+            cout << "epl::Vector::push_back(const T& val) called. Pushed to: " << (_back - 1 - _buffer) << endl;
 #endif
-            _back++;
+        }
+        
+        void push_back(T&& val) {
             //
-            // In case the buffer was reallocated, there are 2 things to do
-            // Move construct the earlier object to the new buffer and
-            // Destruct the earlier object
+            // Same as above, but the argument is move constructed.
             //
-            if (new_ptr != _buffer) {
-                for (uint64_t k = 0; k < old_length; k++) {
-                    new (_front + k) T{ std::move(old_front[k]) };
-                    old_front[k].T::~T();
-                }
-                operator delete(_buffer);
-                _buffer = new_ptr;
-            }
-
-            update_ctrlBlk(CtrlBlk::invalidate_reason::EMPLACE_BACK, (_back - 1), _front, _back);
+            insert_back(CtrlBlk::invalidate_reason::PUSH_BACK, std::move(val));
+#ifdef _DBG_ 
+            cout << "epl::Vector::push_back(T&& val) called. Pushed to: " << (_back - 1 - _buffer) << endl;
+#endif
         }
         
-        void push_back(const T& val) {
+        void push_front(const T& val) {
             //
-            // Adds a new value to the end of the array, using amortized doubling if the array
-            // has to be resized. The argument is copy constructed.
+            // Similar to push_back but the element is added to the front of the Vector
+            // The argument is copy constructed.
             //
-            T* new_ptr = _buffer, *old_front = _front, *old_back = _back;
-            uint64_t current_buffer_size = (_buffer_end - _buffer), offset = 0, old_buffer_size, old_length = _length;
-            old_buffer_size = current_buffer_size;
-
-            if (_back == _buffer_end) {
-                //
-                // The next point to insert the object is past the last cell
-                // Amortized doubling of the array is in order
-                // In this case _front and _back do not change, as all new memory is to the end
-                //
-                current_buffer_size = current_buffer_size * 2;
-                new_ptr = (T *) operator new ((size_t)current_buffer_size * sizeof(T));
-                _front = new_ptr + (_front - _buffer);
-                _back = new_ptr + (_back - _buffer);
-                _buffer_end = new_ptr + current_buffer_size;
-#ifdef _DBG_
-                cout << "epl::Vector::push_back(const T& val) reallocated to new size: " << current_buffer_size << endl;
+            insert_front(CtrlBlk::invalidate_reason::PUSH_FRONT, val);
+#ifdef _DBG_ 
+            cout << "epl::Vector::push_front(const T& val) called. Pushed to: " << (_front - _buffer) << endl;
 #endif
-            }
+        }
+
+        void push_front(T&& val) {
             //
-            // Copy constructing the object at the last location - check??!
+            // Same as above, but the argument is move constructed.
             //
-            _length++;
-            new (_back) T{ val };
+            insert_front(CtrlBlk::invalidate_reason::PUSH_FRONT, std::move(val));
 #ifdef _DBG_ 
-            cout << "epl::Vector::push_back(const T& val) called. Pushed to: " << ((_back - new_ptr)/sizeof(T)) << endl;
+            cout << "epl::Vector::push_front(T&& val) called. Pushed to: " << (_front - _buffer) << endl;
 #endif
-            _back++;
+        }
+
+        void pop_back(void) {
             //
-            // In case the buffer was reallocated, there are 2 things to do
-            // Move construct the earlier object to the new buffer and
-            // Destruct the earlier object
+            // Object at the end is destroyed, and length is updated (and any other pointers).
+            // Storage is not reallocated, even if vector becomes empty. Capacity increases by 1. 
+            // It is possible that a Vector has capacity at both the front and back simultaneously.
+            // If the array is empty a std::out_of_range exception is thrown.
             //
-            if (new_ptr != _buffer) {
-                for (uint64_t k = 0; k < old_length; k++) {
-                    new (_front + k) T{ std::move(old_front[k]) };
-                    old_front[k].T::~T();
-                }
-                operator delete(_buffer);
-                _buffer = new_ptr;
+            if (_length != 0) {
+                _back--;
+                _back[0].T::~T();
+                _length--;
+#ifdef _DBG_ 
+                cout << "epl::Vector::pop_back() called. Popping from " << ((_back - _buffer)/sizeof(T)) + 1 << endl;
+#endif
+            }
+            else {
+                throw std::out_of_range("Cannot invoke pop_back() when the container is empty.");
             }
 
-            update_ctrlBlk(CtrlBlk::invalidate_reason::PUSH_BACK, (_back - 1), _front, _back);
+            update_ctrlBlk(CtrlBlk::invalidate_reason::POP_BACK, _back, _front, _back);
         }
         
-        void push_back(T&& val) {
+        void pop_front(void) {
             //
-            // Same as above, but the argument is move constructed.
+            // Same as above, except that the element is removed from the front.
             //
-            T* new_ptr = _buffer, *old_front = _front, *old_back = _back;
-            uint64_t current_buffer_size = (_buffer_end - _buffer), offset = 0, old_buffer_size, old_length = _length;
-            old_buffer_size = current_buffer_size;
-
-            if (_back == _buffer_end) {
-                //
-                // The next point to insert the object is past the last cell
-                // Amortized doubling of the array is in order
-                // In this case _front and _back do not change, as all new memory is to the end
-                //
-                current_buffer_size = current_buffer_size * 2;
-                new_ptr = (T *) operator new ((size_t)current_buffer_size * sizeof(T));
-                _front = new_ptr + (_front - _buffer);
-                _back = new_ptr + (_back - _buffer);
-                _buffer_end = new_ptr + current_buffer_size;
-#ifdef _DBG_
-                cout << "epl::Vector::push_back(T&& val) reallocated to new size: " << current_buffer_size << endl;
+            if (_length != 0) {
+                _front[0].T::~T();
+                 _front++;
+                _length--;
+#ifdef _DBG_ 
+                cout << "epl::Vector::pop_back() called. Popping from " << ((_front - _buffer)/sizeof(T)) - 1 << endl;
 #endif
             }
+            else {
+                throw std::out_of_range("Cannot invoke pop_front() when the container is empty.");
+            }
+
+            update_ctrlBlk(CtrlBlk::invalidate_reason::POP_FRONT, (_front - 1), _front, _back);
+        }
+
+        void pop_back(uint64_t n) {
             //
-            // Copy constructing the object at the last location - check??!
+            // Removes the last 'n' elements at once: their destructors run in one pass and
+            // the control block is updated once. Throws std::out_of_range (and removes
+            // nothing) if there are fewer than 'n' elements.
             //
-            _length++;
-            new (_back) T{ std::move(val) };
-#ifdef _DBG_ 
-            cout << "epl::Vector::push_back(T&& val) called. Pushed to: " << ((_back - new_ptr)/sizeof(T))  << endl;
+            if (n > _length) {
+                throw std::out_of_range("Cannot pop_back() more elements than the container holds.");
+            }
+            if (n == 0) {
+                return;
+            }
+            T* old_back = _back;
+            destroy_range(_back - n, _back);
+            _back -= n;
+            _length -= n;
+#ifdef _DBG_
+            cout << "epl::Vector::pop_back(n) called. Popped " << n << " elements" << endl;
 #endif
-            _back++;
+            update_ctrlBlk(CtrlBlk::invalidate_reason::POP_BACK, _back, old_back, _front, _back);
+        }
+
+        void pop_front(uint64_t n) {
             //
-            // In case the buffer was reallocated, there are 2 things to do
-            // Move construct the earlier objects to the new buffer and
-            // Destruct the earlier objects
+            // Same as above for the first 'n' elements
             //
-            if (new_ptr != _buffer) {
-                for (uint64_t k = 0; k < old_length; k++) {
-                    new (_front + k) T{ std::move(old_front[k]) };
-                    old_front[k].T::~T();
-                }
-                operator delete(_buffer);
-                _buffer = new_ptr;
+            if (n > _length) {
+                throw std::out_of_range("Cannot pop_front() more elements than the container holds.");
             }
-
-            update_ctrlBlk(CtrlBlk::invalidate_reason::PUSH_BACK, (_back - 1), _front, _back);
+            if (n == 0) {
+                return;
+            }
+            T* old_front = _front;
+            destroy_range(_front, _front + n);
+            _front += n;
+            _length -= n;
+#ifdef _DBG_
+            cout << "epl::Vector::pop_front(n) called. Popped " << n << " elements" << endl;
+#endif
+            update_ctrlBlk(CtrlBlk::invalidate_reason::POP_FRONT, old_front, _front, _front, _back);
         }
-        
-        void push_front(const T& val) {
-            //
-            // Similar to push_back but the element is added to the front of the Vector
-            // The argument is copy constructed.
-            //
-            T* new_ptr = _buffer, *old_front = _front, *old_back = _back;
-            uint64_t current_buffer_size = (_buffer_end - _buffer), offset = 0, old_buffer_size, old_length = _length;
-            old_buffer_size = current_buffer_size;
 
-            if (_front == _buffer) {
+        iterator erase(const_iterator first, const_iterator last) {
+            //
+            // Removes the elements of [first, last) and returns an iterator to the element
+            // that followed them. The elements on the shorter side of the gap are moved to
+            // close it, so erasing near either end moves few elements; the free cells
+            // end up at that end. The erased elements are destroyed in one pass and the
+            // control block is updated once. Throws std::out_of_range if the range is not
+            // within the vector (and invalid_iterator for invalidated iterators).
+            //
+            T* from = const_cast<T*>(iterator_ptr(first));
+            T* to = const_cast<T*>(iterator_ptr(last));
+            if (from < _front || from > to || to > _back) {
+                throw std::out_of_range("Erasing a range outside of the container.");
+            }
+            uint64_t n = to - from;
+            if (n == 0) {
+                return make_iterator<iterator>(from);
+            }
+            uint64_t before = from - _front;
+            uint64_t after = _back - to;
+            if (before < after) {
                 //
-                // The next point to insert the object is before the first cell
-                // Amortized doubling of the array is in order
-                // _front and _back increase by _current_buffer_size - old_buffer_size
+                // Shift the elements before the gap towards the back
                 //
-                current_buffer_size = current_buffer_size * 2;
-                new_ptr = (T *) operator new ((size_t)current_buffer_size * sizeof(T));
-                offset = current_buffer_size - old_buffer_size;
-                _front = new_ptr + (_front - _buffer) + offset;
-                _back = new_ptr + (_back - _buffer) + offset;
-                _buffer_end = new_ptr + current_buffer_size;
+                T* old_front = _front;
+                if (is_trivially_relocatable<T>::value) {
+                    destroy_range(from, to);
+                    if (before > 0) {
+                        std::memmove(static_cast<void*>(_front + n), static_cast<const void*>(_front), (size_t)before * sizeof(T));
+                    }
+                }
+                else {
+                    std::move_backward(_front, from, to);
+                    destroy_range(_front, _front + n);
+                }
+                _front += n;
+                _length -= n;
+                update_ctrlBlk(CtrlBlk::invalidate_reason::POP_FRONT, old_front, _front, _front, _back);
+            }
+            else {
+                //
+                // Shift the elements after the gap towards the front
+                //
+                T* old_back = _back;
+                if (is_trivially_relocatable<T>::value) {
+                    destroy_range(from, to);
+                    if (after > 0) {
+                        std::memmove(static_cast<void*>(from), static_cast<const void*>(to), (size_t)after * sizeof(T));
+                    }
+                }
+                else {
+                    std::move(to, _back, from);
+                    destroy_range(_back - n, _back);
+                }
+                _back -= n;
+                _length -= n;
+                update_ctrlBlk(CtrlBlk::invalidate_reason::POP_BACK, _back, old_back, _front, _back);
+            }
+#ifdef _EPL_STATS_
+            _stats.moved(before < after ? before : after, sizeof(T));
+#endif
 #ifdef _DBG_
-                cout << "epl::Vector::push_front(const T& val) reallocated to new size: " << current_buffer_size << endl;
+            cout << "epl::Vector::erase(first, last) called. Erased " << n << " elements" << endl;
 #endif
-            }
+            return make_iterator<iterator>(_front + before);
+        }
+
+        void clear(void) {
             //
-            // Copy constructing the object at the first location
+            // Removes every element, keeping the buffer: the capacity is unchanged and all
+            // of it is free at the back again. Destructors run in one pass and the control
+            // block is updated once.
             //
-            _front--;_length++;
-            new (_front) T{ val };
-#ifdef _DBG_ 
-            cout << "epl::Vector::push_front(const T& val) called. Pushed to: " << ((_front - new_ptr)/sizeof(T)) << endl;
+            if (_length == 0) {
+                return;
+            }
+            T* old_front = _front;
+            T* old_back = _back;
+            destroy_range(_front, _back);
+            _front = _buffer;
+            _back = _buffer;
+            _length = 0;
+#ifdef _DBG_
+            cout << "epl::Vector::clear() called" << endl;
 #endif
+            update_ctrlBlk(CtrlBlk::invalidate_reason::POP_BACK, old_front, old_back, _front, _back);
+        }
+
+        uint64_t capacity(void) const {
             //
-            // In case the buffer was reallocated, there are 2 things to do
-            // Move construct the earlier objects to the new buffer and
-            // Destruct the earlier objects
+            // Total number of cells in the buffer, free cells at both ends included
             //
-            if (new_ptr != _buffer) {
-                for (uint64_t k = 0; k < old_length; k++) {
-                    new (_front + k + 1) T{ std::move(old_front[k]) };
-                    old_front[k].T::~T();
-                }
-                operator delete(_buffer);
-                _buffer = new_ptr;
-            }
-
-            update_ctrlBlk(CtrlBlk::invalidate_reason::PUSH_FRONT, _front, _front, _back);
+            return _buffer_end - _buffer;
         }
 
-        void push_front(T&& val) {
+        void reserve(uint64_t n) {
             //
-            // Same as above, but the argument is move constructed.
+            // Makes sure that the vector can hold 'n' elements without reallocating as long as
+            // it only grows at the back, i.e. (_buffer_end - _front) >= n. The free cells at the
+            // front are kept. Iterators are only invalidated if the buffer actually moves.
             //
-            T* new_ptr = _buffer, *old_front = _front, *old_back = _back;
-            uint64_t current_buffer_size = (_buffer_end - _buffer), offset = 0, old_buffer_size, old_length = _length;
-            old_buffer_size = current_buffer_size;
-
-            if (_front == _buffer) {
-                //
-                // The next point to insert the object is before the first cell
-                // Amortized doubling of the array is in order
-                // _front and _back increase by _current_buffer_size - old_buffer_size
-                //
-                current_buffer_size = current_buffer_size * 2;
-                new_ptr = (T *) operator new ((size_t)current_buffer_size * sizeof(T));
-                offset = current_buffer_size - old_buffer_size;
-                _front = new_ptr + (_front - _buffer) + offset;
-                _back = new_ptr + (_back - _buffer) + offset;
-                _buffer_end = new_ptr + current_buffer_size;
-#ifdef _DBG_
-                cout << "epl::Vector::push_front(T&& val) reallocated to new size: " << current_buffer_size << endl;
-#endif
+            if ((uint64_t)(_buffer_end - _front) >= n) {
+                return;
             }
+            reallocate((_front - _buffer) + n, _front - _buffer);
+            update_ctrlBlk(CtrlBlk::invalidate_reason::PUSH_BACK, nullptr, nullptr, _front, _back);
+        }
+
+        void reserve_front(uint64_t n) {
             //
-            // Copy constructing the object at the first location
+            // Same as above for growth at the front: afterwards (_back - _buffer) >= n
+            // and the free cells at the back are kept.
             //
-            _front--; _length++;
-            new (_front) T{ std::move(val) };
-#ifdef _DBG_ 
-            cout << "epl::Vector::push_front(T&& val) called. Pushed to: " << ((_front - new_ptr)/sizeof(T))<< endl;
-#endif
+            if ((uint64_t)(_back - _buffer) >= n) {
+                return;
+            }
+            reallocate(n + (_buffer_end - _back), n - _length);
+            update_ctrlBlk(CtrlBlk::invalidate_reason::PUSH_FRONT, nullptr, nullptr, _front, _back);
+        }
+
+        void resize(uint64_t n) {
             //
-            // In case the buffer was reallocated, there are 2 things to do
-            // Move construct the earlier objects to the new buffer and
-            // Destruct the earlier objects
+            // Grows the vector to 'n' elements by value initializing new elements at the
+            // back, or shrinks it by destroying elements at the back. The buffer is resized
+            // at most once and the control block is updated once.
             //
-            if (new_ptr != _buffer) {
-                for (uint64_t k = 0; k < old_length; k++) {
-                    new (_front + k + 1) T{ std::move(old_front[k]) };
-                    old_front[k].T::~T();
+            if (n > _length) {
+                T* old_back = _back;
+                if ((uint64_t)(_buffer_end - _front) < n) {
+                    reallocate((_front - _buffer) + n, _front - _buffer);
+                    old_back = _back;
                 }
-                operator delete(_buffer);
-                _buffer = new_ptr;
+                try {
+                    while (_length < n) {
+                        new (_back) T{};
+                        _back++;
+                        _length++;
+                    }
+                }
+                catch (...) {
+                    update_ctrlBlk(CtrlBlk::invalidate_reason::PUSH_BACK, old_back, _front, _back);
+                    throw;
+                }
+                update_ctrlBlk(CtrlBlk::invalidate_reason::PUSH_BACK, old_back, _front, _back);
             }
+            else if (n < _length) {
+                T* old_back = _back;
+                destroy_range(_front + n, _back);
+                _back = _front + n;
+                _length = n;
+                update_ctrlBlk(CtrlBlk::invalidate_reason::POP_BACK, _back, old_back, _front, _back);
+            }
+        }
+
+        template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+        void append(InputIt first, InputIt last) {
+            //
+            // Adds the elements of [first, last) at the back, in order. Forward ranges make
+            // room for all the elements with a single reallocation; single pass ranges grow
+            // by doubling as they go. Either way the control block is updated once.
+            // The range must not refer to elements of this vector.
+            //
+            T* old_back = _back;
+            try {
+                if constexpr (is_forward_iterator<InputIt>::value) {
+                    uint64_t n = (uint64_t)std::distance(first, last);
+                    reserve_slack_back(n);
+                    old_back = _back;
+                    construct_range(_back, first, n);
+                    _back += n;
+                    _length += n;
+                }
+                else {
+                    for (; first != last; ++first) {
+                        if (_back == _buffer_end) {
+                            reserve_slack_back(1);
+                        }
+                        new (_back) T{ *first };
+                        _back++;
+                        _length++;
+                    }
+                }
+            }
+            catch (...) {
+                update_ctrlBlk(CtrlBlk::invalidate_reason::PUSH_BACK, old_back, _front, _back);
+                throw;
+            }
+            update_ctrlBlk(CtrlBlk::invalidate_reason::PUSH_BACK, old_back, _front, _back);
+        }
 
+        template <typename InputIt, typename = typename std::iterator_traits<InputIt>::iterator_category>
+        void prepend(InputIt first, InputIt last) {
+            //
+            // Adds the elements of [first, last) at the front, keeping their order, so that
+            // the vector afterwards starts with *first. The buffer is resized at most once
+            // and the control block is updated once. Single pass ranges are buffered in a
+            // temporary vector first, since their length is not known up front.
+            // The range must not refer to elements of this vector.
+            //
+            try {
+                if constexpr (is_forward_iterator<InputIt>::value) {
+                    uint64_t n = (uint64_t)std::distance(first, last);
+                    reserve_slack_front(n);
+                    construct_range(_front - n, first, n);
+                    _front -= n;
+                    _length += n;
+                }
+                else {
+                    Vector tmp(first, last, _alloc);
+                    reserve_slack_front(tmp._length);
+                    relocate(_front - tmp._length, tmp._front, tmp._length);
+                    _front -= tmp._length;
+                    _length += tmp._length;
+                    tmp._back = tmp._front;
+                    tmp._length = 0;
+                }
+            }
+            catch (...) {
+                //
+                // The buffer may have been replaced before the elements failed to construct
+                //
+                update_ctrlBlk(CtrlBlk::invalidate_reason::PUSH_FRONT, _front, _front, _back);
+                throw;
+            }
             update_ctrlBlk(CtrlBlk::invalidate_reason::PUSH_FRONT, _front, _front, _back);
         }
 
-        void pop_back(void) {
+    protected:
+        friend struct detail::vector_access;
+
+        Vector(T* inline_buffer, uint64_t inline_capacity, const Alloc& allocator) : _alloc(allocator) {
             //
-            // Object at the end is destroyed, and length is updated (and any other pointers).
-            // Storage is not reallocated, even if vector becomes empty. Capacity increases by 1. 
-            // It is possible that a Vector has capacity at both the front and back simultaneously.
-            // If the array is empty a std::out_of_range exception is thrown.
+            // Used by SmallVector: the vector starts out on 'inline_capacity' elements of
+            // storage that live inside the derived object. That storage is never handed
+            // to the allocator; the first growth past it moves the elements to the heap.
             //
-            if (_length != 0) {
-                _back--;
-                _back[0].T::~T();
-                _length--;
-#ifdef _DBG_ 
-                cout << "epl::Vector::pop_back() called. Popping from " << ((_back - _buffer)/sizeof(T)) + 1 << endl;
+            _inline_buffer = inline_buffer;
+            _buffer = inline_buffer;
+            _buffer_end = inline_buffer + inline_capacity;
+            _front = _buffer;
+            _back = _buffer;
+            _length = 0;
+            _ctrlBlk = fresh_ctrlBlk();
+#ifdef _EPL_STATS_
+            _stats.capacity(inline_capacity);
 #endif
-            }
-            else {
-                throw std::out_of_range("Cannot invoke pop_back() when the container is empty.");
-            }
+        }
+
+        Vector(T* buffer, uint64_t capacity, uint64_t front, uint64_t length, const Alloc& allocator) : _alloc(allocator) {
+            //
+            // Used by MappedVector: takes over a buffer of 'capacity' cells obtained from
+            // 'allocator' that already holds 'length' elements starting at cell 'front'.
+            // Nothing is constructed.
+            //
+            _buffer = buffer;
+            _buffer_end = buffer + capacity;
+            _front = buffer + front;
+            _back = _front + length;
+            _length = length;
+            _ctrlBlk = fresh_ctrlBlk();
+#ifdef _EPL_STATS_
+            _stats.capacity(capacity);
+#endif
+        }
 
-            update_ctrlBlk(CtrlBlk::invalidate_reason::POP_BACK, _back, _front, _back);
+        bool is_inline(void) const {
+            return _inline_buffer != nullptr && _buffer == _inline_buffer;
         }
-        
-        void pop_front(void) {
+
+        bool grows_in_place(void) const {
             //
-            // Same as above, except that the element is removed from the front.
+            // True if the buffer can be resized by the allocator instead of being moved
             //
-            if (_length != 0) {
-                _front[0].T::~T();
-                 _front++;
-                _length--;
-#ifdef _DBG_ 
-                cout << "epl::Vector::pop_back() called. Popping from " << ((_front - _buffer)/sizeof(T)) - 1 << endl;
-#endif
+            if constexpr (allocator_reallocates<Alloc, T>::value && is_trivially_relocatable<T>::value) {
+                return _buffer != nullptr && !is_inline();
             }
             else {
-                throw std::out_of_range("Cannot invoke pop_front() when the container is empty.");
+                return false;
             }
-
-            update_ctrlBlk(CtrlBlk::invalidate_reason::POP_FRONT, (_front - 1), _front, _back);
         }
 
-    private:
         //
         // The array of objects currently in the Vector
         //
@@ -838,74 +1805,226 @@ namespace epl
         static const uint64_t initial_size = 8;
         //
         // The control block for maintaining version across vectors
-        // and iterators
+        // and iterators (created lazily, hence mutable)
         //
-        CtrlBlk* _ctrlBlk;
+        mutable CtrlBlk* _ctrlBlk;
+        //
+        // The allocator for the buffer and (rebound) for the control blocks
+        //
+        Alloc _alloc;
+        //
+        // Storage embedded in a derived SmallVector, nullptr for a plain Vector
+        //
+        T* _inline_buffer = nullptr;
+#ifdef _EPL_STATS_
+        //
+        // Performance counters, only kept when _EPL_STATS_ is defined
+        //
+        mutable detail::stats_recorder _stats;
+#endif
+
+        T* allocate_buffer(uint64_t n) {
+            //
+            // Raw storage for 'n' elements - nothing is constructed
+            //
+            return alloc_traits::allocate(_alloc, (size_t)n);
+        }
+
+        void deallocate_buffer(T* buffer, uint64_t n) {
+            if (buffer != nullptr && buffer != _inline_buffer) {
+                alloc_traits::deallocate(_alloc, buffer, (size_t)n);
+            }
+        }
+
+        CtrlBlk* ctrlBlk() const {
+            //
+            // Returns the current control block, creating it (version = 1) on first use.
+            // Until an iterator is handed out nothing can observe the version, so a
+            // vector that is never iterated never allocates a control block.
+            //
+            if (_ctrlBlk == nullptr) {
+                _ctrlBlk = CtrlBlk::create(1, _alloc);
+#ifdef _EPL_STATS_
+                _stats.ctrlblk_allocated();
+#endif
+            }
+            return _ctrlBlk;
+        }
+
+        CtrlBlk* fresh_ctrlBlk() const {
+            //
+            // The control block a (re)initialized vector starts out with. Normally none,
+            // see above. In the concurrent mode begin() may be called from several threads
+            // at once, so the block cannot be created lazily and is created right away.
+            //
+            if constexpr (Checking::atomic_refs) {
+#ifdef _EPL_STATS_
+                _stats.ctrlblk_allocated();
+#endif
+                return CtrlBlk::create(1, _alloc);
+            }
+            else {
+                return nullptr;
+            }
+        }
+
+        template <typename It>
+        It make_iterator(T* ptr) const {
+            //
+            // Builds an iterator of the type selected by the checking policy
+            //
+            if constexpr (Checking::tracks_versions) {
+                return It(ptr, _front, _back, ctrlBlk());
+            }
+            else if constexpr (Checking::checks_bounds) {
+                return It(ptr, _front, _back);
+            }
+            else {
+                return ptr;
+            }
+        }
 
         void alloc(size_t n) {
             //
             // Method for allocating memory, used by init and init_list constructor
             //
-            _buffer = (T *) operator new ((size_t)n * sizeof(T));
+            _buffer = allocate_buffer(n);
             _buffer_end = _buffer + n;
             _front = _buffer;
             _back = _buffer;
+#ifdef _EPL_STATS_
+            _stats.capacity(n);
+#endif
         }
         
+        void init_empty(void) {
+            //
+            // Private method for intializing an empty Vector. It only allocates space for
+            // initial_size elements, but does not call the constructor for those elements,
+            // so the default constructors work for element types without one.
+            //
+            alloc(initial_size);
+            _length = 0;
+            //
+            // The control block is only created once the first iterator is handed out
+            //
+            _ctrlBlk = fresh_ctrlBlk();
+        }
+
         void init(uint64_t n) {
             //
             // Private method for intializing the Vector class, used by both constructors
             //
             size_t size = static_cast<size_t>(n);
             if (size == 0) {
-                //
-                // This function only allocates space for
-                // initial_size elements, but does not call the constructor for those elements.
-                // Sets _current_buffer_size to initial_size.
-                //
-                alloc(initial_size);
-                _front = _buffer + 0;
-                _back = _buffer + 0;
-                _buffer_end = _buffer + initial_size;
-                _length = 0;
+                init_empty();
+                return;
+            }
+            //
+            // This array is actually FULL, with n elements. The state variables of the class are 
+            // also appropriately initialized. Placement new is called for each item.
+            //
+            alloc(size);
+            for (uint64_t k = 0; k < size; k++) {
+                new (_buffer + k) T{};
+            }
+            _buffer_end = _buffer + size;
+            _front = _buffer + 0;
+            _back = _buffer + size;
+            _length = size;
+            _ctrlBlk = fresh_ctrlBlk();
+        }
+        
+        const T* iterator_ptr(const const_iterator& it) const {
+            //
+            // The cell an iterator of this vector points at, after validating the iterator
+            //
+            if constexpr (Checking::tracks_versions) {
+                it.validate_base();
+                return it._ptr;
+            }
+            else if constexpr (Checking::checks_bounds) {
+                return it._ptr;
             }
             else {
+                return it;
+            }
+        }
+
+        template <typename U, typename V, typename F>
+        static void for_each_checked_impl(V& v, F& f) {
+            if constexpr (Checking::tracks_versions) {
                 //
-                // This array is actually FULL, with n elements. The state variables of the class are 
-                // also appropriately initialized. Placement new is called for each item.
+                // The iterator makes the control block shared, so a change made by f
+                // invalidates it with the usual diagnostics
                 //
-                alloc(size);
-                for (uint64_t k = 0; k < size; k++) {
-                    new (_buffer + k) T{};
+                const_iterator guard = static_cast<const Vector&>(v).begin();
+                for (U* p = v._front, *last = v._back; p != last; ++p) {
+                    f(*p);
+                }
+                guard.validate_base();
+            }
+            else {
+                for (U* p = v._front, *last = v._back; p != last; ++p) {
+                    f(*p);
                 }
-                _buffer_end = _buffer + size;
-                _front = _buffer + 0;
-                _back = _buffer + size;
-                _length = size;
             }
-            //
-            // Create a new control block with version = 1
-            //
-            _ctrlBlk = new CtrlBlk(1);
         }
-        
+
         void update_ctrlBlk(typename CtrlBlk::invalidate_reason reason, T* location, T* begin, T* end) {
+            update_ctrlBlk(reason, location, location == nullptr ? nullptr : location + 1, begin, end);
+        }
+
+        void update_ctrlBlk(typename CtrlBlk::invalidate_reason reason, T* location, T* location_end, T* begin, T* end) {
             //
             // This function is called by every mutator method before mutating
             // the vector. This will invalidate the current control block
             // and create a new control block for every mutation of the vector.
             //
-            uint64_t version = _ctrlBlk->_version;
-            if (_ctrlBlk->_refs == 0) {
-                _ctrlBlk->_version = version + 1;
+            if (_ctrlBlk == nullptr) {
+                //
+                // Either no iterator has been handed out yet, the checking policy
+                // keeps no control block, or this vector has been moved from
+                //
+                return;
+            }
+            uint64_t version = _ctrlBlk->version();
+            if (!_ctrlBlk->shared()) {
+                _ctrlBlk->set_version(version + 1);
                 _ctrlBlk->_reason = CtrlBlk::invalidate_reason::NONE;
                 _ctrlBlk->_location = nullptr;
+                _ctrlBlk->_location_end = nullptr;
                 _ctrlBlk->_begin = nullptr;
                 _ctrlBlk->_end = nullptr;
             }
             else {
-                _ctrlBlk->invalidate(reason, location, begin, end);
-                _ctrlBlk = new CtrlBlk(version + 1);
+                CtrlBlk* old = _ctrlBlk;
+                _ctrlBlk = CtrlBlk::create(version + 1, _alloc);
+#ifdef _EPL_STATS_
+                _stats.ctrlblk_allocated();
+#endif
+                old->invalidate(reason, location, location_end, begin, end);
+                CtrlBlk::abandon(old);
+            }
+        }
+
+        static void relocate(T* dest, T* src, uint64_t n) {
+            //
+            // Moves 'n' objects from src to the (uninitialized) dest and ends the lifetime
+            // of the objects at src. Trivially relocatable types are moved with a single
+            // memcpy and no destructor pass; everything else is move constructed and
+            // destructed one element at a time.
+            //
+            if (is_trivially_relocatable<T>::value) {
+                if (n > 0) {
+                    std::memcpy(static_cast<void*>(dest), static_cast<const void*>(src), (size_t)n * sizeof(T));
+                }
+            }
+            else {
+                for (uint64_t k = 0; k < n; k++) {
+                    new (dest + k) T{ std::move(src[k]) };
+                    src[k].T::~T();
+                }
             }
         }
 
@@ -914,21 +2033,381 @@ namespace epl
             // Private method for copying the state of another object
             //
             this->_length = other._length;
-            this->_buffer = (T *) operator new ((size_t)((other._buffer_end - other._buffer) * sizeof(T)));
+            this->_buffer = allocate_buffer(other._buffer_end - other._buffer);
             this->_buffer_end = (other._buffer_end - other._buffer) + this->_buffer;
             this->_front = (other._front - other._buffer) + this->_buffer;
             this->_back = (other._back - other._buffer) + this->_buffer;
+#ifdef _EPL_STATS_
+            this->_stats.capacity(other._buffer_end - other._buffer);
+#endif
             //
-            // Do not copy the control block while copying, create a new control block for this guy
+            // Do not copy the control block while copying, this guy gets its own on demand
             //
-            this->_ctrlBlk = new CtrlBlk(1);
+            this->_ctrlBlk = fresh_ctrlBlk();
 
             //
             // Copy construction of each of the elements from the first index to the last
-            // This is called placement new, using copy constructor
+            // This is called placement new, using copy constructor. Trivially copyable
+            // types are copied as one block of bytes instead.
+            //
+            if (std::is_trivially_copyable<T>::value) {
+                if (this->_length > 0) {
+                    std::memcpy(static_cast<void*>(this->_front), static_cast<const void*>(other._front), (size_t)this->_length * sizeof(T));
+                }
+            }
+            else {
+                for (uint64_t k = 0; k < this->_length; k++) {
+                    new (this->_front + k) T{ other._front[k] };
+                }
+            }
+        }
+
+        template <typename It>
+        struct is_forward_iterator : std::is_base_of<std::forward_iterator_tag,
+            typename std::iterator_traits<It>::iterator_category> {};
+
+        void reallocate(uint64_t capacity, uint64_t front_slack) {
+            //
+            // Moves the live range into a new buffer of 'capacity' cells, starting 'front_slack'
+            // cells in. The control block is left alone; callers update it once they are done.
+            // Allocators that can resize in place get to grow the buffer itself, after which
+            // the live range only has to slide if its front slack changes.
+            //
+            if constexpr (allocator_reallocates<Alloc, T>::value && is_trivially_relocatable<T>::value) {
+                uint64_t old_capacity = _buffer_end - _buffer;
+                if (grows_in_place() && capacity >= old_capacity) {
+                    uint64_t offset = _front - _buffer;
+                    T* new_buffer = _alloc.reallocate(_buffer, (size_t)old_capacity, (size_t)capacity);
+                    _buffer = new_buffer;
+                    _buffer_end = new_buffer + capacity;
+                    _front = new_buffer + offset;
+                    _back = _front + _length;
+#ifdef _EPL_STATS_
+                    _stats.reallocated(0, sizeof(T), capacity);
+#endif
+                    slide(new_buffer + front_slack);
+                    return;
+                }
+            }
+            T* new_buffer = allocate_buffer(capacity);
+            relocate(new_buffer + front_slack, _front, _length);
+#ifdef _EPL_STATS_
+            _stats.released(_front - _buffer, _buffer_end - _back);
+            _stats.reallocated(_length, sizeof(T), capacity);
+#endif
+            deallocate_buffer(_buffer, _buffer_end - _buffer);
+            _buffer = new_buffer;
+            _buffer_end = new_buffer + capacity;
+            _front = new_buffer + front_slack;
+            _back = _front + _length;
+        }
+
+        void reserve_slack_back(uint64_t n) {
+            //
+            // Makes room for 'n' more elements at the back, by recentering if the growth
+            // policy allows it and otherwise by growing the buffer as the policy says.
+            //
+            if ((uint64_t)(_buffer_end - _back) >= n) {
+                return;
+            }
+            if (try_recenter(n, true)) {
+                return;
+            }
+            uint64_t capacity, front_slack;
+            grown_layout(n, true, capacity, front_slack);
+            reallocate(capacity, front_slack);
+        }
+
+        void reserve_slack_front(uint64_t n) {
+            //
+            // Same as above for 'n' more elements at the front
+            //
+            if ((uint64_t)(_front - _buffer) >= n) {
+                return;
+            }
+            if (try_recenter(n, false)) {
+                return;
+            }
+            uint64_t capacity, front_slack;
+            grown_layout(n, false, capacity, front_slack);
+            reallocate(capacity, front_slack);
+        }
+
+        void grown_layout(uint64_t n, bool at_back, uint64_t& capacity, uint64_t& front_slack) const {
+            //
+            // Computes the buffer the growth policy asks for when one end lacks room for 'n'
+            // more elements: its capacity, and where the live range starts in it. The end that
+            // ran out always gets at least the 'n' cells it needs.
+            //
+            uint64_t old_capacity = _buffer_end - _buffer;
+            uint64_t old_front_slack = _front - _buffer;
+            uint64_t slack = at_back ? (uint64_t)(_buffer_end - _back) : old_front_slack;
+            uint64_t missing = n - slack;
+            capacity = Growth::next_capacity(old_capacity, old_capacity + missing);
+            uint64_t added = capacity - old_capacity;
+            uint64_t share = Growth::growing_end_share(added);
+            if (share < missing) {
+                share = missing;
+            }
+            front_slack = at_back ? old_front_slack + (added - share) : old_front_slack + share;
+        }
+
+        bool try_recenter(uint64_t n, bool at_back) {
+            //
+            // If the growth policy considers the buffer sparse enough, slides the live range
+            // so that the free cells are split evenly between the two ends (the end that ran
+            // out getting at least 'n'). Returns false if the buffer has to grow instead.
             //
+            uint64_t capacity = _buffer_end - _buffer;
+            uint64_t free = capacity - _length;
+            if (free < n || !Growth::should_recenter(_length, capacity)) {
+                return false;
+            }
+            uint64_t front_slack = at_back ? free / 2 : free - free / 2;
+            if (at_back && free - front_slack < n) {
+                front_slack = free - n;
+            }
+            else if (!at_back && front_slack < n) {
+                front_slack = n;
+            }
+            slide(_buffer + front_slack);
+#ifdef _EPL_STATS_
+            _stats.recentered();
+#endif
+#ifdef _DBG_
+            cout << "epl::Vector recentered the live range to offset " << front_slack << endl;
+#endif
+            return true;
+        }
+
+        void slide(T* new_front) {
+            //
+            // Moves the live range to start at new_front inside the same buffer. The source and
+            // destination may overlap, so elements are moved in the direction that never
+            // overwrites one that has not been moved yet.
+            //
+            if (new_front == _front) {
+                return;
+            }
+#ifdef _EPL_STATS_
+            _stats.moved(_length, sizeof(T));
+#endif
+            if (is_trivially_relocatable<T>::value) {
+                if (_length > 0) {
+                    std::memmove(static_cast<void*>(new_front), static_cast<const void*>(_front), (size_t)_length * sizeof(T));
+                }
+            }
+            else if (new_front < _front) {
+                for (uint64_t k = 0; k < _length; k++) {
+                    new (new_front + k) T{ std::move(_front[k]) };
+                    _front[k].T::~T();
+                }
+            }
+            else {
+                for (uint64_t k = _length; k > 0; k--) {
+                    new (new_front + k - 1) T{ std::move(_front[k - 1]) };
+                    _front[k - 1].T::~T();
+                }
+            }
+            _front = new_front;
+            _back = new_front + _length;
+        }
+
+        template <typename... Args>
+        void insert_back(typename CtrlBlk::invalidate_reason reason, Args&&... args) {
+            //
+            // Common code of push_back and emplace_back. The arguments may refer to an element
+            // of this vector, so when the buffer is reallocated the new element is constructed
+            // before the old ones are relocated, and before a recentering it is constructed
+            // into a temporary.
+            //
+            if (_back == _buffer_end) {
+                if (Growth::should_recenter(_length, _buffer_end - _buffer)) {
+                    T tmp{ std::forward<Args>(args)... };
+                    try_recenter(1, true);
+                    new (_back) T{ std::move(tmp) };
+                }
+                else if (grows_in_place()) {
+                    T tmp{ std::forward<Args>(args)... };
+                    uint64_t capacity, front_slack;
+                    grown_layout(1, true, capacity, front_slack);
+                    reallocate(capacity, front_slack);
+                    new (_back) T{ std::move(tmp) };
+                }
+                else {
+                    uint64_t capacity, front_slack;
+                    grown_layout(1, true, capacity, front_slack);
+                    T* new_buffer = allocate_buffer(capacity);
+                    T* new_front = new_buffer + front_slack;
+                    try {
+                        new (new_front + _length) T{ std::forward<Args>(args)... };
+                    }
+                    catch (...) {
+                        deallocate_buffer(new_buffer, capacity);
+                        throw;
+                    }
+                    relocate(new_front, _front, _length);
+#ifdef _EPL_STATS_
+                    _stats.released(_front - _buffer, _buffer_end - _back);
+                    _stats.reallocated(_length, sizeof(T), capacity);
+#endif
+                    deallocate_buffer(_buffer, _buffer_end - _buffer);
+                    _buffer = new_buffer;
+                    _buffer_end = new_buffer + capacity;
+                    _front = new_front;
+                    _back = new_front + _length;
+#ifdef _DBG_
+                    cout << "epl::Vector::insert_back reallocated to new size: " << capacity << endl;
+#endif
+                }
+            }
+            else {
+                new (_back) T{ std::forward<Args>(args)... };
+            }
+            _back++;
+            _length++;
+            update_ctrlBlk(reason, (_back - 1), _front, _back);
+        }
+
+        template <typename... Args>
+        void insert_front(typename CtrlBlk::invalidate_reason reason, Args&&... args) {
+            //
+            // Same as above, for push_front
+            //
+            if (_front == _buffer) {
+                if (Growth::should_recenter(_length, _buffer_end - _buffer)) {
+                    T tmp{ std::forward<Args>(args)... };
+                    try_recenter(1, false);
+                    new (_front - 1) T{ std::move(tmp) };
+                }
+                else if (grows_in_place()) {
+                    T tmp{ std::forward<Args>(args)... };
+                    uint64_t capacity, front_slack;
+                    grown_layout(1, false, capacity, front_slack);
+                    reallocate(capacity, front_slack);
+                    new (_front - 1) T{ std::move(tmp) };
+                }
+                else {
+                    uint64_t capacity, front_slack;
+                    grown_layout(1, false, capacity, front_slack);
+                    T* new_buffer = allocate_buffer(capacity);
+                    T* new_front = new_buffer + front_slack;
+                    try {
+                        new (new_front - 1) T{ std::forward<Args>(args)... };
+                    }
+                    catch (...) {
+                        deallocate_buffer(new_buffer, capacity);
+                        throw;
+                    }
+                    relocate(new_front, _front, _length);
+#ifdef _EPL_STATS_
+                    _stats.released(_front - _buffer, _buffer_end - _back);
+                    _stats.reallocated(_length, sizeof(T), capacity);
+#endif
+                    deallocate_buffer(_buffer, _buffer_end - _buffer);
+                    _buffer = new_buffer;
+                    _buffer_end = new_buffer + capacity;
+                    _front = new_front;
+                    _back = new_front + _length;
+#ifdef _DBG_
+                    cout << "epl::Vector::insert_front reallocated to new size: " << capacity << endl;
+#endif
+                }
+            }
+            else {
+                new (_front - 1) T{ std::forward<Args>(args)... };
+            }
+            _front--;
+            _length++;
+            update_ctrlBlk(reason, _front, _front, _back);
+        }
+
+        template <typename It>
+        static void construct_range(T* dest, It first, uint64_t n) {
+            //
+            // Copy constructs 'n' elements read from 'first' into raw memory at dest.
+            // Contiguous ranges of a trivially copyable T are copied as one block.
+            //
+            typedef typename std::remove_cv<typename std::remove_pointer<It>::type>::type source_type;
+            if constexpr (std::is_pointer<It>::value && std::is_same<source_type, T>::value &&
+                std::is_trivially_copyable<T>::value) {
+                if (n > 0) {
+                    std::memcpy(static_cast<void*>(dest), static_cast<const void*>(first), (size_t)n * sizeof(T));
+                }
+            }
+            else {
+                uint64_t k = 0;
+                try {
+                    for (; k < n; ++k, ++first) {
+                        new (dest + k) T{ *first };
+                    }
+                }
+                catch (...) {
+                    destroy_range(dest, dest + k);
+                    throw;
+                }
+            }
+        }
+
+        static void destroy_range(T* first, T* last) {
+            //
+            // Runs the destructors of [first, last) in one pass; nothing to do for trivial types
+            //
+            if (!std::is_trivially_destructible<T>::value) {
+                for (; first != last; ++first) {
+                    first->T::~T();
+                }
+            }
+        }
+
+        template <typename InputIt>
+        void init_range(InputIt first, InputIt last) {
+            //
+            // Private method shared by the initializer list and range constructors
+            //
+            _length = 0;
+            _ctrlBlk = fresh_ctrlBlk();
+            if constexpr (is_forward_iterator<InputIt>::value) {
+                uint64_t n = (uint64_t)std::distance(first, last);
+                alloc(n > 0 ? n : initial_size);
+                try {
+                    construct_range(_buffer, first, n);
+                }
+                catch (...) {
+                    deallocate_buffer(_buffer, _buffer_end - _buffer);
+                    throw;
+                }
+                _back = _buffer + n;
+                _length = n;
+            }
+            else {
+                alloc(initial_size);
+                try {
+                    append(first, last);
+                }
+                catch (...) {
+                    destroy(CtrlBlk::DESTROY);
+                    throw;
+                }
+            }
+        }
+
+        void move_elements(Vector& other) {
+            //
+            // Private method for taking over the elements of another vector whose buffer
+            // cannot be shared, used by move assignment across unequal allocators
+            //
+            this->_length = other._length;
+            this->_buffer = allocate_buffer(other._buffer_end - other._buffer);
+            this->_buffer_end = (other._buffer_end - other._buffer) + this->_buffer;
+            this->_front = (other._front - other._buffer) + this->_buffer;
+            this->_back = (other._back - other._buffer) + this->_buffer;
+            this->_ctrlBlk = fresh_ctrlBlk();
+#ifdef _EPL_STATS_
+            this->_stats.capacity(other._buffer_end - other._buffer);
+#endif
             for (uint64_t k = 0; k < this->_length; k++) {
-                new (this->_front + k) T{ other._front[k] };
+                new (this->_front + k) T{ std::move(other._front[k]) };
             }
         }
 
@@ -937,7 +2416,7 @@ namespace epl
             // Private method for destroying the state of an object
             //
             if (_buffer != nullptr) {
-                if (_length > 0) {
+                if (_length > 0 && !std::is_trivially_destructible<T>::value) {
                     for (uint64_t k = 0; k < _length; k++) {
                         //
                         // Run the destructor for all the elements that are currently in the Vector
@@ -945,27 +2424,110 @@ namespace epl
                         _front[k].T::~T();
                     }
                 }
+#ifdef _EPL_STATS_
+                _stats.released(_front - _buffer, _buffer_end - _back);
+#endif
                 //
-                // Calling delete using function syntax on _buffer, which is equivalent to calling free
+                // Hand the buffer back to the allocator it came from
                 //
-                operator delete(_buffer);
+                deallocate_buffer(_buffer, _buffer_end - _buffer);
                 _buffer = nullptr;
             }
             //
-            // If the number of iterators is 0, then delete the control block
+            // If the number of iterators is 0, then delete the control block,
+            // otherwise the last iterator deletes it
             //
             if (_ctrlBlk != nullptr) {
                 //
                 // Invalidate the control block in any case
                 //
                 _ctrlBlk->invalidate(reason, nullptr, nullptr, nullptr);
-                if (_ctrlBlk->_refs == 0) {
-                    delete(_ctrlBlk);
-                    _ctrlBlk = nullptr;
-                }
+                CtrlBlk::abandon(_ctrlBlk);
+                _ctrlBlk = nullptr;
             }
         }
     };
+
+    namespace detail {
+        struct vector_access {
+            template <typename T, typename Checking, typename Alloc, typename Growth>
+            static T* front(const Vector<T, Checking, Alloc, Growth>& v) {
+                return v._front;
+            }
+
+            template <typename T, typename Checking, typename Alloc, typename Growth>
+            static T* back(const Vector<T, Checking, Alloc, Growth>& v) {
+                return v._back;
+            }
+
+            template <typename It>
+            static void validate(const It& it) {
+                it.validate_base();
+            }
+
+            template <typename It>
+            static auto address(const It& it) -> decltype(&*it._ptr) {
+                //
+                // Where a checked or bounded iterator points, without validating it
+                //
+                return it._ptr;
+            }
+
+            template <typename T, typename Checking, typename Alloc, typename Growth>
+            static void commit_back(Vector<T, Checking, Alloc, Growth>& v, uint64_t n) {
+                //
+                // Adopts 'n' elements that were written into the free cells after _back
+                // (which the caller made room for) as if they had been pushed
+                //
+                if (n == 0) {
+                    return;
+                }
+                v._back += n;
+                v._length += n;
+                v.update_ctrlBlk(Vector<T, Checking, Alloc, Growth>::CtrlBlk::invalidate_reason::PUSH_BACK,
+                    v._back - n, v._back, v._front, v._back);
+            }
+
+            template <typename T, typename Checking, typename Alloc, typename Growth>
+            static void rearranged(Vector<T, Checking, Alloc, Growth>& v) {
+                //
+                // Reports that the elements were reordered in place (e.g. by epl::sort).
+                // The buffer and the live range are unchanged, so the iterators handed
+                // out before only learn that their values moved (MILD).
+                //
+                v.update_ctrlBlk(Vector<T, Checking, Alloc, Growth>::CtrlBlk::invalidate_reason::NONE,
+                    nullptr, nullptr, v._front, v._back);
+            }
+        };
+
+#if __cplusplus > 201703L
+        template <typename It>
+        concept vector_iterator = std::is_same<typename It::iterator_concept, std::contiguous_iterator_tag>::value &&
+            requires(const It& it) { vector_access::address(it); };
+#endif
+    }
 }
 
+#if __cplusplus > 201703L
+namespace std
+{
+    template <typename It>
+        requires epl::detail::vector_iterator<It>
+    struct pointer_traits<It> {
+        //
+        // std::to_address for the checked and bounded iterators, which declare themselves
+        // contiguous. It is applied to end() too (e.g. by std::span's constructor), so it
+        // must not go through operator->, which validates a dereference.
+        //
+        typedef It pointer;
+        typedef typename std::remove_reference<typename It::reference>::type element_type;
+        typedef typename It::difference_type difference_type;
+
+        static element_type* to_address(const It& it) noexcept {
+            return epl::detail::vector_access::address(it);
+        }
+    };
+}
+#endif
+
 #endif
\ No newline at end of file
@@ -0,0 +1,649 @@
+//
+// Benchmarks of epl::Vector against std::vector and std::deque. Self-contained: build
+// with e.g.
+//
+//   g++ -std=c++17 -O2 -DNDEBUG -pthread VectorBench.cpp -o VectorBench
+//
+// and run with
+//
+//   ./VectorBench [--out results.json] [--filter substring] [--max-count N]
+//                 [--max-bytes B] [--min-time seconds]
+//
+// Every case runs for each element size and for counts 10, 100, ... up to
+// --max-count (default 10^7; pass 100000000 for the full range), skipping those whose
+// elements would take more than --max-bytes (default 1 GiB). A case is repeated
+// until it has run for --min-time seconds. For each run the harness reports the time
+// per element, the elements per second, the heap allocations per repetition (through
+// a counting global operator new) and the peak RSS of the process while the case ran
+// (VmHWM, reset before every case where the kernel allows it). Results go to stdout,
+// or to the --out file, as JSON.
+//
+// The mixed_ends case also runs on unchecked Vectors with each growth policy
+// (growth::doubling, balanced and compact); for those runs the results include the
+// number of times the buffer was replaced per repetition ("reallocations"), next to the
+// throughput.
+//
+// The fork_join case measures the scheduler rather than a container: it sums a Vector
+// by recursive binary splitting, each split a two-chunk parallel_for, on ThreadPools of
+// 0, 1, 2, 4, ... workers up to the default size, so that the ns/element of the
+// "<n> threads" runs shows how fork/join work scales across the work-stealing deques.
+//
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/utsname.h>
+
+#include "ThreadPool.h"
+#include "Vector.h"
+
+namespace bench
+{
+    //
+    // Heap traffic of the whole process, counted by the operators below
+    //
+    static std::atomic<uint64_t> allocations(0);
+    static std::atomic<uint64_t> allocated_bytes(0);
+
+    //
+    // Buffer replacements counted by the growth policy cases
+    //
+    static uint64_t reallocations = 0;
+
+    //
+    // Every replaced operator new goes through allocate() and every operator delete
+    // through release(), so each pair stays matched. Both are kept out of line: inlined
+    // into a caller, GCC would see operator new's pointer reach free() and warn
+    // (-Wmismatched-new-delete).
+    //
+    __attribute__((noinline)) static void* allocate(size_t n, size_t alignment) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        allocated_bytes.fetch_add(n, std::memory_order_relaxed);
+        n = n > 0 ? n : 1;
+        void* p;
+        if (alignment <= __STDCPP_DEFAULT_NEW_ALIGNMENT__) {
+            p = std::malloc(n);
+        }
+        else {
+            p = std::aligned_alloc(alignment, (n + alignment - 1) / alignment * alignment);
+        }
+        if (p == nullptr) {
+            throw std::bad_alloc();
+        }
+        return p;
+    }
+
+    __attribute__((noinline)) static void* allocate(size_t n, size_t alignment, const std::nothrow_t&) noexcept {
+        try {
+            return allocate(n, alignment);
+        }
+        catch (...) {
+            return nullptr;
+        }
+    }
+
+    __attribute__((noinline)) static void release(void* p) noexcept {
+        std::free(p);
+    }
+}
+
+void* operator new(size_t n) {
+    return bench::allocate(n, 0);
+}
+
+void* operator new[](size_t n) {
+    return bench::allocate(n, 0);
+}
+
+void* operator new(size_t n, const std::nothrow_t& tag) noexcept {
+    return bench::allocate(n, 0, tag);
+}
+
+void* operator new[](size_t n, const std::nothrow_t& tag) noexcept {
+    return bench::allocate(n, 0, tag);
+}
+
+void* operator new(size_t n, std::align_val_t alignment) {
+    return bench::allocate(n, (size_t)alignment);
+}
+
+void* operator new[](size_t n, std::align_val_t alignment) {
+    return bench::allocate(n, (size_t)alignment);
+}
+
+void* operator new(size_t n, std::align_val_t alignment, const std::nothrow_t& tag) noexcept {
+    return bench::allocate(n, (size_t)alignment, tag);
+}
+
+void* operator new[](size_t n, std::align_val_t alignment, const std::nothrow_t& tag) noexcept {
+    return bench::allocate(n, (size_t)alignment, tag);
+}
+
+void operator delete(void* p) noexcept {
+    bench::release(p);
+}
+
+void operator delete[](void* p) noexcept {
+    bench::release(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    bench::release(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    bench::release(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    bench::release(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    bench::release(p);
+}
+
+void operator delete(void* p, std::align_val_t) noexcept {
+    bench::release(p);
+}
+
+void operator delete[](void* p, std::align_val_t) noexcept {
+    bench::release(p);
+}
+
+void operator delete(void* p, size_t, std::align_val_t) noexcept {
+    bench::release(p);
+}
+
+void operator delete[](void* p, size_t, std::align_val_t) noexcept {
+    bench::release(p);
+}
+
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    bench::release(p);
+}
+
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept {
+    bench::release(p);
+}
+
+namespace bench
+{
+    template <size_t Bytes>
+    struct payload {
+        //
+        // Trivially copyable element of 'Bytes' bytes
+        //
+        payload(void) {
+            std::memset(bytes, 0, Bytes);
+        }
+
+        explicit payload(uint64_t k) {
+            std::memset(bytes, (int)(k & 0xff), Bytes);
+        }
+
+        uint64_t key(void) const {
+            return bytes[0];
+        }
+
+        unsigned char bytes[Bytes];
+    };
+
+    struct heavy {
+        //
+        // Element that is costly to move: it owns a heap block and its move constructor
+        // is not noexcept, so containers copy it (block and all) when they grow
+        //
+        heavy(void) : _data(new uint64_t[8]()) {}
+
+        explicit heavy(uint64_t k) : _data(new uint64_t[8]()) {
+            _data[0] = k;
+        }
+
+        heavy(const heavy& other) : _data(new uint64_t[8]) {
+            std::memcpy(_data, other._data, 8 * sizeof(uint64_t));
+        }
+
+        heavy(heavy&& other) : heavy(static_cast<const heavy&>(other)) {}
+
+        heavy& operator=(const heavy& other) {
+            std::memcpy(_data, other._data, 8 * sizeof(uint64_t));
+            return *this;
+        }
+
+        heavy& operator=(heavy&& other) {
+            return *this = static_cast<const heavy&>(other);
+        }
+
+        ~heavy() {
+            delete[] _data;
+        }
+
+        uint64_t key(void) const {
+            return _data[0];
+        }
+
+        uint64_t* _data;
+    };
+
+    //
+    // Keeps the optimizer from discarding a result
+    //
+    static volatile uint64_t sink;
+
+    struct options {
+        std::string out;
+        std::string filter;
+        uint64_t max_count;
+        uint64_t max_bytes;
+        double min_time;
+    };
+
+    struct result {
+        std::string name;
+        std::string container;
+        std::string element;
+        size_t element_size;
+        uint64_t count;
+        uint64_t repetitions;
+        double ns_per_element;
+        double elements_per_second;
+        double allocations_per_repetition;
+        double bytes_per_repetition;
+        bool counts_reallocations;
+        double reallocations_per_repetition;
+        long peak_rss_kb;
+    };
+
+    long peak_rss_kb(void) {
+        //
+        // Peak resident set size since the last reset_peak_rss(), in KiB
+        //
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.compare(0, 6, "VmHWM:") == 0) {
+                return std::strtol(line.c_str() + 6, nullptr, 10);
+            }
+        }
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+    }
+
+    void reset_peak_rss(void) {
+        std::ofstream clear("/proc/self/clear_refs");
+        if (clear) {
+            clear << "5";
+        }
+    }
+
+    class runner {
+    public:
+        explicit runner(const options& opts) : _opts(opts) {}
+
+        template <typename Elem>
+        void run(const std::string& name, const std::string& container, const std::string& element,
+            uint64_t count, const std::function<void(void)>& body, bool counts_reallocations = false) {
+            //
+            // Times 'body', which handles 'count' elements per call, until min_time has
+            // passed. Bodies that add to 'reallocations' say so with counts_reallocations.
+            //
+            std::string label = name + "/" + container + "/" + element + "/" + std::to_string(count);
+            if (!_opts.filter.empty() && label.find(_opts.filter) == std::string::npos) {
+                return;
+            }
+            if (count * sizeof(Elem) > _opts.max_bytes) {
+                return;
+            }
+            reset_peak_rss();
+            body();     // warm up
+            uint64_t allocs_before = allocations.load();
+            uint64_t bytes_before = allocated_bytes.load();
+            uint64_t reallocations_before = reallocations;
+            uint64_t reps = 0;
+            auto start = std::chrono::steady_clock::now();
+            double elapsed = 0;
+            do {
+                body();
+                reps++;
+                elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            } while (elapsed < _opts.min_time);
+            uint64_t allocs = allocations.load() - allocs_before;
+            uint64_t bytes = allocated_bytes.load() - bytes_before;
+            result r;
+            r.name = name;
+            r.container = container;
+            r.element = element;
+            r.element_size = sizeof(Elem);
+            r.count = count;
+            r.repetitions = reps;
+            r.ns_per_element = elapsed * 1e9 / ((double)reps * count);
+            r.elements_per_second = (double)reps * count / elapsed;
+            r.allocations_per_repetition = (double)allocs / reps;
+            r.bytes_per_repetition = (double)bytes / reps;
+            r.counts_reallocations = counts_reallocations;
+            r.reallocations_per_repetition = (double)(reallocations - reallocations_before) / reps;
+            r.peak_rss_kb = peak_rss_kb();
+            _results.push_back(r);
+            std::cerr << label << ": " << r.ns_per_element << " ns/element" << std::endl;
+        }
+
+        void write(std::ostream& os) const {
+            struct utsname host;
+            uname(&host);
+            os << "{\n  \"context\": {\n";
+            os << "    \"host\": \"" << host.nodename << "\",\n";
+            os << "    \"system\": \"" << host.sysname << " " << host.release << " " << host.machine << "\",\n";
+#if defined(__clang__)
+            os << "    \"compiler\": \"clang " << __clang_version__ << "\",\n";
+#elif defined(__GNUC__)
+            os << "    \"compiler\": \"gcc " << __VERSION__ << "\",\n";
+#else
+            os << "    \"compiler\": \"unknown\",\n";
+#endif
+            os << "    \"min_time\": " << _opts.min_time << "\n  },\n";
+            os << "  \"benchmarks\": [\n";
+            for (size_t k = 0; k < _results.size(); k++) {
+                const result& r = _results[k];
+                os << "    {\"name\": \"" << r.name << "\", \"container\": \"" << r.container
+                    << "\", \"element\": \"" << r.element << "\", \"element_size\": " << r.element_size
+                    << ", \"count\": " << r.count << ", \"repetitions\": " << r.repetitions
+                    << ", \"ns_per_element\": " << r.ns_per_element
+                    << ", \"elements_per_second\": " << r.elements_per_second
+                    << ", \"allocations\": " << r.allocations_per_repetition
+                    << ", \"allocated_bytes\": " << r.bytes_per_repetition;
+                if (r.counts_reallocations) {
+                    os << ", \"reallocations\": " << r.reallocations_per_repetition;
+                }
+                os << ", \"peak_rss_kb\": " << r.peak_rss_kb << "}"
+                    << (k + 1 < _results.size() ? ",\n" : "\n");
+            }
+            os << "  ]\n}\n";
+        }
+
+    private:
+        options _opts;
+        std::vector<result> _results;
+    };
+
+    //
+    // The containers under test, with the push/pop interface each one offers
+    //
+    template <typename T>
+    using epl_full = epl::Vector<T>;
+
+    template <typename T>
+    using epl_none = epl::Vector<T, epl::checking::none>;
+
+    template <typename T, typename Growth>
+    using epl_growth = epl::Vector<T, epl::checking::none, std::allocator<T>, Growth>;
+
+    template <typename T, typename C>
+    void push_back_n(C& c, uint64_t n) {
+        for (uint64_t k = 0; k < n; k++) {
+            c.push_back(T(k));
+        }
+    }
+
+    template <typename T, typename C>
+    void push_front_n(C& c, uint64_t n) {
+        for (uint64_t k = 0; k < n; k++) {
+            c.push_front(T(k));
+        }
+    }
+
+    template <typename T, typename C>
+    void mixed_ends(uint64_t n) {
+        //
+        // Alternating pushes at both ends, then alternating pops
+        //
+        C c;
+        for (uint64_t k = 0; k < n; k++) {
+            if (k & 1) {
+                c.push_front(T(k));
+            }
+            else {
+                c.push_back(T(k));
+            }
+        }
+        for (uint64_t k = 0; k < n; k++) {
+            if (k & 1) {
+                c.pop_front();
+            }
+            else {
+                c.pop_back();
+            }
+        }
+    }
+
+    template <typename T, typename C>
+    void mixed_ends_counted(uint64_t n) {
+        //
+        // mixed_ends, counting the buffer replacements on the way up (a recentering keeps
+        // the capacity, a reallocation changes it)
+        //
+        C c;
+        uint64_t capacity = c.capacity();
+        for (uint64_t k = 0; k < n; k++) {
+            if (k & 1) {
+                c.push_front(T(k));
+            }
+            else {
+                c.push_back(T(k));
+            }
+            if (c.capacity() != capacity) {
+                capacity = c.capacity();
+                reallocations++;
+            }
+        }
+        for (uint64_t k = 0; k < n; k++) {
+            if (k & 1) {
+                c.pop_front();
+            }
+            else {
+                c.pop_back();
+            }
+        }
+    }
+
+    template <typename C>
+    uint64_t iterate(const C& c) {
+        uint64_t total = 0;
+        for (auto it = c.begin(); it != c.end(); ++it) {
+            total += (*it).key();
+        }
+        return total;
+    }
+
+    template <typename C>
+    uint64_t index(const C& c) {
+        uint64_t total = 0;
+        uint64_t n = c.size();
+        for (uint64_t k = 0; k < n; k++) {
+            total += c[k].key();
+        }
+        return total;
+    }
+
+    template <template <typename> class C, typename T, bool HasFront>
+    void container_cases(runner& r, const std::string& container, const std::string& element, uint64_t count) {
+        typedef C<T> container_type;
+        r.run<T>("push_back", container, element, count, [count] {
+            container_type c;
+            push_back_n<T>(c, count);
+            sink = c.size();
+        });
+        if constexpr (HasFront) {
+            r.run<T>("push_front", container, element, count, [count] {
+                container_type c;
+                push_front_n<T>(c, count);
+                sink = c.size();
+            });
+            r.run<T>("mixed_ends", container, element, count, [count] {
+                mixed_ends<T, container_type>(count);
+            });
+        }
+        container_type filled;
+        push_back_n<T>(filled, count);
+        r.run<T>("iterate", container, element, count, [&filled] {
+            sink = iterate(filled);
+        });
+        r.run<T>("index", container, element, count, [&filled] {
+            sink = index(filled);
+        });
+        r.run<T>("copy_construct", container, element, count, [&filled] {
+            container_type copy(filled);
+            sink = copy.size();
+        });
+        r.run<T>("move_assign", container, element, count, [&filled] {
+            //
+            // Moves the contents out and back, so 'filled' is the same for every call
+            //
+            container_type other;
+            other = std::move(filled);
+            filled = std::move(other);
+            sink = filled.size();
+        });
+    }
+
+    template <typename T, typename Growth>
+    void growth_case(runner& r, const std::string& policy, const std::string& element, uint64_t count) {
+        r.run<T>("mixed_ends", "epl::Vector<none, " + policy + ">", element, count, [count] {
+            mixed_ends_counted<T, epl_growth<T, Growth>>(count);
+        }, true);
+    }
+
+    template <typename T>
+    using std_vector = std::vector<T>;
+
+    template <typename T>
+    using std_deque = std::deque<T>;
+
+    template <typename T>
+    void element_cases(runner& r, const std::string& element, const options& opts) {
+        for (uint64_t count = 10; count <= opts.max_count; count *= 10) {
+            container_cases<epl_full, T, true>(r, "epl::Vector", element, count);
+            container_cases<epl_none, T, true>(r, "epl::Vector<none>", element, count);
+            container_cases<std_vector, T, false>(r, "std::vector", element, count);
+            container_cases<std_deque, T, true>(r, "std::deque", element, count);
+            growth_case<T, epl::growth::doubling>(r, "doubling", element, count);
+            growth_case<T, epl::growth::balanced>(r, "balanced", element, count);
+            growth_case<T, epl::growth::compact>(r, "compact", element, count);
+        }
+    }
+
+    //
+    // Elements summed by one leaf task of the fork/join case
+    //
+    static const uint64_t fork_join_leaf = 4096;
+
+    uint64_t fork_join_sum(epl::ThreadPool& pool, const uint64_t* p, uint64_t n) {
+        if (n <= fork_join_leaf) {
+            uint64_t sum = 0;
+            for (uint64_t k = 0; k < n; k++) {
+                sum += p[k];
+            }
+            return sum;
+        }
+        uint64_t halves[2];
+        pool.parallel_for(0, 2, 1, [&pool, &halves, p, n](uint64_t lo, uint64_t) {
+            uint64_t half = n / 2;
+            halves[lo] = lo == 0 ? fork_join_sum(pool, p, half) : fork_join_sum(pool, p + half, n - half);
+        });
+        return halves[0] + halves[1];
+    }
+
+    void fork_join_cases(runner& r, const options& opts) {
+        epl::Vector<uint64_t, epl::checking::none> data;
+        unsigned max_threads = epl::ThreadPool::default_threads();
+        for (uint64_t count = 100000; count <= opts.max_count; count *= 10) {
+            push_back_n<uint64_t>(data, count - data.size());
+            for (unsigned threads = 0;; threads = threads == 0 ? 1 : threads * 2) {
+                if (threads > max_threads) {
+                    threads = max_threads;
+                }
+                epl::ThreadPool pool(threads);
+                r.run<uint64_t>("fork_join", "ThreadPool/" + std::to_string(threads) + " threads", "uint64", count,
+                    [&pool, &data, count] {
+                        sink = fork_join_sum(pool, data.data(), count);
+                    });
+                if (threads == max_threads) {
+                    break;
+                }
+            }
+        }
+    }
+
+    bool parse(int argc, char** argv, options& opts) {
+        opts.max_count = 10000000;
+        opts.max_bytes = (uint64_t)1 << 30;
+        opts.min_time = 0.2;
+        for (int k = 1; k < argc; k++) {
+            std::string arg = argv[k];
+            if (k + 1 >= argc) {
+                return false;
+            }
+            std::string value = argv[++k];
+            if (arg == "--out") {
+                opts.out = value;
+            }
+            else if (arg == "--filter") {
+                opts.filter = value;
+            }
+            else if (arg == "--max-count") {
+                opts.max_count = std::strtoull(value.c_str(), nullptr, 10);
+            }
+            else if (arg == "--max-bytes") {
+                opts.max_bytes = std::strtoull(value.c_str(), nullptr, 10);
+            }
+            else if (arg == "--min-time") {
+                opts.min_time = std::strtod(value.c_str(), nullptr);
+            }
+            else {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv) {
+    bench::options opts;
+    if (!bench::parse(argc, argv, opts)) {
+        std::cerr << "usage: " << argv[0] << " [--out file] [--filter substring] [--max-count N]"
+            " [--max-bytes B] [--min-time seconds]" << std::endl;
+        return 2;
+    }
+    bench::runner r(opts);
+    bench::element_cases<bench::payload<4>>(r, "bytes4", opts);
+    bench::element_cases<bench::payload<16>>(r, "bytes16", opts);
+    bench::element_cases<bench::payload<64>>(r, "bytes64", opts);
+    bench::element_cases<bench::heavy>(r, "heavy", opts);
+    bench::fork_join_cases(r, opts);
+    if (opts.out.empty()) {
+        r.write(std::cout);
+    }
+    else {
+        std::ofstream out(opts.out);
+        r.write(out);
+        if (!out) {
+            std::cerr << "Cannot write " << opts.out << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
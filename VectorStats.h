@@ -0,0 +1,219 @@
+#ifndef _VECTOR_STATS_H_
+#define _VECTOR_STATS_H_
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+
+namespace epl
+{
+    //
+    // Performance counters of Vector, compiled in only when _EPL_STATS_ is defined
+    // (Vector.h then includes this header). Without it a Vector carries no counters
+    // and executes no counting code.
+    //
+    // Each vector counts what happened to it, and every count also goes to process
+    // wide totals. Vector::stats() returns the counters of one vector, together with
+    // its current layout, and global_stats() the totals; both can be written out
+    // with write_json(). Invalid iterators are detected long after the vector that
+    // made them invalid may be gone, so they are only counted globally.
+    //
+    struct vector_stats {
+        //
+        // Buffer reallocations (in place ones included) and recenterings
+        //
+        uint64_t reallocations = 0;
+        uint64_t recenterings = 0;
+        //
+        // Elements moved by reallocations and recenterings, and their size in bytes
+        //
+        uint64_t elements_moved = 0;
+        uint64_t bytes_moved = 0;
+        uint64_t peak_capacity = 0;
+        uint64_t ctrlblk_allocations = 0;
+        //
+        // The layout at the time of the snapshot: free cells before _front and after _back
+        //
+        uint64_t capacity = 0;
+        uint64_t length = 0;
+        uint64_t front_slack = 0;
+        uint64_t back_slack = 0;
+    };
+
+    struct global_vector_stats {
+        uint64_t reallocations = 0;
+        uint64_t recenterings = 0;
+        uint64_t elements_moved = 0;
+        uint64_t bytes_moved = 0;
+        uint64_t peak_capacity = 0;
+        uint64_t ctrlblk_allocations = 0;
+        uint64_t invalidations_thrown = 0;
+        //
+        // Buffers handed back to the allocator, and the free cells they had at either
+        // end at that point: slack that was allocated but never used
+        //
+        uint64_t buffers_released = 0;
+        uint64_t released_front_slack = 0;
+        uint64_t released_back_slack = 0;
+    };
+
+    namespace detail
+    {
+        struct global_counters {
+            std::atomic<uint64_t> reallocations{ 0 };
+            std::atomic<uint64_t> recenterings{ 0 };
+            std::atomic<uint64_t> elements_moved{ 0 };
+            std::atomic<uint64_t> bytes_moved{ 0 };
+            std::atomic<uint64_t> peak_capacity{ 0 };
+            std::atomic<uint64_t> ctrlblk_allocations{ 0 };
+            std::atomic<uint64_t> invalidations_thrown{ 0 };
+            std::atomic<uint64_t> buffers_released{ 0 };
+            std::atomic<uint64_t> released_front_slack{ 0 };
+            std::atomic<uint64_t> released_back_slack{ 0 };
+        };
+
+        inline global_counters& stats_totals(void) {
+            static global_counters counters;
+            return counters;
+        }
+
+        inline void count(std::atomic<uint64_t>& counter, uint64_t n) {
+            counter.fetch_add(n, std::memory_order_relaxed);
+        }
+
+        class stats_recorder {
+        public:
+            //
+            // The counters a Vector keeps when _EPL_STATS_ is defined. A copied or moved
+            // vector starts counting from zero.
+            //
+            stats_recorder(void) {}
+
+            stats_recorder(const stats_recorder&) {}
+
+            stats_recorder& operator=(const stats_recorder&) {
+                return *this;
+            }
+
+            void reallocated(uint64_t moved, size_t element_size, uint64_t capacity) {
+                _counters.reallocations++;
+                count(stats_totals().reallocations, 1);
+                this->moved(moved, element_size);
+                this->capacity(capacity);
+            }
+
+            void recentered(void) {
+                _counters.recenterings++;
+                count(stats_totals().recenterings, 1);
+            }
+
+            void moved(uint64_t moved, size_t element_size) {
+                if (moved == 0) {
+                    return;
+                }
+                _counters.elements_moved += moved;
+                _counters.bytes_moved += moved * element_size;
+                count(stats_totals().elements_moved, moved);
+                count(stats_totals().bytes_moved, moved * element_size);
+            }
+
+            void capacity(uint64_t capacity) {
+                if (capacity > _counters.peak_capacity) {
+                    _counters.peak_capacity = capacity;
+                }
+                std::atomic<uint64_t>& peak = stats_totals().peak_capacity;
+                uint64_t seen = peak.load(std::memory_order_relaxed);
+                while (capacity > seen && !peak.compare_exchange_weak(seen, capacity, std::memory_order_relaxed)) {}
+            }
+
+            void ctrlblk_allocated(void) {
+                _counters.ctrlblk_allocations++;
+                count(stats_totals().ctrlblk_allocations, 1);
+            }
+
+            void released(uint64_t front_slack, uint64_t back_slack) {
+                count(stats_totals().buffers_released, 1);
+                count(stats_totals().released_front_slack, front_slack);
+                count(stats_totals().released_back_slack, back_slack);
+            }
+
+            vector_stats snapshot(uint64_t capacity, uint64_t length, uint64_t front_slack, uint64_t back_slack) const {
+                vector_stats s = _counters;
+                s.capacity = capacity;
+                s.length = length;
+                s.front_slack = front_slack;
+                s.back_slack = back_slack;
+                return s;
+            }
+
+        private:
+            vector_stats _counters;
+        };
+
+        inline void invalidation_thrown(void) {
+            count(stats_totals().invalidations_thrown, 1);
+        }
+    }
+
+    inline global_vector_stats global_stats(void) {
+        //
+        // The process wide totals. Each counter is read on its own, so a snapshot taken
+        // while other threads use vectors need not be consistent across counters.
+        //
+        detail::global_counters& c = detail::stats_totals();
+        global_vector_stats s;
+        s.reallocations = c.reallocations.load(std::memory_order_relaxed);
+        s.recenterings = c.recenterings.load(std::memory_order_relaxed);
+        s.elements_moved = c.elements_moved.load(std::memory_order_relaxed);
+        s.bytes_moved = c.bytes_moved.load(std::memory_order_relaxed);
+        s.peak_capacity = c.peak_capacity.load(std::memory_order_relaxed);
+        s.ctrlblk_allocations = c.ctrlblk_allocations.load(std::memory_order_relaxed);
+        s.invalidations_thrown = c.invalidations_thrown.load(std::memory_order_relaxed);
+        s.buffers_released = c.buffers_released.load(std::memory_order_relaxed);
+        s.released_front_slack = c.released_front_slack.load(std::memory_order_relaxed);
+        s.released_back_slack = c.released_back_slack.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    inline void reset_global_stats(void) {
+        detail::global_counters& c = detail::stats_totals();
+        c.reallocations.store(0, std::memory_order_relaxed);
+        c.recenterings.store(0, std::memory_order_relaxed);
+        c.elements_moved.store(0, std::memory_order_relaxed);
+        c.bytes_moved.store(0, std::memory_order_relaxed);
+        c.peak_capacity.store(0, std::memory_order_relaxed);
+        c.ctrlblk_allocations.store(0, std::memory_order_relaxed);
+        c.invalidations_thrown.store(0, std::memory_order_relaxed);
+        c.buffers_released.store(0, std::memory_order_relaxed);
+        c.released_front_slack.store(0, std::memory_order_relaxed);
+        c.released_back_slack.store(0, std::memory_order_relaxed);
+    }
+
+    inline void write_json(std::ostream& os, const vector_stats& s) {
+        os << "{\"reallocations\": " << s.reallocations
+            << ", \"recenterings\": " << s.recenterings
+            << ", \"elements_moved\": " << s.elements_moved
+            << ", \"bytes_moved\": " << s.bytes_moved
+            << ", \"peak_capacity\": " << s.peak_capacity
+            << ", \"ctrlblk_allocations\": " << s.ctrlblk_allocations
+            << ", \"capacity\": " << s.capacity
+            << ", \"length\": " << s.length
+            << ", \"front_slack\": " << s.front_slack
+            << ", \"back_slack\": " << s.back_slack << "}";
+    }
+
+    inline void write_json(std::ostream& os, const global_vector_stats& s) {
+        os << "{\"reallocations\": " << s.reallocations
+            << ", \"recenterings\": " << s.recenterings
+            << ", \"elements_moved\": " << s.elements_moved
+            << ", \"bytes_moved\": " << s.bytes_moved
+            << ", \"peak_capacity\": " << s.peak_capacity
+            << ", \"ctrlblk_allocations\": " << s.ctrlblk_allocations
+            << ", \"invalidations_thrown\": " << s.invalidations_thrown
+            << ", \"buffers_released\": " << s.buffers_released
+            << ", \"released_front_slack\": " << s.released_front_slack
+            << ", \"released_back_slack\": " << s.released_back_slack << "}";
+    }
+}
+
+#endif
@@ -0,0 +1,197 @@
+#ifndef _VECTOR_VIEW_H_
+#define _VECTOR_VIEW_H_
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+
+#include "Span.h"
+#include "Vector.h"
+
+namespace epl
+{
+    namespace detail
+    {
+        template <typename V, bool = V::checking_policy::tracks_versions>
+        class view_guard {
+        public:
+            //
+            // Holds one iterator into the vector, at the start of the slice, for as long
+            // as the view lives. Any change to the vector invalidates it, and check() then
+            // throws the invalid_iterator the iterator would have thrown.
+            //
+            view_guard(void) {}
+
+            view_guard(const V& v, uint64_t offset) : _it(v.begin() + (int64_t)offset) {}
+
+            view_guard advanced(uint64_t offset) const {
+                view_guard g;
+                if (_it) {
+                    g._it.emplace(*_it + (int64_t)offset);
+                }
+                return g;
+            }
+
+            void check(void) const {
+                if (_it) {
+                    vector_access::validate(*_it);
+                }
+            }
+
+        private:
+            std::optional<typename V::const_iterator> _it;
+        };
+
+        template <typename V>
+        class view_guard<V, false> {
+        public:
+            //
+            // Nothing to check without version tracking
+            //
+            view_guard(void) {}
+
+            view_guard(const V&, uint64_t) {}
+
+            view_guard advanced(uint64_t) const {
+                return view_guard();
+            }
+
+            void check(void) const {}
+        };
+    }
+
+    template <typename T, typename Checking = default_checking,
+        typename Alloc = std::allocator<typename std::remove_const<T>::type>, typename Growth = growth::doubling>
+    class VectorView {
+        template <typename, typename, typename, typename>
+        friend class VectorView;
+
+    public:
+        //
+        // Zero copy view of a slice of a Vector's live range, e.g. to hand part of a big
+        // buffer to a worker or a raw pointer to a C API. VectorView<const T> views a
+        // const vector, and VectorView<T> converts to it.
+        //
+        // Unlike a Span, a view remembers which state of the vector it was made from.
+        // With checking::full or checking::concurrent it holds a reference to the
+        // vector's control block, taken once when the view is made (and once more per
+        // copy or subview), and every use of it -- data(), operator[], begin(), end(),
+        // span(), subview() -- first checks that the vector has not been changed since,
+        // throwing invalid_iterator as an iterator would if it has. Between those checks
+        // the view is plain pointers: iterating [begin(), end()) or reading through
+        // data() costs nothing per element. With the other policies there is nothing to
+        // check and a view is just a pointer and a length.
+        //
+        // As with iterators, copying and dropping views of the same vector on several
+        // threads at once needs checking::concurrent (or a policy without a control
+        // block).
+        //
+        typedef T element_type;
+        typedef typename std::remove_const<T>::type value_type;
+        typedef T* iterator;
+        typedef Vector<value_type, Checking, Alloc, Growth> vector_type;
+        typedef typename std::conditional<std::is_const<T>::value, const vector_type, vector_type>::type viewed_type;
+
+        VectorView(void) : _data(nullptr), _length(0) {}
+
+        VectorView(viewed_type& v) : VectorView(v, 0, v.size()) {}
+
+        VectorView(viewed_type& v, uint64_t offset, uint64_t count) :
+            _data(detail::vector_access::front(v) + (offset <= v.size() ? offset : 0)), _length(count) {
+            //
+            // Views the 'count' elements of 'v' starting at index 'offset'
+            //
+            if (offset > v.size() || count > v.size() - offset) {
+                throw std::out_of_range("VectorView out of Range.");
+            }
+            _guard = detail::view_guard<vector_type>(v, offset);
+        }
+
+        template <typename U, typename = typename std::enable_if<std::is_convertible<U(*)[], T(*)[]>::value>::type>
+        VectorView(const VectorView<U, Checking, Alloc, Growth>& other) :
+            _data(other._data), _length(other._length), _guard(other._guard) {}
+
+        uint64_t size(void) const {
+            //
+            // The length of the slice; unlike the accessors below this is the view's own
+            // state and does not look at the vector
+            //
+            return _length;
+        }
+
+        bool empty(void) const {
+            return _length == 0;
+        }
+
+        T* data(void) const {
+            _guard.check();
+            return _data;
+        }
+
+        T& operator[](uint64_t k) const {
+            //
+            // Range checked, like Vector::operator[]
+            //
+            _guard.check();
+            if (k >= _length) {
+                throw std::out_of_range("VectorView Index out of Range.");
+            }
+            return _data[k];
+        }
+
+        T* begin(void) const {
+            _guard.check();
+            return _data;
+        }
+
+        T* end(void) const {
+            _guard.check();
+            return _data + _length;
+        }
+
+        Span<T> span(void) const {
+            //
+            // The slice as an unchecked Span, e.g. for the epl::simd kernels
+            //
+            _guard.check();
+            return Span<T>(_data, _length);
+        }
+
+        VectorView subview(uint64_t offset, uint64_t count) const {
+            //
+            // The 'count' elements starting at 'offset' within this view, checked against
+            // the same state of the vector as this view
+            //
+            _guard.check();
+            if (offset > _length || count > _length - offset) {
+                throw std::out_of_range("Subview out of Range.");
+            }
+            VectorView view;
+            view._data = _data + offset;
+            view._length = count;
+            view._guard = _guard.advanced(offset);
+            return view;
+        }
+
+    private:
+        T* _data;
+        uint64_t _length;
+        detail::view_guard<vector_type> _guard;
+    };
+
+    template <typename T, typename C, typename A, typename G>
+    VectorView(Vector<T, C, A, G>&) -> VectorView<T, C, A, G>;
+
+    template <typename T, typename C, typename A, typename G>
+    VectorView(Vector<T, C, A, G>&, uint64_t, uint64_t) -> VectorView<T, C, A, G>;
+
+    template <typename T, typename C, typename A, typename G>
+    VectorView(const Vector<T, C, A, G>&) -> VectorView<const T, C, A, G>;
+
+    template <typename T, typename C, typename A, typename G>
+    VectorView(const Vector<T, C, A, G>&, uint64_t, uint64_t) -> VectorView<const T, C, A, G>;
+}
+
+#endif
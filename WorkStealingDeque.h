@@ -0,0 +1,218 @@
+#ifndef _WORK_STEALING_DEQUE_H_
+#define _WORK_STEALING_DEQUE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+#include "Vector.h"
+
+namespace epl
+{
+    template <typename T, typename Alloc = std::allocator<T>>
+    class WorkStealingDeque {
+        static_assert(std::is_trivially_copyable<T>::value,
+            "WorkStealingDeque cells are read and written atomically; store pointers or handles to bigger objects");
+
+        struct ring;
+        typedef std::atomic<T> cell;
+        typedef typename std::allocator_traits<Alloc>::template rebind_alloc<cell> cell_allocator;
+        typedef typename std::allocator_traits<Alloc>::template rebind_alloc<ring> ring_allocator;
+        typedef std::allocator_traits<cell_allocator> cell_traits;
+        typedef std::allocator_traits<ring_allocator> ring_traits;
+
+    public:
+        //
+        // Chase-Lev work stealing deque: one owner thread pushes and pops at the back,
+        // any number of thieves steal from the front, all without locks. The layout is
+        // Vector's double-ended buffer turned into a ring: the live range runs from
+        // _top (the front, advanced by thieves) to _bottom (the back, moved by the
+        // owner), both counting up forever and mapped onto the cells modulo the
+        // capacity. Only the last element is contended; the owner and a thief settle it
+        // with a CAS on _top.
+        //
+        // When the ring is full the owner copies the live range into a ring of twice
+        // the size and publishes it with a single store; thieves never wait for that,
+        // they keep stealing from whichever ring they loaded. The old rings stay
+        // allocated (a thief may still be reading one) until the deque is destroyed,
+        // which costs at most as much memory again as the largest ring.
+        //
+        // Elements are read and written as atomics, so T has to be trivially copyable:
+        // a scheduler stores task pointers. The owner-only calls are push(), pop() and
+        // capacity(); steal(), size() and empty() may be called from any thread, the
+        // latter two giving a snapshot that may be stale by the time it returns.
+        //
+        static const uint64_t initial_size = 64;
+
+        explicit WorkStealingDeque(uint64_t capacity = initial_size, const Alloc& allocator = Alloc()) :
+            _top(0), _bottom(0), _retired(nullptr), _alloc(allocator) {
+            uint64_t size = 1;
+            while (size < capacity) {
+                size *= 2;
+            }
+            _ring.store(make_ring(size), std::memory_order_relaxed);
+        }
+
+        WorkStealingDeque(const WorkStealingDeque&) = delete;
+        WorkStealingDeque& operator=(const WorkStealingDeque&) = delete;
+
+        ~WorkStealingDeque() {
+            free_ring(_ring.load(std::memory_order_relaxed));
+            while (_retired != nullptr) {
+                ring* next = _retired->_retired;
+                free_ring(_retired);
+                _retired = next;
+            }
+        }
+
+        void push(T value) {
+            //
+            // Owner only: adds 'value' at the back
+            //
+            int64_t bottom = _bottom.load(std::memory_order_relaxed);
+            int64_t top = _top.load(std::memory_order_acquire);
+            ring* r = _ring.load(std::memory_order_relaxed);
+            if ((uint64_t)(bottom - top) >= r->_capacity) {
+                r = grow(r, top, bottom);
+            }
+            r->at(bottom).store(value, std::memory_order_relaxed);
+            //
+            // The release publishes the element to the thieves that see the new bottom
+            //
+            _bottom.store(bottom + 1, std::memory_order_release);
+        }
+
+        bool pop(T& value) {
+            //
+            // Owner only: takes the newest element. Returns false if the deque is empty
+            // (or its last element went to a thief).
+            //
+            int64_t bottom = _bottom.load(std::memory_order_relaxed) - 1;
+            ring* r = _ring.load(std::memory_order_relaxed);
+            _bottom.store(bottom, std::memory_order_relaxed);
+            //
+            // Orders the claim on the back against the thieves' reads of _bottom
+            //
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t top = _top.load(std::memory_order_relaxed);
+            if (top > bottom) {
+                _bottom.store(bottom + 1, std::memory_order_relaxed);
+                return false;
+            }
+            value = r->at(bottom).load(std::memory_order_relaxed);
+            if (top == bottom) {
+                //
+                // The last element: a thief may be after it too
+                //
+                bool won = _top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                _bottom.store(bottom + 1, std::memory_order_relaxed);
+                return won;
+            }
+            return true;
+        }
+
+        bool steal(T& value) {
+            //
+            // Any thread: takes the oldest element. Returns false if the deque is empty,
+            // or if another thief or the owner took that element first; callers looking
+            // for work should then simply try elsewhere.
+            //
+            int64_t top = _top.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t bottom = _bottom.load(std::memory_order_acquire);
+            if (top >= bottom) {
+                return false;
+            }
+            ring* r = _ring.load(std::memory_order_acquire);
+            T candidate = r->at(top).load(std::memory_order_relaxed);
+            if (!_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                return false;
+            }
+            value = candidate;
+            return true;
+        }
+
+        uint64_t size(void) const {
+            int64_t bottom = _bottom.load(std::memory_order_relaxed);
+            int64_t top = _top.load(std::memory_order_relaxed);
+            return bottom > top ? (uint64_t)(bottom - top) : 0;
+        }
+
+        bool empty(void) const {
+            return size() == 0;
+        }
+
+        uint64_t capacity(void) const {
+            return _ring.load(std::memory_order_relaxed)->_capacity;
+        }
+
+    private:
+        struct ring {
+            uint64_t _capacity;
+            uint64_t _mask;
+            cell* _cells;
+            //
+            // Next older ring on the retired list
+            //
+            ring* _retired;
+
+            cell& at(int64_t k) {
+                return _cells[(uint64_t)k & _mask];
+            }
+        };
+
+        //
+        // _top is written by every thief and _bottom by the owner on every push and pop:
+        // keep them on separate cache lines
+        //
+        alignas(cache_line_size) std::atomic<int64_t> _top;
+        alignas(cache_line_size) std::atomic<int64_t> _bottom;
+        std::atomic<ring*> _ring;
+        ring* _retired;
+        cell_allocator _alloc;
+
+        ring* make_ring(uint64_t capacity) {
+            ring_allocator a(_alloc);
+            ring* r = ring_traits::allocate(a, 1);
+            try {
+                r->_cells = cell_traits::allocate(_alloc, (size_t)capacity);
+            }
+            catch (...) {
+                ring_traits::deallocate(a, r, 1);
+                throw;
+            }
+            for (uint64_t k = 0; k < capacity; k++) {
+                new (r->_cells + k) cell();
+            }
+            r->_capacity = capacity;
+            r->_mask = capacity - 1;
+            r->_retired = nullptr;
+            return r;
+        }
+
+        void free_ring(ring* r) {
+            ring_allocator a(_alloc);
+            cell_traits::deallocate(_alloc, r->_cells, (size_t)r->_capacity);
+            ring_traits::deallocate(a, r, 1);
+        }
+
+        ring* grow(ring* old, int64_t top, int64_t bottom) {
+            //
+            // Owner only: moves the live range into a ring twice the size. Thieves may be
+            // stealing from 'old' meanwhile; whatever they take is taken through _top, so
+            // the copies of those elements in the new ring are simply never read.
+            //
+            ring* r = make_ring(old->_capacity * 2);
+            for (int64_t k = top; k < bottom; k++) {
+                r->at(k).store(old->at(k).load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+            _ring.store(r, std::memory_order_release);
+            old->_retired = _retired;
+            _retired = old;
+            return r;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,198 @@
+//
+// Tests for bulk removal: pop_front(n), pop_back(n), erase(first, last) and clear(),
+// for trivially relocatable and other elements, with the diagnostics of the iterators
+// they invalidate.
+//
+#include <stdexcept>
+#include <string>
+
+#include "Check.h"
+#include "Vector.h"
+
+template <typename F>
+static int severity_of(F f) {
+    try {
+        f();
+    }
+    catch (const epl::invalid_iterator& e) {
+        return e.level;
+    }
+    return -1;
+}
+
+//
+// Element that counts its live instances
+//
+struct counted {
+    static int live;
+
+    std::string value;
+
+    counted(int v) : value(std::to_string(v)) {
+        live++;
+    }
+
+    counted(const counted& other) : value(other.value) {
+        live++;
+    }
+
+    counted(counted&& other) : value(std::move(other.value)) {
+        live++;
+    }
+
+    counted& operator=(const counted&) = default;
+    counted& operator=(counted&&) = default;
+
+    ~counted() {
+        live--;
+    }
+};
+
+int counted::live = 0;
+
+template <typename T>
+static epl::Vector<T> numbers(int n) {
+    epl::Vector<T> v;
+    v.reserve(n);
+    for (int k = 0; k < n; k++) {
+        v.push_back(T(k));
+    }
+    return v;
+}
+
+static int value_of(int x) {
+    return x;
+}
+
+static int value_of(const counted& x) {
+    return std::stoi(x.value);
+}
+
+template <typename T>
+static void test_pops(void) {
+    {
+        epl::Vector<T> v = numbers<T>(100);
+        v.pop_back(10);
+        v.pop_front(20);
+        CHECK(v.size() == 70 && value_of(v[0]) == 20 && value_of(v[69]) == 89);
+        v.pop_back(0);
+        v.pop_front(0);
+        CHECK(v.size() == 70);
+
+        CHECK_THROWS(v.pop_back(71), std::out_of_range);
+        CHECK_THROWS(v.pop_front(71), std::out_of_range);
+        CHECK(v.size() == 70 && value_of(v[69]) == 89);
+
+        auto kept = v.begin() + 10;
+        auto dropped = v.begin() + 65;
+        v.pop_back(5);
+        CHECK(severity_of([&] { *dropped; }) == epl::invalid_iterator::SEVERE);
+        CHECK(severity_of([&] { *kept; }) == epl::invalid_iterator::MILD);
+
+        kept = v.begin() + 10;
+        dropped = v.begin() + 2;
+        v.pop_front(5);
+        CHECK(severity_of([&] { *dropped; }) == epl::invalid_iterator::SEVERE);
+        CHECK(severity_of([&] { *kept; }) == epl::invalid_iterator::WARNING);
+
+        v.pop_front(v.size());
+        CHECK(v.size() == 0);
+        v.push_back(T(7));
+        CHECK(v.size() == 1 && value_of(v[0]) == 7);
+    }
+    CHECK(counted::live == 0);
+}
+
+template <typename T>
+static void test_erase(void) {
+    {
+        //
+        // Near the front the elements before the gap move; near the back those after it
+        //
+        epl::Vector<T> v = numbers<T>(100);
+        auto next = v.erase(v.begin() + 10, v.begin() + 15);
+        CHECK(v.size() == 95 && value_of(*next) == 15);
+        CHECK(value_of(v[9]) == 9 && value_of(v[10]) == 15 && value_of(v[0]) == 0);
+        next = v.erase(v.begin() + 80, v.begin() + 90);
+        CHECK(v.size() == 85 && value_of(*next) == 95 && value_of(v[79]) == 84);
+        next = v.erase(v.begin() + 80, v.end());
+        CHECK(v.size() == 80 && next == v.end());
+        next = v.erase(v.begin(), v.begin() + 1);
+        CHECK(v.size() == 79 && value_of(*next) == 1 && next == v.begin());
+        next = v.erase(v.begin() + 5, v.begin() + 5);
+        CHECK(v.size() == 79 && value_of(*next) == 6);
+        bool ordered = true;
+        for (uint64_t k = 1; k < v.size(); k++) {
+            ordered = ordered && value_of(v[k - 1]) < value_of(v[k]);
+        }
+        CHECK(ordered);
+
+        //
+        // Iterators into the cells given up are SEVERE, the others report the pop
+        //
+        auto head = v.begin();
+        auto middle = v.begin() + 40;
+        auto last = v.end() - 1;
+        v.erase(v.begin() + 50, v.begin() + 52);
+        CHECK(severity_of([&] { *last; }) == epl::invalid_iterator::SEVERE);
+        CHECK(severity_of([&] { *middle; }) == epl::invalid_iterator::MILD);
+        CHECK(severity_of([&] { *head; }) == epl::invalid_iterator::MILD);
+        head = v.begin();
+        last = v.end() - 1;
+        v.erase(v.begin() + 2, v.begin() + 4);
+        CHECK(severity_of([&] { *head; }) == epl::invalid_iterator::SEVERE);
+        CHECK(severity_of([&] { *last; }) == epl::invalid_iterator::WARNING);
+
+        v.erase(v.begin(), v.end());
+        CHECK(v.size() == 0);
+
+        epl::Vector<T> other = numbers<T>(3);
+        epl::Vector<T> w = numbers<T>(5);
+        CHECK_THROWS(w.erase(other.begin(), other.end()), std::out_of_range);
+        CHECK_THROWS(w.erase(w.begin() + 3, w.begin() + 1), std::out_of_range);
+        auto stale = w.begin();
+        w.pop_back();
+        CHECK_THROWS(w.erase(stale, stale + 1), epl::invalid_iterator);
+        CHECK(w.size() == 4);
+    }
+    CHECK(counted::live == 0);
+}
+
+template <typename T>
+static void test_clear(void) {
+    {
+        epl::Vector<T> v = numbers<T>(50);
+        v.push_front(T(-1));
+        uint64_t capacity = v.capacity();
+        auto it = v.begin() + 3;
+        v.clear();
+        CHECK(v.size() == 0 && v.capacity() == capacity);
+        CHECK(severity_of([&] { *it; }) == epl::invalid_iterator::SEVERE);
+        v.clear();
+        for (uint64_t k = 0; k < capacity; k++) {
+            v.push_back(T(1));
+        }
+        //
+        // All of the buffer is free at the back again, so this did not reallocate
+        //
+        CHECK(v.capacity() == capacity && v.size() == capacity);
+    }
+    CHECK(counted::live == 0);
+
+    epl::Vector<int, epl::checking::none> raw{ 1, 2, 3, 4, 5 };
+    raw.erase(raw.begin() + 1, raw.begin() + 3);
+    raw.pop_front(1);
+    CHECK(raw.size() == 2 && raw[0] == 4 && raw[1] == 5);
+    raw.clear();
+    CHECK(raw.size() == 0);
+}
+
+int main() {
+    test_pops<int>();
+    test_pops<counted>();
+    test_erase<int>();
+    test_erase<counted>();
+    test_clear<int>();
+    test_clear<counted>();
+    return check::result();
+}
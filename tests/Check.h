@@ -0,0 +1,60 @@
+#ifndef _CHECK_H_
+#define _CHECK_H_
+
+#include <atomic>
+#include <cstdio>
+#include <exception>
+
+//
+// Minimal test harness shared by the tests in this directory. CHECK records a failure
+// (with its location) and carries on, so that one run reports every broken expectation;
+// CHECK_THROWS expects the statement to throw the given exception type. A test's main()
+// returns check::result(), which prints a summary and is non-zero if anything failed.
+//
+namespace check
+{
+    inline std::atomic<int>& failures(void) {
+        //
+        // Atomic, since checks also run inside tasks on pool threads
+        //
+        static std::atomic<int> count(0);
+        return count;
+    }
+
+    inline void fail(const char* what, const char* file, int line) {
+        std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, what);
+        failures()++;
+    }
+
+    inline int result(void) {
+        if (failures() != 0) {
+            std::fprintf(stderr, "%d check(s) failed\n", failures().load());
+            return 1;
+        }
+        return 0;
+    }
+}
+
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            check::fail(#cond, __FILE__, __LINE__); \
+        } \
+    } while (0)
+
+#define CHECK_THROWS(statement, exception_type) \
+    do { \
+        bool caught_ = false; \
+        try { \
+            statement; \
+        } \
+        catch (const exception_type&) { \
+            caught_ = true; \
+        } \
+        catch (...) {} \
+        if (!caught_) { \
+            check::fail(#statement " throws " #exception_type, __FILE__, __LINE__); \
+        } \
+    } while (0)
+
+#endif
@@ -0,0 +1,134 @@
+//
+// Tests for the checking policies' own semantics: checking::bounds range checks every
+// dereference and never allocates a control block, checking::none hands out raw
+// pointers, and checking::full reports what the others cannot.
+//
+#include <algorithm>
+#include <memory_resource>
+#include <stdexcept>
+#include <type_traits>
+
+#include "Check.h"
+#include "Vector.h"
+
+template <typename Checking>
+using pmr_vector = epl::Vector<int, Checking, std::pmr::polymorphic_allocator<int>>;
+
+static_assert(std::is_same<epl::Vector<int, epl::checking::none>::iterator, int*>::value,
+    "checking::none iterators are raw pointers");
+static_assert(std::is_same<epl::Vector<int, epl::checking::none>::const_iterator, const int*>::value,
+    "checking::none const iterators are raw pointers");
+static_assert(!std::is_pointer<epl::Vector<int, epl::checking::bounds>::iterator>::value,
+    "checking::bounds iterators are checked");
+static_assert(!std::is_pointer<epl::Vector<int, epl::checking::full>::iterator>::value,
+    "checking::full iterators are checked");
+
+//
+// Counts the blocks it hands out, buffers and control blocks alike
+//
+class counting_resource : public std::pmr::memory_resource {
+public:
+    int live = 0;
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        live++;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        live--;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+static void test_bounds(void) {
+    epl::Vector<int, epl::checking::bounds> v{ 1, 2, 3, 4 };
+    auto it = v.begin();
+    CHECK(*it == 1 && it[3] == 4 && *(v.end() - 1) == 4);
+    CHECK_THROWS(*v.end(), std::out_of_range);
+    CHECK_THROWS(it[4], std::out_of_range);
+    CHECK_THROWS(it[-1], std::out_of_range);
+    auto before = it - 1;
+    CHECK_THROWS(*before, std::out_of_range);
+    auto past = it + 4;
+    CHECK_THROWS(past.operator->(), std::out_of_range);
+    const auto& cv = v;
+    CHECK_THROWS(*cv.end(), std::out_of_range);
+
+    //
+    // Iterators know only the range they were made with: no invalidation diagnostics
+    //
+    v.reserve(10);
+    it = v.begin();
+    v.push_back(5);
+    CHECK(*it == 1 && it[3] == 4);
+    CHECK_THROWS(it[4], std::out_of_range);
+    CHECK(v.end()[-1] == 5);
+    std::sort(v.begin(), v.end(), [](int a, int b) { return a > b; });
+    CHECK(v[0] == 5 && v[4] == 1);
+}
+
+template <typename Checking>
+static int blocks_while_iterating(void) {
+    //
+    // Blocks taken from the resource, beyond the buffer, while iterators are alive
+    //
+    counting_resource resource;
+    int extra;
+    {
+        pmr_vector<Checking> v{ std::pmr::polymorphic_allocator<int>(&resource) };
+        v.reserve(100);
+        int buffers = resource.live;
+        for (int k = 0; k < 50; k++) {
+            v.push_back(k);
+        }
+        auto it = v.begin();
+        auto copy = it;
+        int sum = 0;
+        for (auto p = v.begin(); p != v.end(); ++p) {
+            sum += *p;
+        }
+        CHECK(sum == 1225 && *copy == 0);
+        extra = resource.live - buffers;
+    }
+    CHECK(resource.live == 0);
+    return extra;
+}
+
+static void test_control_blocks(void) {
+    CHECK(blocks_while_iterating<epl::checking::bounds>() == 0);
+    CHECK(blocks_while_iterating<epl::checking::none>() == 0);
+    CHECK(blocks_while_iterating<epl::checking::full>() > 0);
+}
+
+static void test_none(void) {
+    epl::Vector<int, epl::checking::none> v;
+    for (int k = 0; k < 100; k++) {
+        v.push_front(k);
+    }
+    int* p = v.begin();
+    CHECK(p == &v[0] && v.end() - p == 100 && *p == 99 && p[99] == 0);
+    std::reverse(v.begin(), v.end());
+    CHECK(v[0] == 0 && v[99] == 99);
+
+    //
+    // checking::full on the other hand notices the push that the others cannot
+    //
+    epl::Vector<int, epl::checking::full> full{ 1, 2, 3 };
+    full.reserve(10);
+    auto it = full.begin();
+    full.push_back(4);
+    CHECK_THROWS(*it, epl::invalid_iterator);
+}
+
+int main() {
+    test_bounds();
+    test_control_blocks();
+    test_none();
+    return check::result();
+}
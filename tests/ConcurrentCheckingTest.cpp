@@ -0,0 +1,117 @@
+//
+// Tests for checking::concurrent: many threads iterating one vector at once, iterators
+// that outlive a mutation or the vector itself on another thread, and the last
+// reference freeing the control block wherever it is dropped.
+//
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "Check.h"
+#include "Vector.h"
+
+typedef epl::Vector<int, epl::checking::concurrent> cvector;
+
+static const int num_threads = 4;
+
+static void test_concurrent_readers(void) {
+    cvector v;
+    for (int k = 0; k < 10000; k++) {
+        v.push_back(k);
+    }
+    std::atomic<long> total(0);
+    std::vector<std::thread> readers;
+    for (int t = 0; t < num_threads; t++) {
+        readers.emplace_back([&v, &total] {
+            for (int round = 0; round < 20; round++) {
+                long sum = 0;
+                for (auto it = v.begin(); it != v.end(); ++it) {
+                    auto copy = it;
+                    sum += *copy;
+                }
+                total += sum;
+            }
+        });
+    }
+    for (auto& t : readers) {
+        t.join();
+    }
+    CHECK(total == 20L * num_threads * (10000L * 9999 / 2));
+}
+
+static void test_invalidation_across_threads(void) {
+    cvector v{ 1, 2, 3 };
+    v.reserve(10);
+    std::atomic<int> stage(0);
+    std::atomic<int> severity(-1);
+    std::thread reader([&v, &stage, &severity] {
+        auto it = v.begin();
+        stage = 1;
+        while (stage.load() != 2) {
+            std::this_thread::yield();
+        }
+        try {
+            (void)*it;
+        }
+        catch (const epl::invalid_iterator& e) {
+            severity = e.level;
+        }
+    });
+    while (stage.load() != 1) {
+        std::this_thread::yield();
+    }
+    v.push_back(4);
+    stage = 2;
+    reader.join();
+    CHECK(severity == epl::invalid_iterator::MILD);
+}
+
+static void test_iterator_outlives_vector(void) {
+    //
+    // The iterators are the last owners of the control block and drop it on other
+    // threads; LeakSanitizer and ThreadSanitizer catch a block freed twice or never
+    //
+    for (int round = 0; round < 50; round++) {
+        std::atomic<int> started(0);
+        std::atomic<bool> destroyed(false);
+        std::atomic<int> invalid(0);
+        std::vector<std::thread> holders;
+        {
+            cvector* v = new cvector{ 1, 2, 3 };
+            for (int t = 0; t < num_threads; t++) {
+                holders.emplace_back([v, &started, &destroyed, &invalid] {
+                    auto it = v->begin();
+                    auto copy = it;
+                    started++;
+                    while (!destroyed.load()) {
+                        std::this_thread::yield();
+                    }
+                    try {
+                        (void)*copy;
+                    }
+                    catch (const epl::invalid_iterator& e) {
+                        if (e.level == epl::invalid_iterator::SEVERE) {
+                            invalid++;
+                        }
+                    }
+                });
+            }
+            while (started.load() != num_threads) {
+                std::this_thread::yield();
+            }
+            delete v;
+            destroyed = true;
+        }
+        for (auto& t : holders) {
+            t.join();
+        }
+        CHECK(invalid == num_threads);
+    }
+}
+
+int main() {
+    test_concurrent_readers();
+    test_invalidation_across_threads();
+    test_iterator_outlives_vector();
+    return check::result();
+}
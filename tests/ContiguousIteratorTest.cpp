@@ -0,0 +1,66 @@
+//
+// Tests for the C++20 contiguous iterator support of Vector's checked and bounded
+// iterators: std::to_address, including on end(), and std::span built from an iterator
+// range. Built with -std=c++20 (see the Makefile).
+//
+#include <iterator>
+#include <memory>
+#include <span>
+#include <string>
+
+#include "Check.h"
+#include "Vector.h"
+
+static_assert(std::contiguous_iterator<epl::Vector<int>::iterator>);
+static_assert(std::contiguous_iterator<epl::Vector<int>::const_iterator>);
+static_assert(std::contiguous_iterator<epl::Vector<int, epl::checking::bounds>::iterator>);
+static_assert(std::contiguous_iterator<epl::Vector<int, epl::checking::bounds>::const_iterator>);
+static_assert(std::contiguous_iterator<epl::Vector<int, epl::checking::concurrent>::iterator>);
+
+template <typename Checking>
+static void test_addresses(void) {
+    epl::Vector<std::string, Checking> v{ "a", "b", "c" };
+    v.push_front("z");
+    const auto& cv = v;
+    std::string* first = std::to_address(v.begin());
+    CHECK(first == &v[0]);
+    CHECK(std::to_address(v.end()) == first + 4);
+    CHECK(std::to_address(cv.end()) == first + 4);
+    CHECK(std::to_address(v.begin() + 2) == &v[2]);
+
+    std::span<std::string> all(v.begin(), v.end());
+    CHECK(all.size() == 4 && all[0] == "z" && all.data() == first);
+    std::span<const std::string> tail(cv.begin() + 1, cv.end());
+    CHECK(tail.size() == 3 && tail[2] == "c");
+
+    epl::Vector<std::string, Checking> empty;
+    std::span<std::string> none(empty.begin(), empty.end());
+    CHECK(none.size() == 0);
+
+    //
+    // Dereferencing end() is still an error
+    //
+    CHECK_THROWS(*v.end(), std::out_of_range);
+    CHECK_THROWS(v.end()->size(), std::out_of_range);
+}
+
+static void test_invalidated(void) {
+    //
+    // to_address does not validate, so it works on an invalidated iterator too; using
+    // it for anything else still throws
+    //
+    epl::Vector<int> v{ 1, 2 };
+    v.reserve(10);
+    auto it = v.begin();
+    v.push_back(3);
+    CHECK(std::to_address(it) == &v[0]);
+    CHECK_THROWS(*it, epl::invalid_iterator);
+}
+
+int main() {
+    test_addresses<epl::checking::full>();
+    test_addresses<epl::checking::bounds>();
+    test_addresses<epl::checking::concurrent>();
+    test_invalidated();
+    return check::result();
+}
@@ -0,0 +1,227 @@
+//
+// Tests for CowVector: copies sharing a buffer, unsharing on the first mutation,
+// deep copies once mutable access has leaked, erase and clear on a shared buffer,
+// throwing element copies, and copies made and dropped on several threads.
+//
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Check.h"
+#include "CowVector.h"
+
+//
+// Element that counts its live instances; its copy throws when the countdown reaches zero
+//
+struct counted {
+    static std::atomic<int> live;
+    static int countdown;
+
+    std::string value;
+
+    counted(const char* v) : value(v) {
+        live++;
+    }
+
+    counted(const counted& other) : value(other.value) {
+        if (countdown > 0 && --countdown == 0) {
+            throw std::runtime_error("counted");
+        }
+        live++;
+    }
+
+    counted(counted&& other) noexcept : value(std::move(other.value)) {
+        live++;
+    }
+
+    counted& operator=(const counted&) = default;
+    counted& operator=(counted&&) = default;
+
+    ~counted() {
+        live--;
+    }
+};
+
+std::atomic<int> counted::live(0);
+int counted::countdown = 0;
+
+typedef epl::CowVector<counted> cow;
+
+static const counted* cdata(const cow& v) {
+    return v.data();
+}
+
+static void test_sharing(void) {
+    {
+        cow a{ "a", "b", "c" };
+        CHECK(!a.shared());
+        cow b(a);
+        CHECK(a.shared() && b.shared());
+        CHECK(cdata(a) == cdata(b));
+        CHECK(counted::live == 3);
+        const cow& cb = b;
+        CHECK(cb[1].value == "b" && cb.begin()->value == "a" && b.cend() - b.cbegin() == 3);
+        CHECK(b.shared());
+
+        auto reading = b.cbegin();
+        b.push_back("d");
+        CHECK(!a.shared() && !b.shared());
+        CHECK(cdata(a) != cdata(b));
+        CHECK(a.size() == 3 && b.size() == 4);
+        CHECK(counted::live == 7);
+        CHECK_THROWS(*reading, epl::invalid_iterator);
+
+        cow c;
+        c = a;
+        CHECK(cdata(c) == cdata(a));
+        cow d(std::move(c));
+        CHECK(cdata(d) == cdata(a) && c.size() == 0 && d.shared());
+        cow e;
+        e = std::move(d);
+        CHECK(cdata(e) == cdata(a) && d.size() == 0);
+        d = e;
+        CHECK(cdata(d) == cdata(a));
+
+        //
+        // The original goes away first; the copies keep the buffer alive
+        //
+        {
+            cow gone(std::move(a));
+        }
+        CHECK(cdata(e)[2].value == "c" && d.size() == 3);
+        CHECK(counted::live == 7);
+    }
+    CHECK(counted::live == 0);
+}
+
+static void test_leaked(void) {
+    {
+        cow a{ "x", "y" };
+        counted& first = a[0];
+        cow b(a);
+        //
+        // A reference to a's elements is out, so b could not share without seeing
+        // writes through it
+        //
+        CHECK(!a.shared() && cdata(a) != cdata(b));
+        first.value = "changed";
+        CHECK(b[0].value == "x");
+
+        cow c{ "p", "q" };
+        auto it = c.begin();
+        cow d(c);
+        CHECK(cdata(c) != cdata(d));
+        it->value = "r";
+        CHECK(cdata(d)[0].value == "p");
+
+        cow e{ "s" };
+        e.for_each_checked([](counted& x) { x.value = "t"; });
+        cow f(e);
+        CHECK(cdata(e) == cdata(f));
+    }
+    CHECK(counted::live == 0);
+}
+
+static void test_erase_and_clear(void) {
+    {
+        cow a{ "0", "1", "2", "3", "4" };
+        cow b(a);
+        const cow& cb = b;
+        b.erase(cb.begin() + 1, cb.begin() + 3);
+        CHECK(b.size() == 3 && cb[1].value == "3");
+        CHECK(a.size() == 5 && a[1].value == "1");
+        CHECK_THROWS(b.erase(cb.begin() + 2, cb.begin() + 5), std::out_of_range);
+
+        cow c(a);
+        uint64_t capacity = c.capacity();
+        c.clear();
+        CHECK(c.size() == 0 && c.capacity() == capacity);
+        CHECK(a.size() == 5 && !a.shared());
+        c.push_back("new");
+        CHECK(c.size() == 1 && a.size() == 5);
+
+        //
+        // Clearing the last owner just clears
+        //
+        a.clear();
+        CHECK(a.size() == 0);
+
+        cow d{ "u", "v" };
+        cow e(d);
+        d.pop_back();
+        e.pop_front(1);
+        CHECK(d.size() == 1 && cdata(d)[0].value == "u");
+        CHECK(e.size() == 1 && cdata(e)[0].value == "v");
+    }
+    CHECK(counted::live == 0);
+}
+
+static void test_throwing_copies(void) {
+    {
+        cow a{ "1", "2", "3" };
+        cow b(a);
+        counted::countdown = 2;
+        CHECK_THROWS(b.push_back("4"), std::runtime_error);
+        counted::countdown = 0;
+        //
+        // The failed unshare leaves b sharing with a, unchanged
+        //
+        CHECK(b.shared() && cdata(a) == cdata(b) && b.size() == 3);
+        CHECK(counted::live == 3);
+
+        //
+        // Unsharing a for the mutable access copies its elements; the deep copy that
+        // follows throws part way and must not leak the elements it made
+        //
+        a[0].value = "leaked";
+        CHECK(counted::live == 6);
+        counted::countdown = 3;
+        CHECK_THROWS(cow broken(a), std::runtime_error);
+        counted::countdown = 0;
+        CHECK(counted::live == 6);
+    }
+    CHECK(counted::live == 0);
+}
+
+static void test_threads(void) {
+    //
+    // Copies of one vector are made, read, modified and destroyed on several threads
+    //
+    {
+        cow source;
+        for (int k = 0; k < 1000; k++) {
+            source.push_back("s");
+        }
+        const cow& shared_source = source;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++) {
+            threads.emplace_back([&shared_source, t]() {
+                for (int round = 0; round < 50; round++) {
+                    cow copy(shared_source);
+                    cow second(copy);
+                    CHECK(copy.size() == 1000 && cdata(copy)[999].value == "s");
+                    if ((round + t) % 2 == 0) {
+                        second.push_back("t");
+                        CHECK(second.size() == 1001 && copy.size() == 1000);
+                    }
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+        CHECK(!source.shared() && source.size() == 1000);
+    }
+    CHECK(counted::live == 0);
+}
+
+int main() {
+    test_sharing();
+    test_leaked();
+    test_erase_and_clear();
+    test_throwing_copies();
+    test_threads();
+    return check::result();
+}
@@ -0,0 +1,169 @@
+//
+// Tests for the per-thread free list of control blocks: a loop that holds an iterator
+// across a mutation stops allocating once the list is warm, invalidation diagnostics
+// survive the reuse, stateful allocators bypass the list, and blocks released on other
+// threads are freed when those threads exit.
+//
+#include <cstdlib>
+#include <memory_resource>
+#include <new>
+#include <thread>
+
+#include "Check.h"
+#include "Vector.h"
+
+static thread_local int heap_allocations = 0;
+
+void* operator new(size_t n) {
+    heap_allocations++;
+    if (void* p = std::malloc(n > 0 ? n : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+static int severity_of(const epl::Vector<int>::iterator& it) {
+    try {
+        (void)*it;
+    }
+    catch (const epl::invalid_iterator& e) {
+        return e.level;
+    }
+    return -1;
+}
+
+template <typename Checking>
+static void test_steady_state(void) {
+    epl::Vector<int, Checking> v;
+    v.reserve(1000);
+    for (int k = 0; k < 10; k++) {
+        auto it = v.begin();
+        v.push_back(k);
+    }
+    int before = heap_allocations;
+    for (int k = 0; k < 500; k++) {
+        auto it = v.begin();
+        v.push_back(k);
+    }
+    CHECK(heap_allocations == before);
+    CHECK(v.size() == 510 && v[509] == 499);
+}
+
+static void test_diagnostics_after_reuse(void) {
+    epl::Vector<int> v;
+    v.reserve(100);
+    v.push_back(1);
+    for (int k = 0; k < 50; k++) {
+        auto it = v.begin();
+        v.push_back(k);
+        //
+        // Each pass hands out a recycled block; the stale iterator still reports that
+        // it was invalidated by a push that did not move anything
+        //
+        CHECK(severity_of(it) == epl::invalid_iterator::MILD);
+        auto fresh = v.begin();
+        CHECK(*fresh == 1);
+    }
+    auto held = v.begin() + 1;
+    v.pop_back();
+    v.pop_front();
+    CHECK_THROWS(*held, epl::invalid_iterator);
+}
+
+//
+// Memory resource counting the blocks it has handed out and not yet taken back
+//
+class counting_resource : public std::pmr::memory_resource {
+public:
+    int live = 0;
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        live++;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        live--;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+static void test_stateful_allocator(void) {
+    //
+    // A pmr allocator is not always equal, so its blocks go back to their own resource
+    // straight away rather than onto the shared list
+    //
+    counting_resource resource;
+    {
+        typedef epl::Vector<int, epl::checking::full, std::pmr::polymorphic_allocator<int>> pmr_vector;
+        pmr_vector v{ std::pmr::polymorphic_allocator<int>(&resource) };
+        v.reserve(100);
+        int buffers = resource.live;
+        for (int k = 0; k < 20; k++) {
+            auto it = v.begin();
+            v.push_back(k);
+            CHECK(resource.live == buffers + 2);
+        }
+        CHECK(resource.live == buffers + 1);
+    }
+    CHECK(resource.live == 0);
+}
+
+template <typename Checking>
+static void test_other_threads(void) {
+    //
+    // The iterators die on another thread, so their blocks are released (and cached)
+    // there; LeakSanitizer checks that the thread frees its list on exit. With
+    // checking::full the thread gets the only copies; with checking::concurrent both
+    // threads drop theirs at the same time.
+    //
+    typedef epl::Vector<int, Checking> vector;
+    vector v;
+    v.reserve(1000);
+    for (int round = 0; round < 4; round++) {
+        typename vector::iterator its[8];
+        for (auto& it : its) {
+            it = v.begin();
+            v.push_back(round);
+        }
+        auto drop = [its]() mutable {
+            for (auto& it : its) {
+                it = typename vector::iterator();
+            }
+        };
+        if (!Checking::atomic_refs) {
+            for (auto& it : its) {
+                it = typename vector::iterator();
+            }
+        }
+        std::thread t(std::move(drop));
+        for (auto& it : its) {
+            it = typename vector::iterator();
+        }
+        t.join();
+    }
+    CHECK(v.size() == 32);
+}
+
+int main() {
+    test_steady_state<epl::checking::full>();
+    test_steady_state<epl::checking::concurrent>();
+    test_diagnostics_after_reuse();
+    test_stateful_allocator();
+    test_other_threads<epl::checking::full>();
+    test_other_threads<epl::checking::concurrent>();
+    return check::result();
+}
@@ -0,0 +1,121 @@
+//
+// Tests for the growth policies: the capacity arithmetic, the split of new cells
+// between the ends, recentering, and growth while pushing an element of the vector.
+//
+#include <string>
+
+#include "Check.h"
+#include "Vector.h"
+
+typedef epl::growth::policy<2, 1, 8, 100, 0> no_recenter;
+
+static void test_policy_arithmetic(void) {
+    CHECK(epl::growth::doubling::next_capacity(16, 17) == 32);
+    CHECK(epl::growth::doubling::next_capacity(2, 3) == 10);
+    CHECK(epl::growth::doubling::next_capacity(16, 100) == 100);
+    CHECK(epl::growth::compact::next_capacity(100, 101) == 150);
+    CHECK(epl::growth::compact::next_capacity(3, 4) == 11);
+
+    CHECK(epl::growth::doubling::growing_end_share(40) == 40);
+    CHECK(epl::growth::balanced::growing_end_share(40) == 20);
+    CHECK(epl::growth::balanced::growing_end_share(7) == 3);
+
+    CHECK(epl::growth::doubling::should_recenter(50, 100));
+    CHECK(!epl::growth::doubling::should_recenter(51, 100));
+    CHECK(!epl::growth::doubling::should_recenter(100, 100));
+    CHECK(!no_recenter::should_recenter(1, 100));
+}
+
+template <typename Growth>
+static void check_growth_step(void) {
+    //
+    // A full vector that grows at the back gets exactly the capacity the policy asks for
+    //
+    epl::Vector<int, epl::default_checking, std::allocator<int>, Growth> v;
+    for (int k = 0; k < 1000; k++) {
+        v.push_back(k);
+    }
+    while (v.size() < v.capacity()) {
+        v.push_back(0);
+    }
+    uint64_t full = v.capacity();
+    v.push_back(0);
+    CHECK(v.capacity() == Growth::next_capacity(full, full + 1));
+}
+
+static void test_growth_factor(void) {
+    check_growth_step<epl::growth::doubling>();
+    check_growth_step<epl::growth::compact>();
+}
+
+static void test_balanced_split(void) {
+    //
+    // After growing at the back, a balanced vector has room at the front too
+    //
+    epl::Vector<int, epl::default_checking, std::allocator<int>, epl::growth::balanced> v;
+    for (int k = 0; k < 100; k++) {
+        v.push_back(k);
+    }
+    uint64_t capacity = v.capacity();
+    for (int k = 0; k < 10; k++) {
+        v.push_front(-k);
+    }
+    CHECK(v.capacity() == capacity);
+    CHECK(v[0] == -9 && v[109] == 99);
+}
+
+template <typename Growth>
+static uint64_t alternating_capacity(void) {
+    //
+    // A vector kept at a few elements while it drifts towards one end: recentering
+    // reuses the buffer, without it the buffer keeps growing
+    //
+    epl::Vector<int, epl::default_checking, std::allocator<int>, Growth> v;
+    for (int k = 0; k < 10000; k++) {
+        v.push_back(k);
+        v.pop_front();
+        v.push_back(k);
+        if (v.size() > 4) {
+            v.pop_front();
+        }
+    }
+    return v.capacity();
+}
+
+static void test_recentering(void) {
+    CHECK(alternating_capacity<epl::growth::doubling>() <= 64);
+    CHECK(alternating_capacity<no_recenter>() > 64);
+
+    epl::Vector<std::string> v;
+    for (int k = 0; k < 4; k++) {
+        v.push_back(std::to_string(k));
+    }
+    for (int k = 0; k < 100; k++) {
+        v.push_back(std::to_string(k + 4));
+        v.pop_front();
+    }
+    CHECK(v.size() == 4);
+    CHECK(v[0] == "100" && v[3] == "103");
+}
+
+static void test_push_own_element(void) {
+    epl::Vector<std::string> v;
+    v.push_back("first");
+    for (int k = 0; k < 100; k++) {
+        v.push_back(v[0]);
+        v.push_front(v[v.size() - 1]);
+    }
+    CHECK(v.size() == 201);
+    for (uint64_t k = 0; k < v.size(); k++) {
+        CHECK(v[k] == "first");
+    }
+}
+
+int main() {
+    test_policy_arithmetic();
+    test_growth_factor();
+    test_balanced_split();
+    test_recentering();
+    test_push_own_element();
+    return check::result();
+}
@@ -0,0 +1,85 @@
+//
+// Tests for MappedVector: contents surviving a reopen, growth at both ends, and the
+// checks made when opening a file that is not a valid MappedVector file.
+//
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <unistd.h>
+
+#include "Check.h"
+#include "MappedVector.h"
+
+struct point {
+    int32_t x;
+    int32_t y;
+};
+
+static std::string temp_path(const char* name) {
+    return "/tmp/epl_mapped_" + std::to_string((long)::getpid()) + "_" + name;
+}
+
+static void test_reopen(void) {
+    std::string path = temp_path("reopen");
+    std::remove(path.c_str());
+    {
+        epl::MappedVector<point> v(path, 4);
+        CHECK(v.size() == 0);
+        for (int k = 0; k < 10000; k++) {
+            v.push_back(point{ k, -k });
+        }
+        for (int k = 1; k <= 100; k++) {
+            v.push_front(point{ -k, k });
+        }
+        v.pop_back();
+        v.sync();
+    }
+    {
+        epl::MappedVector<point> v(path);
+        CHECK(v.size() == 10099);
+        CHECK(v[0].x == -100 && v[99].x == -1 && v[100].x == 0);
+        CHECK(v[10098].x == 9998 && v[10098].y == -9998);
+        v.push_back(point{ 1, 1 });
+    }
+    {
+        //
+        // The destructor records the layout too, without an explicit sync()
+        //
+        epl::MappedVector<point> v(path);
+        CHECK(v.size() == 10100);
+        CHECK(v[10099].x == 1);
+    }
+    std::remove(path.c_str());
+}
+
+static void test_invalid_files(void) {
+    std::string path = temp_path("invalid");
+    {
+        std::ofstream out(path, std::ios::binary);
+        out << std::string(4096, 'x');
+    }
+    CHECK_THROWS(epl::MappedVector<point> v(path), std::runtime_error);
+
+    std::remove(path.c_str());
+    {
+        epl::MappedVector<point> v(path);
+        v.push_back(point{ 1, 2 });
+    }
+    CHECK_THROWS(epl::MappedVector<int64_t> v(path), std::runtime_error);
+    CHECK_THROWS(epl::MappedVector<char> v(path), std::runtime_error);
+
+    ::truncate(path.c_str(), 100);
+    CHECK_THROWS(epl::MappedVector<point> v(path), std::runtime_error);
+    std::remove(path.c_str());
+
+    CHECK_THROWS(epl::MappedVector<point> v("/nonexistent_dir/epl_mapped"), std::system_error);
+}
+
+int main() {
+    test_reopen();
+    test_invalid_files();
+    return check::result();
+}
@@ -0,0 +1,209 @@
+//
+// Tests for arena_resource, doubling_pool_resource and epl::pmr::Vector: what goes
+// upstream and when, reset() keeping the largest chunk, size class reuse, requests that
+// bypass the pool, and a Vector's buffers and control blocks coming from its resource.
+//
+#include <cstdint>
+#include <memory_resource>
+#include <vector>
+
+#include "Check.h"
+#include "MemoryResource.h"
+
+//
+// Upstream resource that records every block it hands out
+//
+class recording_resource : public std::pmr::memory_resource {
+public:
+    int live = 0;
+    int allocations = 0;
+    size_t last_bytes = 0;
+    size_t last_alignment = 0;
+    std::vector<size_t> sizes;
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        live++;
+        allocations++;
+        last_bytes = bytes;
+        last_alignment = alignment;
+        sizes.push_back(bytes);
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        live--;
+        for (size_t k = 0; k < sizes.size(); k++) {
+            if (sizes[k] == bytes) {
+                sizes.erase(sizes.begin() + k);
+                break;
+            }
+        }
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+static bool aligned(const void* p, size_t alignment) {
+    return reinterpret_cast<uintptr_t>(p) % alignment == 0;
+}
+
+static void test_arena(void) {
+    recording_resource upstream;
+    {
+        epl::arena_resource arena(1024, &upstream);
+        CHECK(upstream.allocations == 0);
+        void* a = arena.allocate(100, 8);
+        void* b = arena.allocate(100, 64);
+        CHECK(upstream.live == 1 && upstream.last_bytes == 1024);
+        CHECK(aligned(b, 64) && static_cast<char*>(b) >= static_cast<char*>(a) + 100);
+        arena.deallocate(a, 100, 8);
+        CHECK(upstream.live == 1 && arena.bytes_allocated() == 200);
+
+        //
+        // A request larger than the next chunk gets a chunk big enough for it, and the
+        // chunks after it keep growing geometrically
+        //
+        void* big = arena.allocate(10000, 16);
+        CHECK(upstream.live == 2 && upstream.last_bytes >= 10000 && aligned(big, 16));
+        size_t largest = upstream.last_bytes;
+        CHECK(arena.allocate(6000, 8) != nullptr);
+        CHECK(upstream.live == 2);
+        CHECK(arena.allocate(1000, 8) != nullptr);
+        CHECK(upstream.live == 3 && upstream.last_bytes == 2 * largest);
+        largest = upstream.last_bytes;
+
+        //
+        // reset() gives back all but the largest chunk, which serves the next round
+        //
+        arena.reset();
+        CHECK(upstream.live == 1 && upstream.sizes.size() == 1 && upstream.sizes[0] == largest);
+        CHECK(arena.bytes_allocated() == 0);
+        int allocations = upstream.allocations;
+        for (int k = 0; k < 10; k++) {
+            CHECK(arena.allocate(1000, 8) != nullptr);
+        }
+        CHECK(upstream.allocations == allocations && arena.bytes_allocated() == 10000);
+        arena.reset();
+        arena.reset();
+        CHECK(upstream.live == 1);
+
+        arena.release();
+        CHECK(upstream.live == 0);
+        arena.reset();
+        CHECK(arena.allocate(10, 8) != nullptr);
+        CHECK(upstream.live == 1);
+    }
+    CHECK(upstream.live == 0);
+}
+
+static void test_pool(void) {
+    recording_resource upstream;
+    {
+        epl::doubling_pool_resource pool((size_t)1 << 16, &upstream);
+        //
+        // Requests are rounded up to a power of two, aligned to their size
+        //
+        void* a = pool.allocate(100, 8);
+        CHECK(upstream.live == 1 && upstream.last_bytes == 128 && upstream.last_alignment == 128);
+        CHECK(aligned(a, 128));
+        pool.deallocate(a, 100, 8);
+        CHECK(upstream.live == 1);
+        void* b = pool.allocate(128, 16);
+        CHECK(b == a && upstream.allocations == 1);
+        void* c = pool.allocate(65, 8);
+        CHECK(c != b && upstream.allocations == 2);
+        void* d = pool.allocate(64, 8);
+        CHECK(upstream.allocations == 3 && upstream.last_bytes == 64);
+        pool.deallocate(d, 64, 8);
+        pool.deallocate(c, 65, 8);
+        pool.deallocate(b, 128, 16);
+
+        //
+        // Tiny requests share the smallest class; a big one is capped at page alignment
+        //
+        void* tiny = pool.allocate(1, 1);
+        CHECK(upstream.last_bytes == 16);
+        pool.deallocate(tiny, 1, 1);
+        CHECK(pool.allocate(20000, 8) != nullptr);
+        CHECK(upstream.last_bytes == 32768 && upstream.last_alignment == 4096);
+
+        //
+        // Over-aligned and oversized requests go straight upstream, both ways
+        //
+        int live = upstream.live;
+        void* over = pool.allocate(64, 256);
+        CHECK(upstream.live == live + 1 && upstream.last_bytes == 64 && upstream.last_alignment == 256);
+        CHECK(aligned(over, 256));
+        pool.deallocate(over, 64, 256);
+        CHECK(upstream.live == live);
+        void* huge = pool.allocate((size_t)1 << 17, 8);
+        CHECK(upstream.live == live + 1 && upstream.last_bytes == (size_t)1 << 17);
+        pool.deallocate(huge, (size_t)1 << 17, 8);
+        CHECK(upstream.live == live);
+
+        pool.release();
+        CHECK(upstream.live == 0);
+        CHECK(pool.allocate(100, 8) != nullptr);
+        CHECK(upstream.live == 1);
+    }
+    CHECK(upstream.live == 0);
+}
+
+static void test_pmr_vector(void) {
+    recording_resource upstream;
+    {
+        //
+        // A doubling Vector on the pool: after the first round every buffer it grows
+        // into is one an earlier round gave back
+        //
+        epl::doubling_pool_resource pool((size_t)1 << 24, &upstream);
+        int allocations = 0;
+        for (int round = 0; round < 5; round++) {
+            epl::pmr::Vector<int> v(&pool);
+            for (int k = 0; k < 10000; k++) {
+                v.push_back(k);
+            }
+            auto it = v.begin();
+            CHECK(it[9999] == 9999);
+            if (round == 0) {
+                allocations = upstream.allocations;
+            }
+        }
+        CHECK(upstream.allocations == allocations);
+    }
+    CHECK(upstream.live == 0);
+
+    //
+    // The control block comes from the resource as well: handing out the first
+    // iterator takes bytes from the arena
+    //
+    epl::arena_resource arena(4096, &upstream);
+    {
+        epl::pmr::Vector<int> v(&arena);
+        v.reserve(10);
+        v.push_back(1);
+        size_t before = arena.bytes_allocated();
+        auto it = v.begin();
+        CHECK(arena.bytes_allocated() > before && *it == 1);
+
+        epl::pmr::Vector<int, epl::checking::none> raw(&arena);
+        raw.reserve(10);
+        before = arena.bytes_allocated();
+        raw.push_back(1);
+        auto p = raw.begin();
+        CHECK(arena.bytes_allocated() == before && *p == 1);
+    }
+    arena.reset();
+    CHECK(arena.bytes_allocated() == 0 && upstream.live == 1);
+}
+
+int main() {
+    test_arena();
+    test_pool();
+    test_pmr_vector();
+    return check::result();
+}
@@ -0,0 +1,226 @@
+//
+// Tests for mmap_allocator and the Vectors built on it: blocks on either side of the
+// threshold, growth that crosses it, a mapping that mremap extends where it lies,
+// over-aligned elements, HugePageVector, and elements that are not trivially
+// relocatable, which a Vector keeps moving into new buffers the usual way.
+//
+#include <cstdint>
+#include <string>
+
+#include <sys/mman.h>
+
+#include "Check.h"
+#include "MmapAllocator.h"
+
+//
+// A threshold of one page keeps the mapped blocks small
+//
+static const size_t page = 4096;
+
+template <typename T>
+using small_mmap = epl::mmap_allocator<T, page>;
+
+//
+// Forwards to mmap_allocator and counts the calls to reallocate()
+//
+template <typename T>
+struct counting_mmap : small_mmap<T> {
+    static int reallocations;
+
+    template <typename U>
+    struct rebind {
+        typedef counting_mmap<U> other;
+    };
+
+    counting_mmap(void) = default;
+
+    template <typename U>
+    counting_mmap(const counting_mmap<U>&) {}
+
+    T* reallocate(T* p, size_t old_n, size_t new_n) {
+        reallocations++;
+        return small_mmap<T>::reallocate(p, old_n, new_n);
+    }
+};
+
+template <typename T>
+int counting_mmap<T>::reallocations = 0;
+
+struct alignas(128) wide {
+    int value;
+    char pad[124];
+};
+
+static bool page_aligned(const void* p) {
+    return reinterpret_cast<uintptr_t>(p) % epl::detail::page_size() == 0;
+}
+
+template <typename T>
+static bool aligned(const T* p) {
+    return reinterpret_cast<uintptr_t>(p) % alignof(T) == 0;
+}
+
+static bool counts_up(const int* p, size_t n) {
+    bool ok = true;
+    for (size_t k = 0; k < n; k++) {
+        ok = ok && p[k] == (int)k;
+    }
+    return ok;
+}
+
+static void test_threshold(void) {
+    if (epl::detail::page_size() != page) {
+        return;
+    }
+    small_mmap<int> alloc;
+    const size_t per_page = page / sizeof(int);
+
+    //
+    // malloc block, grown with realloc below the threshold, then copied into a mapping
+    // once it crosses it, and back into a malloc block when it shrinks below again
+    //
+    int* p = alloc.allocate(10);
+    for (int k = 0; k < 10; k++) {
+        p[k] = k;
+    }
+    p = alloc.reallocate(p, 10, 100);
+    CHECK(counts_up(p, 10));
+    for (int k = 10; k < 100; k++) {
+        p[k] = k;
+    }
+    p = alloc.reallocate(p, 100, 3 * per_page);
+    CHECK(page_aligned(p) && counts_up(p, 100));
+    for (size_t k = 100; k < 3 * per_page; k++) {
+        p[k] = (int)k;
+    }
+    p = alloc.reallocate(p, 3 * per_page, 5 * per_page);
+    CHECK(page_aligned(p) && counts_up(p, 3 * per_page));
+    p = alloc.reallocate(p, 5 * per_page, 50);
+    CHECK(counts_up(p, 50));
+    alloc.deallocate(p, 50);
+}
+
+static void test_mremap_in_place(void) {
+    if (epl::detail::page_size() != page) {
+        return;
+    }
+    //
+    // A one page mapping with free address space right behind it: growing it keeps
+    // the address and the contents
+    //
+    small_mmap<int> alloc;
+    const size_t per_page = page / sizeof(int);
+    void* region = ::mmap(nullptr, 16 * page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    CHECK(region != MAP_FAILED);
+    CHECK(::munmap(static_cast<char*>(region) + page, 15 * page) == 0);
+    int* p = static_cast<int*>(region);
+    for (size_t k = 0; k < per_page; k++) {
+        p[k] = (int)k;
+    }
+    int* q = alloc.reallocate(p, per_page, 8 * per_page);
+    CHECK(q == p && counts_up(q, per_page));
+    q[8 * per_page - 1] = 7;
+    alloc.deallocate(q, 8 * per_page);
+}
+
+static void test_vector_growth(void) {
+    //
+    // A Vector of ints grows through reallocate() on both sides of the threshold
+    //
+    counting_mmap<int>::reallocations = 0;
+    {
+        epl::Vector<int, epl::default_checking, counting_mmap<int>> v;
+        for (int k = 0; k < 100000; k++) {
+            v.push_back(k);
+        }
+        CHECK(counting_mmap<int>::reallocations > 5);
+        CHECK(v.size() == 100000 && counts_up(&v[0], 100000));
+        auto it = v.begin();
+        for (int k = 0; k < 100000; k++) {
+            v.push_back(k);
+        }
+        CHECK_THROWS(*it, epl::invalid_iterator);
+        CHECK(v[199999] == 99999);
+    }
+
+    //
+    // std::string (libstdc++ keeps a pointer into itself) is not trivially relocatable,
+    // so its Vector never calls reallocate() and moves each element instead
+    //
+    counting_mmap<std::string>::reallocations = 0;
+    {
+        epl::Vector<std::string, epl::default_checking, counting_mmap<std::string>> v;
+        uint64_t capacity = v.capacity();
+        for (int k = 0; k < 2000; k++) {
+            v.push_back(std::to_string(k));
+            v.push_front(std::to_string(-k));
+        }
+        CHECK(v.capacity() > capacity && v.capacity() * sizeof(std::string) >= page);
+        CHECK(counting_mmap<std::string>::reallocations == 0);
+        CHECK(v[0] == "-1999" && v[1999] == "0" && v[2000] == "0" && v[3999] == "1999");
+    }
+}
+
+static void test_over_aligned(void) {
+    //
+    // Small blocks of over-aligned elements come from the aligned operator new and are
+    // copied rather than realloc'ed; mapped ones are page aligned anyway
+    //
+    small_mmap<wide> alloc;
+    wide* p = alloc.allocate(3);
+    CHECK(aligned(p));
+    for (int k = 0; k < 3; k++) {
+        p[k].value = k;
+    }
+    p = alloc.reallocate(p, 3, 5);
+    CHECK(aligned(p) && p[2].value == 2);
+    p = alloc.reallocate(p, 5, 100);
+    CHECK(aligned(p) && page_aligned(p) && p[0].value == 0 && p[2].value == 2);
+    p = alloc.reallocate(p, 100, 4);
+    CHECK(aligned(p) && p[1].value == 1);
+    alloc.deallocate(p, 4);
+
+    epl::Vector<wide, epl::default_checking, small_mmap<wide>> v;
+    bool ok = true;
+    for (int k = 0; k < 1000; k++) {
+        wide w;
+        w.value = k;
+        v.push_back(w);
+        ok = ok && aligned(&v[0]);
+    }
+    for (int k = 0; k < 1000; k++) {
+        ok = ok && v[k].value == k;
+    }
+    CHECK(ok);
+}
+
+static void test_huge_pages(void) {
+    //
+    // Past 2 MiB the buffer is an (advised) mapping; pushes at the back keep the
+    // elements at its start
+    //
+    epl::HugePageVector<int> v;
+    const int n = 1 << 20;
+    for (int k = 0; k < n; k++) {
+        v.push_back(k);
+    }
+    CHECK(v.size() == (uint64_t)n && counts_up(&v[0], n));
+    CHECK(page_aligned(&v[0]));
+    v.pop_back(n - 10);
+    CHECK(v.size() == 10 && counts_up(&v[0], 10));
+
+    epl::MmapVector<double> d;
+    for (int k = 0; k < 300000; k++) {
+        d.push_front(k);
+    }
+    CHECK(d[0] == 299999 && d[299999] == 0);
+}
+
+int main() {
+    test_threshold();
+    test_mremap_in_place();
+    test_vector_growth();
+    test_over_aligned();
+    test_huge_pages();
+    return check::result();
+}
@@ -0,0 +1,179 @@
+//
+// Tests for ThreadPool and the parallel algorithms: chunk coverage, nesting, exception
+// propagation, pools without workers, and the per chunk invalidation check.
+//
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Check.h"
+#include "Parallel.h"
+
+static void test_parallel_for(void) {
+    for (unsigned threads : { 0u, 1u, 3u }) {
+        epl::ThreadPool pool(threads);
+        CHECK(pool.size() == threads);
+        for (uint64_t grain : { 1u, 7u, 1000u, 5000u }) {
+            std::vector<std::atomic<int>> hits(3001);
+            for (auto& h : hits) {
+                h = 0;
+            }
+            pool.parallel_for(0, 3001, grain, [&hits, grain](uint64_t lo, uint64_t hi) {
+                CHECK(hi > lo && hi - lo <= grain);
+                for (uint64_t k = lo; k < hi; k++) {
+                    hits[k]++;
+                }
+            });
+            bool once = true;
+            for (auto& h : hits) {
+                once = once && h == 1;
+            }
+            CHECK(once);
+        }
+        int calls = 0;
+        pool.parallel_for(5, 5, 1, [&calls](uint64_t, uint64_t) { calls++; });
+        CHECK(calls == 0);
+    }
+}
+
+static void test_nested_and_submit(void) {
+    epl::ThreadPool pool(2);
+    std::atomic<int> leaves(0);
+    pool.parallel_for(0, 8, 1, [&pool, &leaves](uint64_t, uint64_t) {
+        pool.parallel_for(0, 8, 1, [&pool, &leaves](uint64_t, uint64_t) {
+            pool.parallel_for(0, 4, 1, [&leaves](uint64_t, uint64_t) { leaves++; });
+        });
+    });
+    CHECK(leaves == 8 * 8 * 4);
+
+    std::atomic<int> done(0);
+    for (int k = 0; k < 100; k++) {
+        pool.submit([&done] { done++; });
+    }
+    while (done.load() < 100) {
+        if (!pool.run_one()) {
+            std::this_thread::yield();
+        }
+    }
+    CHECK(done == 100);
+
+    //
+    // The destructor runs whatever is still queued
+    //
+    std::atomic<int> drained(0);
+    {
+        epl::ThreadPool local(1);
+        for (int k = 0; k < 50; k++) {
+            local.submit([&drained] { drained++; });
+        }
+    }
+    CHECK(drained == 50);
+
+    epl::ThreadPool inline_pool(0);
+    int ran = 0;
+    inline_pool.submit([&ran] { ran++; });
+    CHECK(ran == 1);
+    CHECK(!inline_pool.run_one());
+}
+
+static void test_exceptions(void) {
+    for (unsigned threads : { 0u, 2u }) {
+        epl::ThreadPool pool(threads);
+        std::atomic<int> started(0);
+        CHECK_THROWS(pool.parallel_for(0, 1000, 1, [&started](uint64_t lo, uint64_t) {
+            started++;
+            if (lo == 10) {
+                throw std::runtime_error("chunk");
+            }
+        }), std::runtime_error);
+        CHECK(started <= 1000);
+        //
+        // The pool is still usable afterwards
+        //
+        std::atomic<int> count(0);
+        pool.parallel_for(0, 100, 1, [&count](uint64_t, uint64_t) { count++; });
+        CHECK(count == 100);
+    }
+}
+
+static void test_algorithms(void) {
+    epl::ThreadPool pool(3);
+    epl::Vector<int64_t> v;
+    for (int64_t k = 0; k < 100000; k++) {
+        v.push_back(k);
+    }
+    CHECK(epl::parallel::reduce(v, pool) == 100000LL * 99999 / 2);
+    CHECK(epl::parallel::count_if(v, [](int64_t x) { return x % 3 == 0; }, pool) == 33334);
+
+    epl::parallel::for_each(v, [](int64_t& x) { x *= 2; }, pool);
+    CHECK(v[99999] == 199998);
+    int64_t visited = 0;
+    const epl::Vector<int64_t>& cv = v;
+    std::atomic<int64_t> sum(0);
+    epl::parallel::for_each(cv, [&sum](const int64_t& x) { sum += x; }, pool);
+    visited = sum;
+    CHECK(visited == 100000LL * 99999);
+
+    epl::Vector<std::string> strings;
+    epl::parallel::transform(v, strings, [](int64_t x) { return std::to_string(x); }, pool);
+    CHECK(strings.size() == 100000 && strings[12345] == "24690");
+    epl::parallel::transform(v, v, [](int64_t x) { return x / 2; }, pool);
+    CHECK(v[777] == 777);
+
+    //
+    // Non-commutative fold: concatenation keeps chunk order
+    //
+    epl::Vector<std::string> letters;
+    for (int k = 0; k < 20000; k++) {
+        letters.push_back(std::string(1, (char)('a' + k % 26)));
+    }
+    std::string joined = epl::parallel::reduce(letters, std::string(),
+        [](std::string a, const std::string& b) { return a + b; }, pool);
+    CHECK(joined.size() == 20000 && joined.substr(0, 3) == "abc" && joined[19999] == 'a' + 19999 % 26);
+
+    epl::Vector<int64_t> evens{ -2, -4 };
+    uint64_t appended = epl::parallel::copy_if(v, evens, [](int64_t x) { return x % 2 == 0; }, pool);
+    CHECK(appended == 50000);
+    CHECK(evens.size() == 50002 && evens[0] == -2 && evens[2] == 0 && evens[50001] == 99998);
+    CHECK(epl::parallel::copy_if(v, evens, [](int64_t) { return false; }, pool) == 0);
+
+    epl::Vector<int64_t> empty;
+    CHECK(epl::parallel::reduce(empty, (int64_t)5, [](int64_t a, int64_t b) { return a + b; }, pool) == 5);
+}
+
+static void test_invalidation_between_chunks(void) {
+    //
+    // A pool without workers runs the chunks in order on this thread; a push made
+    // from the first chunk (into reserved room, so nothing moves) is caught before the
+    // next chunk
+    //
+    epl::ThreadPool pool(0);
+    epl::Vector<int> v;
+    v.reserve(3 * epl::parallel::min_grain + 10);
+    for (uint64_t k = 0; k < 3 * epl::parallel::min_grain; k++) {
+        v.push_back(1);
+    }
+    int* first = &v[0];
+    CHECK_THROWS(epl::parallel::for_each(v, [&v, first](int& x) {
+        if (&x == first) {
+            v.push_back(2);
+        }
+    }, pool), epl::invalid_iterator);
+
+    epl::Vector<int, epl::checking::none> unchecked;
+    for (int k = 0; k < 10; k++) {
+        unchecked.push_back(k);
+    }
+    CHECK(epl::parallel::reduce(unchecked, pool) == 45);
+}
+
+int main() {
+    test_parallel_for();
+    test_nested_and_submit();
+    test_exceptions();
+    test_algorithms();
+    test_invalidation_between_chunks();
+    return check::result();
+}
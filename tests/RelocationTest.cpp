@@ -0,0 +1,165 @@
+//
+// Tests for relocation on growth: trivially relocatable elements (including Vectors and
+// types that opt in through the trait) go over with one memcpy, without a move or a
+// destructor call, and SmallVector, whose inline storage points into itself, does not.
+//
+#include <memory>
+#include <string>
+
+#include "Check.h"
+#include "SmallVector.h"
+#include "Vector.h"
+
+//
+// Counts moves, copies and destructor calls. Its value lives on the heap, so it holds
+// no pointer into itself, and the specialization below lets tracked<true> be memcpy
+// relocated.
+//
+template <bool Relocatable>
+struct tracked {
+    static int moves;
+    static int copies;
+    static int destroyed;
+
+    std::unique_ptr<int> value;
+
+    tracked(int v) : value(new int(v)) {}
+
+    tracked(const tracked& other) : value(new int(*other.value)) {
+        copies++;
+    }
+
+    tracked(tracked&& other) : value(std::move(other.value)) {
+        moves++;
+    }
+
+    tracked& operator=(const tracked& other) {
+        value.reset(new int(*other.value));
+        return *this;
+    }
+
+    tracked& operator=(tracked&&) = default;
+
+    ~tracked() {
+        destroyed++;
+    }
+
+    static void reset(void) {
+        moves = copies = destroyed = 0;
+    }
+};
+
+template <bool Relocatable>
+int tracked<Relocatable>::moves = 0;
+template <bool Relocatable>
+int tracked<Relocatable>::copies = 0;
+template <bool Relocatable>
+int tracked<Relocatable>::destroyed = 0;
+
+typedef tracked<true> opted_in;
+typedef tracked<false> opted_out;
+
+namespace epl
+{
+    template <>
+    struct is_trivially_relocatable<opted_in> : std::true_type {};
+}
+
+static_assert(epl::is_trivially_relocatable<int>::value, "trivially copyable");
+static_assert(epl::is_trivially_relocatable<epl::Vector<std::string>>::value, "Vector");
+static_assert(!epl::is_trivially_relocatable<std::string>::value, "not opted in");
+static_assert(!epl::is_trivially_relocatable<epl::SmallVector<int, 4>>::value, "inline storage");
+
+template <typename T>
+static bool grows_without_moves(void) {
+    //
+    // Pushes at both ends until the buffer has been replaced several times, and returns
+    // whether no element was moved, copied or destroyed along the way
+    //
+    T::reset();
+    bool ordered = true;
+    {
+        epl::Vector<T> v;
+        for (int k = 0; k < 1000; k++) {
+            v.push_back(T(k));
+            v.push_front(T(-k - 1));
+        }
+        T::reset();
+        for (int k = 1000; k < 5000; k++) {
+            v.emplace_back(k);
+        }
+        for (uint64_t k = 0; k < v.size(); k++) {
+            ordered = ordered && *v[k].value == (int)k - 1000;
+        }
+        CHECK(ordered && v.size() == 6000);
+        if (T::moves != 0 || T::copies != 0 || T::destroyed != 0) {
+            return false;
+        }
+    }
+    CHECK(T::destroyed == 6000);
+    return true;
+}
+
+static void test_opt_in(void) {
+    CHECK(grows_without_moves<opted_in>());
+    CHECK(!grows_without_moves<opted_out>());
+    CHECK(opted_out::copies == 0);
+}
+
+static void test_nested_vectors(void) {
+    //
+    // The inner Vectors' buffers and control blocks stay where they are, so iterators
+    // into them stay valid while the outer Vector grows
+    //
+    epl::Vector<epl::Vector<std::string>> outer;
+    outer.push_back(epl::Vector<std::string>{ "a", "b", "c" });
+    outer[0].reserve(10);
+    auto it = outer[0].begin() + 1;
+    const std::string* address = &outer[0][2];
+    uint64_t capacity = outer.capacity();
+    for (int k = 0; k < 1000; k++) {
+        outer.push_back(epl::Vector<std::string>{ std::to_string(k) });
+        outer.push_front(epl::Vector<std::string>{});
+    }
+    CHECK(outer.capacity() > capacity);
+    epl::Vector<std::string>& inner = outer[1000];
+    CHECK(*it == "b" && &inner[2] == address);
+    it++;
+    CHECK(*it == "c" && it + 1 == inner.end());
+    inner.push_back("d");
+    CHECK_THROWS(*it, epl::invalid_iterator);
+    CHECK(outer[2000][0] == "999");
+}
+
+static void test_small_vectors(void) {
+    //
+    // Inline elements live inside the SmallVector object, so a memcpy would leave them
+    // pointing at the old buffer; each one is move constructed instead
+    //
+    epl::Vector<epl::SmallVector<std::string, 2>> v;
+    for (int k = 0; k < 500; k++) {
+        epl::SmallVector<std::string, 2> small;
+        small.push_back(std::to_string(k));
+        if (k % 2) {
+            small.push_back("x");
+        }
+        if (k % 3 == 0) {
+            small.push_back("spilled");
+        }
+        v.push_back(std::move(small));
+    }
+    bool intact = true;
+    for (int k = 0; k < 500; k++) {
+        intact = intact && v[k][0] == std::to_string(k) && v[k].size() == 1u + k % 2 + (k % 3 == 0);
+        auto first = v[k].begin();
+        intact = intact && *first == std::to_string(k);
+    }
+    CHECK(intact);
+}
+
+int main() {
+    test_opt_in();
+    test_nested_vectors();
+    test_small_vectors();
+    return check::result();
+}
@@ -0,0 +1,179 @@
+//
+// Tests for Vector's reserve, reserve_front, resize, append, prepend and the range
+// constructor: single reallocations, iterator invalidation and the throw paths.
+//
+#include <iterator>
+#include <list>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "Check.h"
+#include "Vector.h"
+
+//
+// Element that counts its live instances and whose copy constructor throws once the
+// countdown runs out
+//
+struct bomb {
+    static int live;
+    static int countdown;
+
+    int value;
+
+    bomb(int v = 0) : value(v) {
+        live++;
+    }
+
+    bomb(const bomb& other) : value(other.value) {
+        if (countdown >= 0 && countdown-- == 0) {
+            throw std::runtime_error("bomb");
+        }
+        live++;
+    }
+
+    ~bomb() {
+        live--;
+    }
+};
+
+int bomb::live = 0;
+int bomb::countdown = -1;
+
+template <typename F>
+static int severity_of(F f) {
+    try {
+        f();
+    }
+    catch (const epl::invalid_iterator& e) {
+        return e.level;
+    }
+    return -1;
+}
+
+static void test_reserve(void) {
+    epl::Vector<int> v;
+    v.reserve(1000);
+    CHECK(v.capacity() >= 1000);
+    v.push_back(0);
+    const int* data = &v[0];
+    for (int k = 1; k < 1000; k++) {
+        v.push_back(k);
+    }
+    CHECK(&v[0] == data);
+    CHECK(v.size() == 1000 && v[999] == 999);
+
+    auto it = v.begin();
+    v.reserve(10);
+    CHECK(*it == 0);
+
+    epl::Vector<int> f;
+    f.reserve_front(500);
+    f.push_front(0);
+    const int* last = &f[0];
+    for (int k = 1; k < 500; k++) {
+        f.push_front(k);
+    }
+    CHECK(&f[499] == last);
+    CHECK(f[0] == 499);
+}
+
+static void test_resize(void) {
+    epl::Vector<std::string> v;
+    v.resize(10);
+    CHECK(v.size() == 10 && v[9].empty());
+    for (int k = 0; k < 10; k++) {
+        v[k] = std::to_string(k);
+    }
+    auto head = v.begin();
+    auto tail = v.begin() + 8;
+    v.resize(5);
+    CHECK(v.size() == 5 && v[4] == "4");
+    CHECK(severity_of([&] { *head; }) == epl::invalid_iterator::MILD);
+    CHECK(severity_of([&] { *tail; }) == epl::invalid_iterator::SEVERE);
+    v.resize(5);
+    CHECK(v.size() == 5);
+    v.resize(0);
+    CHECK(v.size() == 0);
+}
+
+static void test_append_prepend(void) {
+    epl::Vector<int> v{ 3, 4 };
+    std::vector<int> back{ 5, 6, 7 };
+    std::list<int> front{ 1, 2 };
+    v.append(back.begin(), back.end());
+    v.prepend(front.begin(), front.end());
+    CHECK(v.size() == 7);
+    for (int k = 0; k < 7; k++) {
+        CHECK(v[k] == k + 1);
+    }
+
+    std::istringstream in("8 9 10");
+    v.append(std::istream_iterator<int>(in), std::istream_iterator<int>());
+    std::istringstream pre("-1 0");
+    v.prepend(std::istream_iterator<int>(pre), std::istream_iterator<int>());
+    CHECK(v.size() == 12);
+    CHECK(v[0] == -1 && v[1] == 0 && v[11] == 10);
+
+    epl::Vector<int> empty;
+    empty.append(back.begin(), back.begin());
+    CHECK(empty.size() == 0);
+}
+
+static void test_range_constructor(void) {
+    std::vector<std::string> src{ "a", "b", "c" };
+    epl::Vector<std::string> v(src.begin(), src.end());
+    CHECK(v.size() == 3 && v[2] == "c");
+    std::istringstream in("1 2 3 4");
+    epl::Vector<int> w{ std::istream_iterator<int>(in), std::istream_iterator<int>() };
+    CHECK(w.size() == 4 && w[3] == 4);
+    epl::Vector<int> e{};
+    CHECK(e.size() == 0);
+    e.push_back(1);
+    CHECK(e[0] == 1);
+}
+
+static void test_throwing_copies(void) {
+    {
+        std::vector<bomb> src(10);
+        epl::Vector<bomb> v;
+        v.push_back(bomb(-1));
+        bomb::countdown = 4;
+        CHECK_THROWS(v.append(src.begin(), src.end()), std::runtime_error);
+        bomb::countdown = -1;
+        CHECK(v.size() == 1 && v[0].value == -1);
+
+        bomb::countdown = 3;
+        CHECK_THROWS(v.prepend(src.begin(), src.end()), std::runtime_error);
+        bomb::countdown = -1;
+        CHECK(v.size() == 1);
+
+        bomb::countdown = 5;
+        CHECK_THROWS((epl::Vector<bomb>(src.begin(), src.end())), std::runtime_error);
+        bomb::countdown = -1;
+
+        //
+        // A prepend that reallocates before a copy throws still tells the iterators
+        // about the new buffer. The first copy is the relocation of v's own element,
+        // the fourth the third element of the list.
+        //
+        std::list<bomb> many(100);
+        auto it = v.begin();
+        bomb::countdown = 3;
+        CHECK_THROWS(v.prepend(many.begin(), many.end()), std::runtime_error);
+        bomb::countdown = -1;
+        CHECK(v.size() == 1 && v[0].value == -1 && v.capacity() >= 101);
+        CHECK(severity_of([&] { *it; }) == epl::invalid_iterator::MODERATE);
+    }
+    CHECK(bomb::live == 0);
+}
+
+int main() {
+    test_reserve();
+    test_resize();
+    test_append_prepend();
+    test_range_constructor();
+    test_throwing_copies();
+    return check::result();
+}
@@ -0,0 +1,271 @@
+//
+// Tests for RingQueue and MPMCRingQueue: capacity, ordering, bulk operations,
+// elements left in the queue, exactly-once delivery between threads, and the queue
+// staying usable after an element constructor or move throws.
+//
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Check.h"
+#include "RingQueue.h"
+
+//
+// Counts live instances; constructing from a negative value throws, and so does
+// move assigning from one whose value is 2000
+//
+struct fragile {
+    static std::atomic<int> live;
+
+    int value;
+
+    fragile(void) : value(0) {
+        live++;
+    }
+
+    fragile(int v) : value(v) {
+        if (v < 0) {
+            throw std::runtime_error("fragile");
+        }
+        live++;
+    }
+
+    fragile(const fragile& other) : value(other.value) {
+        live++;
+    }
+
+    fragile& operator=(fragile&& other) {
+        if (other.value == 2000) {
+            throw std::runtime_error("fragile move");
+        }
+        value = other.value;
+        return *this;
+    }
+
+    ~fragile() {
+        live--;
+    }
+};
+
+std::atomic<int> fragile::live(0);
+
+static void test_spsc_single_thread(void) {
+    epl::RingQueue<std::string> q(5);
+    CHECK(q.capacity() == 8);
+    CHECK(q.empty());
+    for (int k = 0; k < 8; k++) {
+        CHECK(q.try_push(std::to_string(k)));
+    }
+    CHECK(!q.try_push("full"));
+    CHECK(q.size() == 8);
+    std::string out;
+    for (int k = 0; k < 8; k++) {
+        CHECK(q.try_pop(out) && out == std::to_string(k));
+    }
+    CHECK(!q.try_pop(out));
+
+    std::vector<std::string> in{ "a", "b", "c", "d", "e", "f", "g", "h", "i", "j" };
+    CHECK(q.push_bulk(in.begin(), in.size()) == 8);
+    std::vector<std::string> popped(10);
+    CHECK(q.pop_bulk(popped.begin(), 10) == 8);
+    CHECK(popped[0] == "a" && popped[7] == "h");
+}
+
+static void test_leftovers_destroyed(void) {
+    {
+        epl::RingQueue<fragile> q(4);
+        q.try_emplace(1);
+        q.try_emplace(2);
+        epl::MPMCRingQueue<fragile> m(4);
+        m.try_emplace(1);
+        m.try_emplace(2);
+        m.try_emplace(3);
+    }
+    CHECK(fragile::live == 0);
+}
+
+static void test_spsc_throwing_bulk(void) {
+    {
+        epl::RingQueue<fragile> q(8);
+        fragile out;
+        CHECK(q.try_emplace(1));
+
+        //
+        // A copy that throws half way through a batch takes the rest of the batch with
+        // it; the element queued before it is untouched
+        //
+        int in[5] = { 2, 3, 4, -1, 5 };
+        CHECK_THROWS(q.push_bulk(in, 5), std::runtime_error);
+        CHECK(q.size() == 1 && fragile::live == 2);
+        CHECK(q.push_bulk(in, 3) == 3);
+
+        //
+        // A move that throws leaves the moved-out elements popped and the failing one
+        // at the front
+        //
+        CHECK(q.try_emplace(2000));
+        CHECK(q.try_emplace(6));
+        std::vector<fragile> popped(6);
+        CHECK_THROWS(q.pop_bulk(popped.begin(), 6), std::runtime_error);
+        CHECK(q.size() == 2 && popped[0].value == 1 && popped[3].value == 4);
+        CHECK_THROWS(q.try_pop(out), std::runtime_error);
+        CHECK(q.size() == 2);
+
+        //
+        // Both sides carry on with the cells they got back
+        //
+        int more[6] = { 7, 8, 9, 10, 11, 12 };
+        CHECK(q.push_bulk(more, 6) == 6);
+        CHECK(q.size() == 8);
+    }
+    CHECK(fragile::live == 0);
+}
+
+static void test_spsc_threads(void) {
+    const int n = 20000;
+    epl::RingQueue<int> q(64);
+    std::thread producer([&q] {
+        int k = 0;
+        while (k < n) {
+            if (k % 7 == 0) {
+                int batch[5] = { k, k + 1, k + 2, k + 3, k + 4 };
+                int count = (int)q.push_bulk(batch, n - k < 5 ? n - k : 5);
+                k += count;
+            }
+            else if (q.try_push(k)) {
+                k++;
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    bool ordered = true;
+    int expected = 0;
+    while (expected < n) {
+        int batch[3];
+        uint64_t count = q.pop_bulk(batch, 3);
+        if (count == 0) {
+            std::this_thread::yield();
+        }
+        for (uint64_t k = 0; k < count; k++) {
+            ordered = ordered && batch[k] == expected;
+            expected++;
+        }
+    }
+    producer.join();
+    CHECK(ordered);
+    CHECK(q.empty());
+}
+
+static void test_mpmc_threads(void) {
+    const int producers = 3, consumers = 3, per_producer = 5000;
+    epl::MPMCRingQueue<int> q(128);
+    std::vector<std::atomic<int>> seen(producers * per_producer);
+    for (auto& s : seen) {
+        s = 0;
+    }
+    std::atomic<int> consumed(0);
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&q, p] {
+            for (int k = 0; k < per_producer;) {
+                if (q.try_push(p * per_producer + k)) {
+                    k++;
+                }
+                else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (int c = 0; c < consumers; c++) {
+        threads.emplace_back([&q, &seen, &consumed] {
+            int value;
+            while (consumed.load() < producers * per_producer) {
+                if (q.try_pop(value)) {
+                    seen[value]++;
+                    consumed++;
+                }
+                else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    bool once = true;
+    for (auto& s : seen) {
+        once = once && s == 1;
+    }
+    CHECK(once);
+    CHECK(q.empty());
+}
+
+static void test_mpmc_throwing_constructor(void) {
+    {
+        epl::MPMCRingQueue<fragile> q(4);
+        fragile out;
+        CHECK(q.try_emplace(1));
+        CHECK_THROWS(q.try_emplace(-1), std::runtime_error);
+        CHECK(q.try_emplace(2));
+        CHECK(q.try_pop(out) && out.value == 1);
+        CHECK(q.try_pop(out) && out.value == 2);
+        CHECK(!q.try_pop(out));
+        //
+        // The queue keeps cycling through all of its cells afterwards
+        //
+        for (int k = 0; k < 20; k++) {
+            if (k % 5 == 0) {
+                CHECK_THROWS(q.try_emplace(-k - 1), std::runtime_error);
+            }
+            CHECK(q.try_emplace(k + 10));
+            CHECK(q.try_pop(out) && out.value == k + 10);
+        }
+        CHECK(!q.try_pop(out));
+
+        //
+        // A queue whose cells are all tombstones is empty, not stuck
+        //
+        for (int k = 0; k < 4; k++) {
+            CHECK_THROWS(q.try_emplace(-1), std::runtime_error);
+        }
+        CHECK(!q.try_pop(out));
+        CHECK(q.try_emplace(7));
+        CHECK(q.try_pop(out) && out.value == 7);
+        CHECK(q.try_emplace(8));
+    }
+    CHECK(fragile::live == 0);
+}
+
+static void test_mpmc_throwing_move(void) {
+    {
+        epl::MPMCRingQueue<fragile> q(4);
+        fragile out;
+        CHECK(q.try_emplace(2000));
+        CHECK(q.try_emplace(3));
+        CHECK_THROWS(q.try_pop(out), std::runtime_error);
+        CHECK(q.try_pop(out) && out.value == 3);
+        for (int k = 0; k < 10; k++) {
+            CHECK(q.try_emplace(k));
+            CHECK(q.try_pop(out) && out.value == k);
+        }
+    }
+    CHECK(fragile::live == 0);
+}
+
+int main() {
+    test_spsc_single_thread();
+    test_leftovers_destroyed();
+    test_spsc_throwing_bulk();
+    test_spsc_threads();
+    test_mpmc_threads();
+    test_mpmc_throwing_constructor();
+    test_mpmc_throwing_move();
+    return check::result();
+}
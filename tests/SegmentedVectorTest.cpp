@@ -0,0 +1,208 @@
+//
+// Tests for SegmentedVector: growth at both ends without moving elements, segment reuse
+// by a queue, random access iterators (driven through std algorithms), invalidation
+// severities, and copies and moves, also between unequal allocators.
+//
+#include <algorithm>
+#include <iterator>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+
+#include "Check.h"
+#include "SegmentedVector.h"
+
+template <typename F>
+static int severity_of(F f) {
+    try {
+        f();
+    }
+    catch (const epl::invalid_iterator& e) {
+        return e.level;
+    }
+    return -1;
+}
+
+//
+// Element whose copy throws when the countdown reaches zero
+//
+struct bomb {
+    static int live;
+    static int countdown;
+
+    int value;
+
+    bomb(int v) : value(v) {
+        live++;
+    }
+
+    bomb(const bomb& other) : value(other.value) {
+        if (countdown > 0 && --countdown == 0) {
+            throw std::runtime_error("bomb");
+        }
+        live++;
+    }
+
+    ~bomb() {
+        live--;
+    }
+};
+
+int bomb::live = 0;
+int bomb::countdown = 0;
+
+static void test_both_ends(void) {
+    typedef epl::SegmentedVector<int, epl::checking::full, std::allocator<int>, 64> small_segments;
+    CHECK(small_segments::segment_size == 16);
+    small_segments v;
+    v.push_back(0);
+    int* first = &v[0];
+    for (int k = 1; k <= 1000; k++) {
+        v.push_back(k);
+        v.push_front(-k);
+    }
+    CHECK(v.size() == 2001);
+    CHECK(&v[1000] == first);
+    CHECK(v[0] == -1000 && v[2000] == 1000);
+    CHECK(v.capacity() >= v.size() && v.capacity() == v.segments() * 16);
+
+    for (int k = 0; k < 1000; k++) {
+        v.pop_front();
+    }
+    v.pop_back();
+    CHECK(v.size() == 1000 && v[0] == 0 && v[999] == 999);
+    CHECK(&v[0] == first);
+    CHECK_THROWS(v[1000], std::out_of_range);
+
+    //
+    // A queue runs in a fixed number of segments: emptied front segments are moved to
+    // the back
+    //
+    small_segments q;
+    for (int k = 0; k < 64; k++) {
+        q.push_back(k);
+    }
+    uint64_t segments = q.segments();
+    for (int k = 64; k < 10000; k++) {
+        q.push_back(k);
+        q.pop_front();
+    }
+    CHECK(q.segments() <= segments + 1);
+    CHECK(q.size() == 64 && q[0] == 10000 - 64);
+
+    small_segments empty;
+    CHECK_THROWS(empty.pop_back(), std::out_of_range);
+    CHECK_THROWS(empty.pop_front(), std::out_of_range);
+}
+
+static void test_iterators(void) {
+    epl::SegmentedVector<std::string, epl::checking::full, std::allocator<std::string>, 256> v;
+    for (int k = 0; k < 500; k++) {
+        v.push_back(std::to_string((k * 7919) % 500));
+    }
+    CHECK(std::distance(v.begin(), v.end()) == 500);
+    std::sort(v.begin(), v.end(), [](const std::string& a, const std::string& b) {
+        return std::stoi(a) < std::stoi(b);
+    });
+    CHECK(std::is_sorted(v.begin(), v.end(), [](const std::string& a, const std::string& b) {
+        return std::stoi(a) < std::stoi(b);
+    }));
+    CHECK(v[0] == "0" && v[499] == "499");
+    auto found = std::lower_bound(v.begin(), v.end(), 250, [](const std::string& a, int b) {
+        return std::stoi(a) < b;
+    });
+    CHECK(found - v.begin() == 250);
+
+    auto it = v.begin();
+    it += 10;
+    CHECK(*it == "10" && it->size() == 2 && it[5] == "15");
+    CHECK(*(it - 3) == "7" && *(3 + it) == "13");
+    auto old = it++;
+    CHECK(*old == "10" && *it == "11");
+    CHECK(*it-- == "11" && *it == "10");
+    it -= 10;
+    CHECK(it == v.begin());
+    CHECK(it < v.end() && v.end() > it && it <= it && it >= it && !(it < it));
+    std::reverse(v.begin(), v.end());
+    CHECK(v[0] == "499");
+
+    const auto& cv = v;
+    decltype(cv.begin()) cit = v.begin();
+    CHECK(cit == cv.begin() && *std::prev(cv.end()) == "0");
+}
+
+static void test_invalidation(void) {
+    epl::SegmentedVector<int> v{ 1, 2, 3 };
+    auto head = v.begin();
+    v.push_back(4);
+    CHECK(severity_of([&] { *head; }) == epl::invalid_iterator::MILD);
+    head = v.begin();
+    v.push_front(0);
+    CHECK(severity_of([&] { ++head; }) == epl::invalid_iterator::WARNING);
+    auto last = v.begin() + 4;
+    auto second = v.begin() + 1;
+    v.pop_back();
+    CHECK(severity_of([&] { *last; }) == epl::invalid_iterator::SEVERE);
+    CHECK(severity_of([&] { *second; }) == epl::invalid_iterator::MILD);
+
+    auto end = v.end();
+    CHECK_THROWS(*end, std::out_of_range);
+    CHECK_THROWS(end.operator->(), std::out_of_range);
+
+    epl::SegmentedVector<int> other{ 9 };
+    auto it = v.begin();
+    v = other;
+    CHECK(severity_of([&] { *it; }) == epl::invalid_iterator::MODERATE);
+    it = other.begin();
+    epl::SegmentedVector<int> taken(std::move(other));
+    CHECK(severity_of([&] { *it; }) == epl::invalid_iterator::MODERATE);
+    CHECK(taken.size() == 1 && taken[0] == 9 && other.size() == 0);
+}
+
+static void test_copies(void) {
+    {
+        epl::SegmentedVector<bomb> v;
+        for (int k = 0; k < 2000; k++) {
+            v.push_back(bomb(k));
+        }
+        epl::SegmentedVector<bomb> copy(v);
+        CHECK(copy.size() == 2000 && copy[1999].value == 1999);
+        CHECK(bomb::live == 4000);
+
+        bomb::countdown = 1500;
+        CHECK_THROWS(epl::SegmentedVector<bomb> broken(v), std::runtime_error);
+        CHECK(bomb::live == 4000);
+        bomb::countdown = 700;
+        CHECK_THROWS(copy = v, std::runtime_error);
+        CHECK(copy.size() == 0);
+        CHECK(bomb::live == 2000);
+        bomb::countdown = 0;
+        copy.push_back(bomb(5));
+        CHECK(copy.size() == 1);
+    }
+    CHECK(bomb::live == 0);
+
+    //
+    // Move assignment between unequal allocators moves the elements one by one
+    //
+    std::pmr::monotonic_buffer_resource r1, r2;
+    typedef epl::SegmentedVector<std::string, epl::checking::full, std::pmr::polymorphic_allocator<std::string>> pmr_vector;
+    pmr_vector a{ std::pmr::polymorphic_allocator<std::string>(&r1) };
+    pmr_vector b{ std::pmr::polymorphic_allocator<std::string>(&r2) };
+    for (int k = 0; k < 300; k++) {
+        a.push_back(std::string(40, (char)('a' + k % 26)));
+    }
+    b = std::move(a);
+    CHECK(b.size() == 300 && b[299] == std::string(40, 'a' + 299 % 26));
+    CHECK(b.get_allocator().resource() == &r2);
+    pmr_vector c(std::move(b));
+    CHECK(c.size() == 300 && c.get_allocator().resource() == &r2);
+}
+
+int main() {
+    test_both_ends();
+    test_iterators();
+    test_invalidation();
+    test_copies();
+    return check::result();
+}
@@ -0,0 +1,213 @@
+//
+// Tests for Vector serialization: raw and codec formats over streams and file
+// descriptors, frames spanning reads, several vectors in one stream, the errors for
+// foreign, mismatched and truncated input, and a decode error on a pipe left open.
+//
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "Check.h"
+#include "Serialize.h"
+
+struct string_codec {
+    void encode(const std::string& value, epl::byte_writer& out) {
+        out.write_value<uint32_t>((uint32_t)value.size());
+        out.write(value.data(), value.size());
+    }
+
+    std::string decode(epl::byte_reader& in) {
+        uint32_t n = in.read_value<uint32_t>();
+        if (n == 0xffffffff) {
+            throw std::invalid_argument("bad element");
+        }
+        std::string value(n, '\0');
+        in.read(&value[0], n);
+        return value;
+    }
+};
+
+static void test_raw_streams(void) {
+    epl::Vector<double> v;
+    for (int k = 0; k < 100000; k++) {
+        v.push_back(k * 0.25);
+    }
+    v.push_front(-1.0);
+    std::stringstream stream;
+    epl::serialize(v, stream);
+    epl::serialize(v, stream);
+
+    epl::Vector<double> w{ 42.0 };
+    epl::deserialize(w, stream);
+    CHECK(w.size() == 100002);
+    CHECK(w[0] == 42.0 && w[1] == -1.0 && w[100001] == 99999 * 0.25);
+    epl::Vector<double> second;
+    epl::deserialize(second, stream);
+    CHECK(second.size() == 100001);
+
+    epl::Vector<double> empty, back;
+    std::stringstream s2;
+    epl::serialize(empty, s2);
+    epl::deserialize(back, s2);
+    CHECK(back.size() == 0);
+}
+
+static void test_file_descriptors(void) {
+    std::string path = "/tmp/epl_serialize_" + std::to_string((long)::getpid());
+    epl::Vector<int> v;
+    for (int k = 0; k < 1000; k++) {
+        v.push_back(k);
+    }
+    epl::Vector<std::string> s;
+    for (int k = 0; k < 1000; k++) {
+        s.push_back(std::string(k % 50, 'a' + k % 26));
+    }
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    CHECK(fd >= 0);
+    epl::serialize(v, fd);
+    epl::serialize(s, fd, string_codec());
+    ::lseek(fd, 0, SEEK_SET);
+    epl::Vector<int> v2;
+    epl::Vector<std::string> s2;
+    epl::deserialize(v2, fd);
+    epl::deserialize(s2, fd, string_codec());
+    ::close(fd);
+    std::remove(path.c_str());
+    CHECK(v2.size() == 1000 && v2[999] == 999);
+    CHECK(s2.size() == 1000 && s2[51] == std::string(1, 'a' + 51 % 26));
+
+    //
+    // A pipe hands out short reads; the writer runs on its own thread
+    //
+    int fds[2];
+    CHECK(::pipe(fds) == 0);
+    std::thread writer([&s, &fds] {
+        epl::serialize(s, fds[1], string_codec());
+        ::close(fds[1]);
+    });
+    epl::Vector<std::string> s3;
+    epl::deserialize(s3, fds[0], string_codec());
+    writer.join();
+    ::close(fds[0]);
+    CHECK(s3.size() == 1000 && s3[999] == s[999]);
+}
+
+static void test_codec_frames(void) {
+    //
+    // Several megabytes of strings, so that elements straddle frame boundaries, then
+    // a raw vector after them in the same stream
+    //
+    epl::Vector<std::string> v;
+    for (int k = 0; k < 3000; k++) {
+        v.push_back(std::string(1000 + k % 777, (char)('a' + k % 26)));
+    }
+    epl::Vector<int> tail{ 7, 8, 9 };
+    std::stringstream stream;
+    epl::serialize(v, stream, string_codec());
+    epl::serialize(tail, stream);
+
+    epl::Vector<std::string> w;
+    epl::deserialize(w, stream, string_codec());
+    epl::Vector<int> tail2;
+    epl::deserialize(tail2, stream);
+    CHECK(w.size() == 3000);
+    bool same = true;
+    for (uint64_t k = 0; k < w.size(); k++) {
+        same = same && w[k] == v[k];
+    }
+    CHECK(same);
+    CHECK(tail2.size() == 3 && tail2[2] == 9);
+}
+
+static void test_errors(void) {
+    std::stringstream garbage(std::string(64, 'x'));
+    epl::Vector<int> v;
+    CHECK_THROWS(epl::deserialize(v, garbage), std::runtime_error);
+
+    epl::Vector<int> ints{ 1, 2, 3 };
+    std::stringstream raw;
+    epl::serialize(ints, raw);
+    std::string bytes = raw.str();
+
+    std::stringstream as_doubles(bytes);
+    epl::Vector<double> d;
+    CHECK_THROWS(epl::deserialize(d, as_doubles), std::runtime_error);
+
+    std::stringstream as_codec(bytes);
+    epl::Vector<std::string> s;
+    CHECK_THROWS(epl::deserialize(s, as_codec, string_codec()), std::runtime_error);
+
+    std::stringstream truncated(bytes.substr(0, bytes.size() - 2));
+    epl::Vector<int> partial{ 0 };
+    CHECK_THROWS(epl::deserialize(partial, truncated), std::runtime_error);
+    CHECK(partial.size() == 1 && partial[0] == 0);
+
+    epl::Vector<std::string> strings{ "one", "two", "three" };
+    std::stringstream coded;
+    epl::serialize(strings, coded, string_codec());
+    std::string coded_bytes = coded.str();
+    std::stringstream cut(coded_bytes.substr(0, coded_bytes.size() - 12));
+    epl::Vector<std::string> t;
+    CHECK_THROWS(epl::deserialize(t, cut, string_codec()), std::runtime_error);
+
+    std::stringstream as_raw(coded_bytes);
+    epl::Vector<int64_t> wrong;
+    CHECK_THROWS(epl::deserialize(wrong, as_raw), std::runtime_error);
+
+    //
+    // A codec that throws stops the read; the prefetching thread is shut down cleanly
+    //
+    epl::Vector<std::string> bad;
+    bad.push_back("fine");
+    std::stringstream poisoned;
+    {
+        struct poison_codec : string_codec {
+            void encode(const std::string& value, epl::byte_writer& out) {
+                if (value == "poison") {
+                    out.write_value<uint32_t>(0xffffffff);
+                    return;
+                }
+                string_codec::encode(value, out);
+            }
+        };
+        bad.push_back("poison");
+        epl::serialize(bad, poisoned, poison_codec());
+    }
+    epl::Vector<std::string> out;
+    CHECK_THROWS(epl::deserialize(out, poisoned, string_codec()), std::invalid_argument);
+    CHECK(out.size() == 1 && out[0] == "fine");
+
+    //
+    // The same from a pipe that is still open but will not deliver the end marker: the
+    // prefetching thread, by now waiting for the next frame, is called off all the same
+    //
+    struct slow_codec : string_codec {
+        std::string decode(epl::byte_reader& in) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            return string_codec::decode(in);
+        }
+    };
+    std::string poisoned_bytes = poisoned.str();
+    int fds[2];
+    CHECK(::pipe(fds) == 0);
+    CHECK(::write(fds[1], poisoned_bytes.data(), poisoned_bytes.size() - 8) == (ssize_t)poisoned_bytes.size() - 8);
+    epl::Vector<std::string> piped;
+    CHECK_THROWS(epl::deserialize(piped, fds[0], slow_codec()), std::invalid_argument);
+    CHECK(piped.size() == 1 && piped[0] == "fine");
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+int main() {
+    test_raw_streams();
+    test_file_descriptors();
+    test_codec_frames();
+    test_errors();
+    return check::result();
+}
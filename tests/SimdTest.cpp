@@ -0,0 +1,247 @@
+//
+// Tests for the epl::simd kernels and aligned_allocator: every kernel at every
+// instruction set level the CPU has, against a plain loop, over lengths that cover the
+// unrolled blocks, the single vectors and the scalar tail, from fronts that are not on
+// a vector boundary; int32_t arithmetic that wraps; and AlignedVector's buffer alignment.
+//
+#include <cstdint>
+#include <stdexcept>
+
+#include "AlignedAllocator.h"
+#include "Check.h"
+#include "Simd.h"
+
+//
+// Elements of the test vectors. Floating point values are small integers, so that sums
+// and products are exact in any order; int32_t values are spread over the whole range,
+// so that sums and products overflow.
+//
+template <typename T>
+static T value(int k) {
+    return (T)((k * 7) % 23 - 11);
+}
+
+template <>
+int32_t value<int32_t>(int k) {
+    return (int32_t)((uint32_t)(k + 1) * 2654435761u);
+}
+
+//
+// Reference results, with int32_t arithmetic done in uint32_t like the kernels promise
+//
+template <typename T>
+struct reference {
+    typedef typename epl::simd::detail::arithmetic_type<T>::type A;
+
+    template <typename V>
+    static T sum(const V& v) {
+        A s = 0;
+        for (uint64_t k = 0; k < v.size(); k++) {
+            s += (A)v[k];
+        }
+        return (T)s;
+    }
+
+    template <typename V>
+    static T dot(const V& x, const V& y) {
+        A s = 0;
+        for (uint64_t k = 0; k < x.size(); k++) {
+            s += (A)x[k] * (A)y[k];
+        }
+        return (T)s;
+    }
+
+    static T axpy(T a, T x, T y) {
+        return (T)((A)y + (A)a * (A)x);
+    }
+
+    static T add(T x, T y) {
+        return (T)((A)x + (A)y);
+    }
+
+    static T sub(T x, T y) {
+        return (T)((A)x - (A)y);
+    }
+
+    static T mul(T x, T y) {
+        return (T)((A)x * (A)y);
+    }
+};
+
+template <typename T>
+static epl::AlignedVector<T> shifted(uint64_t n, uint64_t shift, int seed) {
+    //
+    // n elements starting 'shift' cells past the start of a cache line aligned buffer
+    //
+    epl::AlignedVector<T> v;
+    for (uint64_t k = 0; k < shift + n; k++) {
+        v.push_back(value<T>((int)k + seed));
+    }
+    v.pop_front(shift);
+    return v;
+}
+
+template <typename T>
+static bool kernels_agree(uint64_t n, uint64_t shift) {
+    typedef reference<T> ref;
+    bool ok = true;
+    epl::AlignedVector<T> x = shifted<T>(n, shift, 0);
+    epl::AlignedVector<T> y = shifted<T>(n, (shift + 1) % 4, 5);
+
+    ok = ok && epl::simd::sum(x) == ref::sum(x);
+    ok = ok && epl::simd::dot(x, y) == ref::dot(x, y);
+
+    if (n > 0) {
+        T lo = x[0], hi = x[0];
+        for (uint64_t k = 1; k < n; k++) {
+            lo = x[k] < lo ? x[k] : lo;
+            hi = hi < x[k] ? x[k] : hi;
+        }
+        ok = ok && epl::simd::min(x) == lo && epl::simd::max(x) == hi;
+    }
+
+    //
+    // Every element is found at its first occurrence; a value not in the vector is not
+    //
+    for (uint64_t j = 0; j < n; j++) {
+        uint64_t first = 0;
+        while (x[first] != x[j]) {
+            first++;
+        }
+        ok = ok && epl::simd::find(x, x[j]) == first;
+    }
+    ok = ok && epl::simd::find(x, (T)100) == n;
+
+    epl::AlignedVector<T> out;
+    epl::simd::add(x, y, out);
+    for (uint64_t k = 0; k < n; k++) {
+        ok = ok && out[k] == ref::add(x[k], y[k]);
+    }
+    epl::simd::sub(x, y, out);
+    for (uint64_t k = 0; k < n; k++) {
+        ok = ok && out[k] == ref::sub(x[k], y[k]);
+    }
+    epl::simd::mul(x, y, out);
+    for (uint64_t k = 0; k < n; k++) {
+        ok = ok && out[k] == ref::mul(x[k], y[k]);
+    }
+    ok = ok && out.size() == n;
+
+    //
+    // In place: the output is one of the operands
+    //
+    epl::AlignedVector<T> z = y;
+    epl::simd::axpy((T)3, x, z);
+    for (uint64_t k = 0; k < n; k++) {
+        ok = ok && z[k] == ref::axpy((T)3, x[k], y[k]);
+    }
+    epl::simd::add(z, x, z);
+    for (uint64_t k = 0; k < n; k++) {
+        ok = ok && z[k] == ref::add(ref::axpy((T)3, x[k], y[k]), x[k]);
+    }
+    return ok;
+}
+
+template <typename T>
+static void test_kernels(void) {
+    //
+    // The widest vectors hold 64 bytes; lengths run past four of them, which covers
+    // the unrolled loops, the single vector loops and every tail length
+    //
+    const uint64_t longest = 4 * (64 / sizeof(T)) + 3;
+    for (int level = epl::simd::SCALAR; level <= epl::simd::AVX512; level++) {
+        epl::simd::limit_isa((epl::simd::isa_level)level);
+        CHECK(epl::simd::active_isa() <= (epl::simd::isa_level)level);
+        bool ok = true;
+        for (uint64_t n = 0; n <= longest; n++) {
+            for (uint64_t shift = 0; shift < 4; shift++) {
+                ok = ok && kernels_agree<T>(n, shift);
+            }
+        }
+        CHECK(ok);
+    }
+    epl::simd::limit_isa(epl::simd::AVX512);
+    CHECK(epl::simd::active_isa() == epl::simd::detected_isa());
+}
+
+static void test_wrapping(void) {
+    //
+    // Sums and products past INT32_MAX come back as the low 32 bits, at every level
+    //
+    for (int level = epl::simd::SCALAR; level <= epl::simd::AVX512; level++) {
+        epl::simd::limit_isa((epl::simd::isa_level)level);
+        epl::Vector<int32_t> big;
+        for (int k = 0; k < 100; k++) {
+            big.push_back(INT32_MAX);
+        }
+        CHECK(epl::simd::sum(big) == (int32_t)(100u * (uint32_t)INT32_MAX));
+        CHECK(epl::simd::dot(big, big) == 100);
+        epl::Vector<int32_t> out;
+        epl::simd::add(big, big, out);
+        CHECK(out[0] == -2 && out[99] == -2);
+    }
+    epl::simd::limit_isa(epl::simd::AVX512);
+}
+
+static void test_errors(void) {
+    epl::Vector<float> empty;
+    epl::Vector<float> three{ 1, 2, 3 };
+    CHECK(epl::simd::sum(empty) == 0 && epl::simd::find(empty, 1.0f) == 0);
+    CHECK_THROWS(epl::simd::min(empty), std::out_of_range);
+    CHECK_THROWS(epl::simd::max(empty), std::out_of_range);
+    CHECK_THROWS(epl::simd::dot(empty, three), std::invalid_argument);
+    CHECK_THROWS(epl::simd::add(empty, three, empty), std::invalid_argument);
+
+    //
+    // The span overloads run the same kernels
+    //
+    epl::Span<const float> s(&three[0], 3);
+    CHECK(epl::simd::sum(s) == 6 && epl::simd::max(s) == 3 && epl::simd::find(s, 2.0f) == 1);
+}
+
+template <typename T, size_t Alignment>
+static bool allocations_aligned(void) {
+    epl::aligned_allocator<T, Alignment> alloc;
+    bool ok = true;
+    for (size_t n : { 1, 3, 17, 1000 }) {
+        T* p = alloc.allocate(n);
+        ok = ok && reinterpret_cast<uintptr_t>(p) % Alignment == 0;
+        alloc.deallocate(p, n);
+    }
+    return ok;
+}
+
+struct alignas(128) wide {
+    char bytes[128];
+};
+
+static void test_aligned_allocator(void) {
+    CHECK((allocations_aligned<char, 64>()));
+    CHECK((allocations_aligned<double, 4096>()));
+    CHECK((epl::aligned_allocator<wide, 16>::alignment == 128));
+    CHECK((allocations_aligned<wide, 128>()));
+    CHECK((std::is_same<std::allocator_traits<epl::aligned_allocator<char, 256>>::rebind_alloc<int>,
+        epl::aligned_allocator<int, 256>>::value));
+    CHECK((epl::aligned_allocator<int>() == epl::aligned_allocator<double>()));
+
+    //
+    // Every buffer an AlignedVector grows into starts on a cache line
+    //
+    epl::AlignedVector<float> v;
+    bool aligned = true;
+    for (int k = 0; k < 5000; k++) {
+        v.push_back((float)k);
+        aligned = aligned && reinterpret_cast<uintptr_t>(&v[0]) % epl::cache_line_size == 0;
+    }
+    CHECK(aligned);
+}
+
+int main() {
+    test_kernels<float>();
+    test_kernels<double>();
+    test_kernels<int32_t>();
+    test_wrapping();
+    test_errors();
+    test_aligned_allocator();
+    return check::result();
+}
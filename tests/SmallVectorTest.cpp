@@ -0,0 +1,225 @@
+//
+// Tests for SmallVector: inline storage, spilling to the heap, copies and moves
+// between inline and heap states, and allocator handling on assignment.
+//
+#include <cstdlib>
+#include <memory_resource>
+#include <new>
+#include <set>
+#include <string>
+
+#include "Check.h"
+#include "SmallVector.h"
+
+static int heap_allocations = 0;
+
+void* operator new(size_t n) {
+    heap_allocations++;
+    if (void* p = std::malloc(n > 0 ? n : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+//
+// Resource that remembers the blocks it handed out, and flags any block that is given
+// back to it without having come from it
+//
+class tracking_resource : public std::pmr::memory_resource {
+public:
+    ~tracking_resource() {
+        CHECK(_live.empty());
+    }
+
+    size_t live(void) const {
+        return _live.size();
+    }
+
+private:
+    std::set<void*> _live;
+
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        void* p = std::pmr::new_delete_resource()->allocate(bytes, alignment);
+        _live.insert(p);
+        return p;
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        CHECK(_live.erase(p) == 1);
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+//
+// Allocator that propagates on copy and move assignment; instances with different ids
+// are unequal
+//
+template <typename T>
+struct tagged_allocator {
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_copy_assignment;
+    typedef std::true_type propagate_on_container_move_assignment;
+
+    int _id;
+
+    explicit tagged_allocator(int id) : _id(id) {}
+
+    template <typename U>
+    tagged_allocator(const tagged_allocator<U>& other) : _id(other._id) {}
+
+    T* allocate(size_t n) {
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T* p, size_t n) {
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template <typename U>
+    bool operator==(const tagged_allocator<U>& other) const {
+        return _id == other._id;
+    }
+
+    template <typename U>
+    bool operator!=(const tagged_allocator<U>& other) const {
+        return _id != other._id;
+    }
+};
+
+static void test_inline_storage(void) {
+    int before = heap_allocations;
+    {
+        epl::SmallVector<int, 8> v;
+        for (int k = 0; k < 8; k++) {
+            if (k % 2 == 0) {
+                v.push_back(k);
+            }
+            else {
+                v.push_front(k);
+            }
+        }
+        CHECK(v.is_small());
+        CHECK(v.size() == 8);
+        CHECK(v[0] == 7 && v[7] == 6);
+    }
+    CHECK(heap_allocations == before);
+
+    epl::SmallVector<std::string, 4> s;
+    for (int k = 0; k < 20; k++) {
+        s.push_back(std::to_string(k));
+    }
+    CHECK(!s.is_small());
+    CHECK(s.size() == 20);
+    CHECK(s[19] == "19");
+}
+
+static void test_copy_and_move(void) {
+    epl::SmallVector<std::string, 4> small{ "a", "b" };
+    epl::SmallVector<std::string, 4> large;
+    for (int k = 0; k < 10; k++) {
+        large.push_back(std::to_string(k));
+    }
+
+    epl::SmallVector<std::string, 4> c1(small);
+    epl::SmallVector<std::string, 4> c2(large);
+    CHECK(c1.is_small() && c1.size() == 2 && c1[1] == "b");
+    CHECK(c2.size() == 10 && c2[9] == "9");
+    c1 = large;
+    CHECK(c1.size() == 10 && c1[3] == "3");
+    c2 = small;
+    CHECK(c2.is_small() && c2.size() == 2 && c2[0] == "a");
+
+    //
+    // Moving a heap buffer keeps the rhs iterators valid; moving inline elements does not
+    //
+    auto it = large.begin();
+    epl::SmallVector<std::string, 4> m1(std::move(large));
+    CHECK(large.size() == 0 && large.is_small());
+    CHECK(m1.size() == 10 && *it == "0");
+
+    auto small_it = small.begin();
+    epl::SmallVector<std::string, 4> m2(std::move(small));
+    CHECK(m2.is_small() && m2.size() == 2 && m2[1] == "b");
+    CHECK_THROWS(*small_it, epl::invalid_iterator);
+
+    m2 = std::move(m1);
+    CHECK(m2.size() == 10 && m2[9] == "9");
+}
+
+static void test_unequal_allocators(void) {
+    typedef std::pmr::polymorphic_allocator<std::string> pmr_alloc;
+    tracking_resource r1, r2;
+    {
+        epl::SmallVector<std::string, 2, epl::default_checking, pmr_alloc> a{ pmr_alloc(&r1) };
+        epl::SmallVector<std::string, 2, epl::default_checking, pmr_alloc> b{ pmr_alloc(&r2) };
+        for (int k = 0; k < 10; k++) {
+            a.push_back(std::to_string(k));
+        }
+        b.push_back("x");
+        b = std::move(a);
+        //
+        // polymorphic_allocator does not propagate: b keeps r2 and must not hold r1's buffer
+        //
+        CHECK(b.get_allocator().resource() == &r2);
+        CHECK(b.size() == 10 && b[9] == "9");
+        for (int k = 0; k < 100; k++) {
+            b.push_back("grow");
+        }
+        CHECK(b[109] == "grow");
+
+        epl::SmallVector<std::string, 2, epl::default_checking, pmr_alloc> c{ pmr_alloc(&r2) };
+        epl::SmallVector<std::string, 2, epl::default_checking, pmr_alloc> d{ pmr_alloc(&r1) };
+        c.push_back("1");
+        c.push_back("2");
+        c.push_back("3");
+        d = std::move(c);
+        CHECK(d.get_allocator().resource() == &r1);
+        CHECK(d.size() == 3 && d[2] == "3");
+
+        epl::SmallVector<std::string, 2, epl::default_checking, pmr_alloc> e{ pmr_alloc(&r1) };
+        e.push_back("short");
+        epl::SmallVector<std::string, 2, epl::default_checking, pmr_alloc> f{ pmr_alloc(&r2) };
+        for (int k = 0; k < 5; k++) {
+            f.push_back("long");
+        }
+        f = std::move(e);
+        CHECK(f.is_small() && f.size() == 1 && f[0] == "short");
+    }
+    CHECK(r1.live() == 0 && r2.live() == 0);
+}
+
+static void test_propagating_allocators(void) {
+    typedef tagged_allocator<int> alloc;
+    epl::SmallVector<int, 2, epl::default_checking, alloc> a{ alloc(1) };
+    epl::SmallVector<int, 2, epl::default_checking, alloc> b{ alloc(2) };
+    epl::SmallVector<int, 2, epl::default_checking, alloc> c{ alloc(3) };
+    for (int k = 0; k < 10; k++) {
+        a.push_back(k);
+    }
+    b = a;
+    CHECK(b.get_allocator()._id == 1);
+    CHECK(b.size() == 10 && b[9] == 9);
+    c = std::move(a);
+    CHECK(c.get_allocator()._id == 1);
+    CHECK(c.size() == 10 && c[0] == 0);
+}
+
+int main() {
+    test_inline_storage();
+    test_copy_and_move();
+    test_unequal_allocators();
+    test_propagating_allocators();
+    return check::result();
+}
@@ -0,0 +1,123 @@
+//
+// Tests for SoAVector: rows at both ends, column spans, row iterators, range checks and
+// keeping the columns the same length when a field throws.
+//
+#include <iterator>
+#include <stdexcept>
+#include <string>
+
+#include "Check.h"
+#include "SoAVector.h"
+
+//
+// Field whose copy throws while 'armed' is set
+//
+struct brittle {
+    static bool armed;
+
+    int value;
+
+    brittle(int v = 0) : value(v) {}
+
+    brittle(const brittle& other) : value(other.value) {
+        if (armed) {
+            throw std::runtime_error("brittle");
+        }
+    }
+
+    brittle& operator=(const brittle&) = default;
+};
+
+bool brittle::armed = false;
+
+static void test_rows(void) {
+    epl::SoAVector<int, double, std::string> soa;
+    for (int k = 0; k < 100; k++) {
+        soa.push_back(k, k * 0.5, std::to_string(k));
+    }
+    soa.push_front(-1, -0.5, "-1");
+    CHECK(soa.size() == 101);
+    CHECK(std::get<0>(soa[0]) == -1 && std::get<2>(soa[0]) == "-1");
+    CHECK(soa.get<1>(100) == 49.5);
+
+    std::get<0>(soa[1]) = 1000;
+    CHECK(soa.get<0>(1) == 1000);
+
+    soa.pop_front();
+    soa.pop_back();
+    CHECK(soa.size() == 99);
+    CHECK(soa.get<2>(98) == "98");
+
+    CHECK_THROWS(soa[99], std::out_of_range);
+    const epl::SoAVector<int, double, std::string>& csoa = soa;
+    CHECK_THROWS(csoa[1000], std::out_of_range);
+
+    epl::Span<int> ints = soa.column<0>();
+    CHECK(ints.size() == 99);
+    long sum = 0;
+    for (uint64_t k = 0; k < ints.size(); k++) {
+        sum += ints[k];
+    }
+    CHECK(sum == 1000L + 98L * 99 / 2);
+    CHECK(soa.column_vector<2>().size() == 99);
+}
+
+static void test_iterators(void) {
+    epl::SoAVector<int, char> soa;
+    soa.reserve(26);
+    for (int k = 0; k < 26; k++) {
+        soa.push_back(k, (char)('a' + k));
+    }
+    int count = 0;
+    for (auto [number, letter] : soa) {
+        CHECK(letter == 'a' + number);
+        letter = (char)('A' + number);
+        count++;
+    }
+    CHECK(count == 26 && soa.get<1>(3) == 'D');
+
+    auto it = soa.begin();
+    CHECK(std::distance(soa.begin(), soa.end()) == 26);
+    it += 5;
+    CHECK(std::get<0>(*it) == 5);
+    CHECK(std::get<0>(it[2]) == 7);
+    CHECK(std::get<0>(*(it - 3)) == 2);
+    CHECK(std::get<0>(*(2 + it)) == 7);
+    auto old = it++;
+    CHECK(std::get<0>(*old) == 5 && std::get<0>(*it) == 6);
+    it -= 6;
+    CHECK(it == soa.begin());
+    CHECK(it < soa.end() && soa.end() > it && it <= it && it >= it);
+    CHECK(it-- == soa.begin());
+
+    const auto& csoa = soa;
+    epl::SoAVector<int, char>::const_iterator cit = soa.begin();
+    CHECK(cit == csoa.begin());
+    CHECK(std::get<1>(*std::prev(csoa.end())) == 'Z');
+}
+
+static void test_throwing_field(void) {
+    epl::SoAVector<int, brittle, std::string> soa;
+    soa.push_back(1, brittle(1), "one");
+    brittle b(2);
+    std::string s("two");
+    brittle::armed = true;
+    CHECK_THROWS(soa.push_back(2, b, s), std::runtime_error);
+    CHECK_THROWS(soa.push_front(0, b, s), std::runtime_error);
+    brittle::armed = false;
+    CHECK(soa.size() == 1);
+    CHECK(soa.column_vector<0>().size() == 1 && soa.column_vector<2>().size() == 1);
+    CHECK(soa.get<0>(0) == 1 && soa.get<2>(0) == "one");
+
+    soa.pop_back();
+    CHECK(soa.size() == 0);
+    CHECK_THROWS(soa.pop_back(), std::out_of_range);
+    CHECK(soa.column_vector<1>().size() == 0);
+}
+
+int main() {
+    test_rows();
+    test_iterators();
+    test_throwing_field();
+    return check::result();
+}
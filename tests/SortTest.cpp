@@ -0,0 +1,265 @@
+//
+// Tests for the Vector sorts: radix and merge sort results against std::sort, stability,
+// floating point key order, iterator invalidation, and that a comparison or key function
+// that throws leaves every element in the vector.
+//
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Check.h"
+#include "Sort.h"
+
+template <typename T>
+static std::vector<T> contents(const epl::Vector<T>& v) {
+    return std::vector<T>(v.begin(), v.end());
+}
+
+static void test_radix(void) {
+    std::mt19937_64 rng(1);
+    for (unsigned threads : { 0u, 2u }) {
+        epl::ThreadPool pool(threads);
+        for (uint64_t n : { 0u, 1u, 100u, 2047u, 2048u, 50000u }) {
+            epl::Vector<int64_t> v;
+            for (uint64_t k = 0; k < n; k++) {
+                v.push_back((int64_t)rng() >> (k % 3 == 0 ? 40 : 1));
+            }
+            std::vector<int64_t> expected = contents(v);
+            std::sort(expected.begin(), expected.end());
+            epl::sort(v, pool);
+            CHECK(contents(v) == expected);
+        }
+        epl::Vector<uint8_t> bytes;
+        for (int k = 0; k < 10000; k++) {
+            bytes.push_back((uint8_t)rng());
+        }
+        epl::stable_sort(bytes, pool);
+        CHECK(std::is_sorted(bytes.begin(), bytes.end()));
+    }
+}
+
+static void test_float_order(void) {
+    //
+    // Floats order by their bits: negative NaN, -inf, ..., -0.0, 0.0, ..., inf, NaN,
+    // both in the radix sort and in the comparison sort that small vectors get
+    //
+    double nan = std::numeric_limits<double>::quiet_NaN();
+    double inf = std::numeric_limits<double>::infinity();
+    for (int n : { 30, 3000 }) {
+        epl::Vector<double> d;
+        for (int k = 1; k <= n; k++) {
+            d.push_back(k % 2 ? k * 0.5 : -k * 0.25);
+        }
+        d.push_back(nan);
+        d.push_back(0.0);
+        d.push_back(-nan);
+        d.push_back(inf);
+        d.push_back(-inf);
+        d.push_back(-0.0);
+        epl::sort(d);
+        CHECK(std::isnan(d[0]) && std::signbit(d[0]));
+        CHECK(d[1] == -inf);
+        CHECK(std::isnan(d[d.size() - 1]) && !std::signbit(d[d.size() - 1]));
+        CHECK(d[d.size() - 2] == inf);
+        bool ordered = true;
+        for (uint64_t k = 1; k + 2 < d.size(); k++) {
+            ordered = ordered && d[k] <= d[k + 1];
+        }
+        CHECK(ordered);
+        uint64_t zero = 0;
+        while (!(d[zero] == 0.0)) {
+            zero++;
+        }
+        CHECK(std::signbit(d[zero]) && !std::signbit(d[zero + 1]));
+    }
+
+    //
+    // The same for a float key, with equal keys kept in their original order
+    //
+    epl::Vector<std::pair<float, int>> pairs;
+    float fnan = std::numeric_limits<float>::quiet_NaN();
+    float keys[] = { 2.0f, fnan, -0.0f, 0.0f, -fnan, -1.0f, 0.0f, -0.0f };
+    for (int k = 0; k < 8; k++) {
+        pairs.push_back(std::make_pair(keys[k], k));
+    }
+    epl::sort_by_key(pairs, [](const std::pair<float, int>& p) { return p.first; });
+    int order[] = { 4, 5, 2, 7, 3, 6, 0, 1 };
+    bool same = true;
+    for (int k = 0; k < 8; k++) {
+        same = same && pairs[k].second == order[k];
+    }
+    CHECK(same);
+}
+
+struct record {
+    std::string name;
+    uint32_t key;
+    uint32_t seq;
+};
+
+static void test_merge_and_keys(void) {
+    std::mt19937 rng(2);
+    for (unsigned threads : { 0u, 3u }) {
+        epl::ThreadPool pool(threads);
+        epl::Vector<std::string> v;
+        for (int k = 0; k < 30000; k++) {
+            v.push_back(std::to_string(rng() % 100000));
+        }
+        std::vector<std::string> expected = contents(v);
+        std::sort(expected.begin(), expected.end());
+        epl::sort(v, pool);
+        CHECK(contents(v) == expected);
+        epl::sort(v, std::greater<std::string>(), pool);
+        CHECK(std::is_sorted(v.begin(), v.end(), std::greater<std::string>()));
+
+        //
+        // Stability, through the merge sort (comparator) and the radix sort (integral key)
+        //
+        epl::Vector<record> r;
+        for (uint32_t k = 0; k < 20000; k++) {
+            r.push_back(record{ std::to_string(k), (uint32_t)(rng() % 50), k });
+        }
+        epl::Vector<record> by_key(r);
+        epl::stable_sort(r, [](const record& a, const record& b) { return a.key < b.key; }, pool);
+        epl::sort_by_key(by_key, [](const record& x) { return x.key; }, pool);
+        bool stable = true;
+        bool same = true;
+        for (uint64_t k = 1; k < r.size(); k++) {
+            stable = stable && (r[k - 1].key < r[k].key || (r[k - 1].key == r[k].key && r[k - 1].seq < r[k].seq));
+            same = same && r[k].seq == by_key[k].seq;
+        }
+        CHECK(stable && same);
+
+        epl::sort_by_key(by_key, [](const record& x) { return x.name; }, pool);
+        CHECK(std::is_sorted(by_key.begin(), by_key.end(),
+            [](const record& a, const record& b) { return a.name < b.name; }));
+    }
+
+    epl::Vector<std::string> small{ "c", "a", "b" };
+    auto it = small.begin();
+    epl::sort(small);
+    CHECK(small[0] == "a" && small[2] == "c");
+    CHECK_THROWS(*it, epl::invalid_iterator);
+}
+
+//
+// Element that knows which chunk of the initial order it started in. The chunk sorts
+// only compare elements of one chunk, so a comparison across chunks is part of a merge.
+//
+struct tagged {
+    std::string value;
+    uint64_t chunk;
+};
+
+struct trivially_tagged {
+    int64_t value;
+    uint64_t chunk;
+};
+
+template <typename T>
+struct merge_bomb {
+    //
+    // Throws on the 'fuse'-th comparison across chunks
+    //
+    std::atomic<uint64_t>* count;
+    uint64_t fuse;
+
+    bool operator()(const T& a, const T& b) const {
+        if (a.chunk != b.chunk && ++*count == fuse) {
+            throw std::runtime_error("comparison");
+        }
+        return a.value < b.value;
+    }
+};
+
+template <typename T, typename Make>
+static void check_merge_throws(Make make) {
+    const uint64_t n = 5 * epl::parallel::min_grain + 123;
+    std::mt19937 rng(3);
+    std::vector<uint64_t> order(n);
+    for (uint64_t k = 0; k < n; k++) {
+        order[k] = k;
+    }
+    std::shuffle(order.begin(), order.end(), rng);
+    for (unsigned threads : { 0u, 2u }) {
+        epl::ThreadPool pool(threads);
+        uint64_t grain = epl::parallel::detail::grain_for(n, pool);
+        for (uint64_t fuse : { 1u, 10u, 5000u, 20000u, 40000u }) {
+            epl::Vector<T> v;
+            for (uint64_t k = 0; k < n; k++) {
+                v.push_back(T{ make(order[k]), k / grain });
+            }
+            std::atomic<uint64_t> count(0);
+            bool threw = false;
+            try {
+                epl::sort(v, merge_bomb<T>{ &count, fuse }, pool);
+            }
+            catch (const std::runtime_error&) {
+                threw = true;
+            }
+            CHECK(threw || count < fuse);
+            std::vector<decltype(make(0))> values;
+            for (uint64_t k = 0; k < v.size(); k++) {
+                values.push_back(v[k].value);
+            }
+            std::sort(values.begin(), values.end());
+            bool all = values.size() == n;
+            for (uint64_t k = 0; all && k < n; k++) {
+                all = values[k] == make(k);
+            }
+            CHECK(all);
+        }
+    }
+}
+
+static void test_throwing_comparison(void) {
+    check_merge_throws<tagged>([](uint64_t k) {
+        std::string s = std::to_string(k);
+        return std::string(8 - s.size(), '0') + s;
+    });
+    check_merge_throws<trivially_tagged>([](uint64_t k) { return (int64_t)k; });
+}
+
+static void test_throwing_key(void) {
+    //
+    // Two bytes of key take two passes; the fuse goes off in the second scatter, which
+    // reads from the scratch buffer
+    //
+    const uint64_t n = 10000;
+    epl::Vector<uint32_t> v;
+    for (uint32_t k = 0; k < n; k++) {
+        v.push_back((k * 7919) % n);
+    }
+    uint64_t calls = 0;
+    uint64_t fuse = 3 * n + n / 2;
+    epl::ThreadPool pool(0);
+    CHECK_THROWS(epl::sort_by_key(v, [&calls, fuse](uint32_t x) {
+        if (++calls == fuse) {
+            throw std::runtime_error("key");
+        }
+        return x;
+    }, pool), std::runtime_error);
+    std::vector<uint32_t> values = contents(v);
+    std::sort(values.begin(), values.end());
+    bool all = values.size() == n;
+    for (uint32_t k = 0; all && k < n; k++) {
+        all = values[k] == k;
+    }
+    CHECK(all);
+}
+
+int main() {
+    test_radix();
+    test_float_order();
+    test_merge_and_keys();
+    test_throwing_comparison();
+    test_throwing_key();
+    return check::result();
+}
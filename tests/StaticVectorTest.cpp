@@ -0,0 +1,190 @@
+//
+// Tests for StaticVector: pushes and pops at both ends, the slide when one end runs out,
+// the constexpr table of literal cells, and that an element whose copy throws is neither
+// leaked nor destroyed twice, whether it throws in a copy of the container or in a slide.
+//
+#include <stdexcept>
+#include <string>
+
+#include "Check.h"
+#include "StaticVector.h"
+
+//
+// Element that counts its live instances. Its move may throw, so a slide copies it, and
+// the copy throws once 'fuse' more copies have been made.
+//
+struct counted {
+    static int live;
+    static int fuse;
+
+    std::string value;
+
+    counted(int v) : value(std::to_string(v)) {
+        live++;
+    }
+
+    counted(const counted& other) : value(other.value) {
+        if (fuse > 0 && --fuse == 0) {
+            throw std::runtime_error("copy");
+        }
+        live++;
+    }
+
+    counted(counted&& other) : value(std::move(other.value)) {
+        live++;
+    }
+
+    counted& operator=(const counted&) = default;
+    counted& operator=(counted&&) = default;
+
+    ~counted() {
+        live--;
+    }
+};
+
+int counted::live = 0;
+int counted::fuse = 0;
+
+template <typename V>
+static bool consecutive(const V& v, int first) {
+    bool ok = true;
+    for (uint64_t k = 0; k < v.size(); k++) {
+        ok = ok && std::stoi(v[k].value) == first + (int)k;
+    }
+    return ok;
+}
+
+static void test_both_ends(void) {
+    {
+        epl::StaticVector<counted, 8> v;
+        for (int k = 0; k < 6; k++) {
+            v.push_back(counted(k));
+        }
+        //
+        // The front has no free cells: the elements slide back to make room
+        //
+        v.push_front(counted(-1));
+        v.push_front(counted(-2));
+        CHECK(v.size() == 8 && consecutive(v, -2));
+        CHECK_THROWS(v.push_back(counted(6)), std::length_error);
+        CHECK_THROWS(v.push_front(counted(-3)), std::length_error);
+        CHECK(v.size() == 8 && counted::live == 8);
+
+        v.pop_front(3);
+        v.pop_back();
+        CHECK(v.size() == 4 && consecutive(v, 1));
+        v.push_back(counted(5));
+        v.push_back(counted(6));
+        v.push_back(counted(7));
+        v.push_back(counted(8));
+        CHECK(v.size() == 8 && consecutive(v, 1));
+        CHECK_THROWS(v[8], std::out_of_range);
+
+        //
+        // An argument that refers to an element the slide moves
+        //
+        v.pop_front(2);
+        v.pop_back(2);
+        v.push_front(v[0]);
+        CHECK(v[0].value == "3" && v[1].value == "3");
+
+        epl::StaticVector<counted, 8> copy(v);
+        epl::StaticVector<counted, 8> moved(std::move(copy));
+        CHECK(moved.size() == 5 && moved[4].value == "6");
+        v.clear();
+        CHECK(v.empty());
+        CHECK_THROWS(v.pop_back(), std::out_of_range);
+        CHECK_THROWS(v.pop_front(1), std::out_of_range);
+        v = moved;
+        CHECK(v.size() == 5 && counted::live == 15);
+    }
+    CHECK(counted::live == 0);
+}
+
+static void test_literal(void) {
+    constexpr auto table = [] {
+        epl::StaticVector<int, 16> t;
+        for (int k = 0; k < 12; k++) {
+            t.push_back(k * k);
+        }
+        for (int k = 1; k <= 4; k++) {
+            t.push_front(-k);
+        }
+        return t;
+    }();
+    static_assert(table.size() == 16 && table[0] == -4 && table[15] == 121, "constexpr table");
+    CHECK(table[4] == 0 && table[6] == 4);
+
+    epl::StaticVector<int, 4> v{ 1, 2, 3 };
+    v.push_front(0);
+    CHECK(v.size() == 4 && v[0] == 0 && v[3] == 3);
+    CHECK_THROWS(v.push_front(9), std::length_error);
+    CHECK_THROWS((epl::StaticVector<int, 2>{ 1, 2, 3 }), std::length_error);
+}
+
+static void test_throwing_copies(void) {
+    typedef epl::StaticVector<counted, 8> vector;
+    vector v;
+    for (int k = 0; k < 6; k++) {
+        v.push_back(counted(k));
+    }
+
+    //
+    // A copy of the container that throws half way through destroys what it had copied
+    //
+    for (int n : { 1, 4, 6 }) {
+        counted::fuse = n;
+        CHECK_THROWS(vector copy(v), std::runtime_error);
+        CHECK(counted::live == 6);
+    }
+    vector target;
+    target.push_back(counted(100));
+    counted::fuse = 3;
+    CHECK_THROWS(target = v, std::runtime_error);
+    CHECK(target.size() == 2 && consecutive(target, 0) && counted::live == 8);
+    counted::fuse = 0;
+    target = v;
+    CHECK(target.size() == 6 && consecutive(target, 0));
+}
+
+static void test_throwing_slide(void) {
+    //
+    // The slide copies the elements from the back; the first copy is of the pushed
+    // value itself. With 'fuse' n the copy of element 7 - n throws, after those behind
+    // it went over, and the container keeps the ones still in place.
+    //
+    for (int n : { 2, 3, 5, 7 }) {
+        {
+            epl::StaticVector<counted, 8> v;
+            for (int k = 0; k < 6; k++) {
+                v.push_back(counted(k));
+            }
+            counted x(-1);
+            counted::fuse = n;
+            CHECK_THROWS(v.push_front(x), std::runtime_error);
+            CHECK(v.size() == (uint64_t)(8 - n) && consecutive(v, 0));
+            CHECK(counted::live == (int)v.size() + 1);
+
+            counted::fuse = 0;
+            v.push_front(x);
+            v.push_back(counted(100));
+            CHECK(v.size() == (uint64_t)(10 - n) && v[0].value == "-1");
+        }
+        CHECK(counted::live == 0);
+    }
+
+    //
+    // Elements that move without throwing are never copied
+    //
+    epl::StaticVector<std::string, 4> s{ "a", "b", "c" };
+    s.push_front("z");
+    CHECK(s[0] == "z" && s[3] == "c");
+}
+
+int main() {
+    test_both_ends();
+    test_literal();
+    test_throwing_copies();
+    test_throwing_slide();
+    return check::result();
+}
@@ -0,0 +1,229 @@
+//
+// Tests for the performance counters compiled in with _EPL_STATS_ (the Makefile builds
+// this test with it): what one vector counts for reallocations, recenterings, moved
+// elements and control blocks, the process wide totals including released buffers and
+// thrown invalidations, and that write_json() produces the JSON object it should.
+//
+#ifndef _EPL_STATS_
+#error "VectorStatsTest needs -D_EPL_STATS_"
+#endif
+
+#include <cctype>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Check.h"
+#include "Vector.h"
+
+typedef std::vector<std::pair<std::string, uint64_t>> json_fields;
+
+static bool parse_json(const std::string& text, json_fields& fields) {
+    //
+    // Parses a flat JSON object whose values are all unsigned integers, the only kind
+    // write_json() writes. Returns false for anything else, trailing text included.
+    //
+    size_t pos = 0;
+    auto skip_space = [&] {
+        while (pos < text.size() && std::isspace((unsigned char)text[pos])) {
+            pos++;
+        }
+    };
+    auto expect = [&](char c) {
+        skip_space();
+        if (pos < text.size() && text[pos] == c) {
+            pos++;
+            return true;
+        }
+        return false;
+    };
+    fields.clear();
+    if (!expect('{')) {
+        return false;
+    }
+    if (expect('}')) {
+        skip_space();
+        return pos == text.size();
+    }
+    do {
+        if (!expect('"')) {
+            return false;
+        }
+        size_t end = text.find('"', pos);
+        if (end == std::string::npos || end == pos) {
+            return false;
+        }
+        std::string key = text.substr(pos, end - pos);
+        pos = end + 1;
+        if (!expect(':')) {
+            return false;
+        }
+        skip_space();
+        if (pos == text.size() || !std::isdigit((unsigned char)text[pos])) {
+            return false;
+        }
+        uint64_t value = 0;
+        while (pos < text.size() && std::isdigit((unsigned char)text[pos])) {
+            value = value * 10 + (uint64_t)(text[pos] - '0');
+            pos++;
+        }
+        fields.emplace_back(key, value);
+    } while (expect(','));
+    if (!expect('}')) {
+        return false;
+    }
+    skip_space();
+    return pos == text.size();
+}
+
+template <typename Stats>
+static json_fields as_json(const Stats& s) {
+    std::ostringstream os;
+    epl::write_json(os, s);
+    json_fields fields;
+    CHECK(parse_json(os.str(), fields));
+    return fields;
+}
+
+static void test_vector_counts(void) {
+    epl::reset_global_stats();
+    {
+        //
+        // Doubling from the initial 8 cells: every reallocation moves all the elements
+        //
+        epl::Vector<int> v;
+        uint64_t reallocations = 0, moved = 0, capacity = v.capacity();
+        for (int k = 0; k < 100; k++) {
+            uint64_t length = v.size();
+            v.push_back(k);
+            if (v.capacity() != capacity) {
+                reallocations++;
+                moved += length;
+                capacity = v.capacity();
+            }
+        }
+        epl::vector_stats s = v.stats();
+        CHECK(reallocations == 4 && s.reallocations == reallocations);
+        CHECK(s.elements_moved == moved && s.bytes_moved == moved * sizeof(int));
+        CHECK(s.recenterings == 0 && s.peak_capacity == 128);
+        CHECK(s.capacity == 128 && s.length == 100 && s.front_slack == 0 && s.back_slack == 28);
+        CHECK(s.ctrlblk_allocations == 0);
+
+        //
+        // The first iterator allocates a control block; a reallocation while it is
+        // alive replaces it
+        //
+        auto it = v.begin();
+        CHECK(v.stats().ctrlblk_allocations == 1);
+        for (int k = 0; k < 30; k++) {
+            v.push_back(k);
+        }
+        s = v.stats();
+        CHECK(s.reallocations == 5 && s.elements_moved == moved + 128);
+        CHECK(s.ctrlblk_allocations == 2 && s.peak_capacity == 256);
+        CHECK_THROWS(*it, epl::invalid_iterator);
+
+        //
+        // With room at the front the elements are recentered rather than reallocated
+        //
+        epl::Vector<int> r;
+        r.reserve(100);
+        for (int k = 0; k < 100; k++) {
+            r.push_back(k);
+        }
+        r.pop_front(90);
+        for (int k = 0; k < 20; k++) {
+            r.push_back(k);
+        }
+        s = r.stats();
+        CHECK(s.reallocations == 1 && s.recenterings == 1 && s.elements_moved == 10);
+        CHECK(s.capacity == 100 && s.length == 30 && s.front_slack + s.back_slack == 70);
+
+        //
+        // A copy counts from zero
+        //
+        epl::Vector<int> copy(v);
+        CHECK(copy.stats().reallocations == 0 && copy.stats().peak_capacity == 256);
+    }
+
+    //
+    // The totals add up what the vectors counted, plus the buffers given back: three
+    // destroyed vectors and six replaced buffers
+    //
+    epl::global_vector_stats g = epl::global_stats();
+    CHECK(g.reallocations == 6 && g.recenterings == 1);
+    CHECK(g.elements_moved == 120 + 128 + 10 && g.bytes_moved == g.elements_moved * sizeof(int));
+    CHECK(g.peak_capacity == 256 && g.ctrlblk_allocations == 2);
+    CHECK(g.invalidations_thrown == 1 && g.buffers_released == 9);
+
+    epl::reset_global_stats();
+    g = epl::global_stats();
+    CHECK(g.reallocations == 0 && g.buffers_released == 0 && g.invalidations_thrown == 0);
+}
+
+static void test_released_slack(void) {
+    epl::reset_global_stats();
+    {
+        epl::Vector<int> v;
+        v.reserve(64);
+        for (int k = 0; k < 40; k++) {
+            v.push_back(k);
+        }
+        v.pop_front(10);
+    }
+    //
+    // The initial buffer had no elements; the reserved one had 10 free cells at the
+    // front and 24 at the back when it went
+    //
+    epl::global_vector_stats g = epl::global_stats();
+    CHECK(g.buffers_released == 2);
+    CHECK(g.released_front_slack == 10 && g.released_back_slack == 8 + 24);
+}
+
+static void test_json(void) {
+    epl::reset_global_stats();
+    epl::Vector<double> v;
+    for (int k = 0; k < 20; k++) {
+        v.push_front(k);
+    }
+    epl::vector_stats s = v.stats();
+    json_fields fields = as_json(s);
+    const char* keys[] = { "reallocations", "recenterings", "elements_moved", "bytes_moved", "peak_capacity",
+        "ctrlblk_allocations", "capacity", "length", "front_slack", "back_slack" };
+    uint64_t values[] = { s.reallocations, s.recenterings, s.elements_moved, s.bytes_moved, s.peak_capacity,
+        s.ctrlblk_allocations, s.capacity, s.length, s.front_slack, s.back_slack };
+    CHECK(fields.size() == 10);
+    for (size_t k = 0; k < fields.size() && k < 10; k++) {
+        CHECK(fields[k].first == keys[k] && fields[k].second == values[k]);
+    }
+    CHECK(s.length == 20 && s.reallocations > 0);
+
+    epl::global_vector_stats g = epl::global_stats();
+    fields = as_json(g);
+    const char* global_keys[] = { "reallocations", "recenterings", "elements_moved", "bytes_moved", "peak_capacity",
+        "ctrlblk_allocations", "invalidations_thrown", "buffers_released", "released_front_slack", "released_back_slack" };
+    uint64_t global_values[] = { g.reallocations, g.recenterings, g.elements_moved, g.bytes_moved, g.peak_capacity,
+        g.ctrlblk_allocations, g.invalidations_thrown, g.buffers_released, g.released_front_slack, g.released_back_slack };
+    CHECK(fields.size() == 10);
+    for (size_t k = 0; k < fields.size() && k < 10; k++) {
+        CHECK(fields[k].first == global_keys[k] && fields[k].second == global_values[k]);
+    }
+
+    //
+    // The parser itself rejects what is not such an object
+    //
+    json_fields bad;
+    CHECK(parse_json("{}", bad) && bad.empty());
+    CHECK(!parse_json("{\"a\": 1,}", bad));
+    CHECK(!parse_json("{\"a\" 1}", bad));
+    CHECK(!parse_json("{\"a\": -1}", bad));
+    CHECK(!parse_json("{\"a\": 1} x", bad));
+}
+
+int main() {
+    test_vector_counts();
+    test_released_slack();
+    test_json();
+    return check::result();
+}
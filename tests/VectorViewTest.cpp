@@ -0,0 +1,151 @@
+//
+// Tests for VectorView: slices and subviews, writes through a view, const views, range
+// checks, and the invalidation check made by every access once the vector has changed.
+//
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Check.h"
+#include "VectorView.h"
+
+template <typename F>
+static int severity_of(F f) {
+    try {
+        f();
+    }
+    catch (const epl::invalid_iterator& e) {
+        return e.level;
+    }
+    return -1;
+}
+
+static void test_slices(void) {
+    epl::Vector<int> v;
+    for (int k = 0; k < 100; k++) {
+        v.push_back(k);
+    }
+    epl::VectorView all(v);
+    CHECK(all.size() == 100 && !all.empty());
+    CHECK(all.data() == &v[0] && all[99] == 99);
+    CHECK(std::accumulate(all.begin(), all.end(), 0) == 4950);
+
+    epl::VectorView slice(v, 10, 20);
+    CHECK(slice.size() == 20 && slice[0] == 10 && slice[19] == 29);
+    slice[0] = -10;
+    CHECK(v[10] == -10);
+    for (int& x : slice) {
+        x *= 2;
+    }
+    CHECK(v[11] == 22 && v[29] == 58 && v[30] == 30);
+    epl::Span<int> span = slice.span();
+    CHECK(span.size() == 20 && &span[0] == &v[10]);
+
+    auto sub = slice.subview(5, 10);
+    CHECK(sub.size() == 10 && sub[0] == 30 && sub.data() == &v[15]);
+    auto empty = slice.subview(20, 0);
+    CHECK(empty.empty() && empty.begin() == empty.end());
+
+    CHECK_THROWS(slice[20], std::out_of_range);
+    CHECK_THROWS(slice.subview(15, 6), std::out_of_range);
+    CHECK_THROWS(slice.subview(21, 0), std::out_of_range);
+    CHECK_THROWS(epl::VectorView<int> bad(v, 90, 11), std::out_of_range);
+    CHECK_THROWS(epl::VectorView<int> bad(v, 101, 0), std::out_of_range);
+    epl::VectorView<int> at_end(v, 100, 0);
+    CHECK(at_end.empty());
+
+    const epl::Vector<int>& cv = v;
+    epl::VectorView readonly(cv, 0, 3);
+    static_assert(std::is_same<decltype(readonly), epl::VectorView<const int>>::value, "const view");
+    epl::VectorView<const int> converted = slice;
+    CHECK(readonly[2] == 2 && converted[1] == 22);
+
+    epl::VectorView<int> none;
+    CHECK(none.empty() && none.data() == nullptr);
+    CHECK_THROWS(none[0], std::out_of_range);
+}
+
+static void test_invalidation(void) {
+    epl::Vector<std::string> v;
+    v.reserve(100);
+    for (int k = 0; k < 10; k++) {
+        v.push_back(std::to_string(k));
+    }
+    epl::VectorView head(v, 0, 5);
+    epl::VectorView tail(v, 8, 2);
+    auto sub = head.subview(1, 2);
+    v.push_back("10");
+    CHECK(severity_of([&] { head.data(); }) == epl::invalid_iterator::MILD);
+    CHECK(severity_of([&] { head[0]; }) == epl::invalid_iterator::MILD);
+    CHECK(severity_of([&] { sub.begin(); }) == epl::invalid_iterator::MILD);
+    CHECK(severity_of([&] { head.span(); }) == epl::invalid_iterator::MILD);
+    CHECK(severity_of([&] { head.subview(0, 1); }) == epl::invalid_iterator::MILD);
+    CHECK(head.size() == 5);
+
+    epl::VectorView second(v, 1, 3);
+    epl::VectorView last(v, 10, 1);
+    v.pop_back();
+    CHECK(severity_of([&] { last.end(); }) == epl::invalid_iterator::SEVERE);
+    CHECK(severity_of([&] { second.end(); }) == epl::invalid_iterator::MILD);
+
+    epl::VectorView front(v, 0, 2);
+    v.pop_front();
+    CHECK(severity_of([&] { front.data(); }) == epl::invalid_iterator::SEVERE);
+
+    epl::VectorView<std::string> orphan;
+    {
+        epl::Vector<std::string> local{ "a", "b" };
+        orphan = epl::VectorView<std::string>(local);
+        CHECK(orphan[1] == "b");
+    }
+    CHECK(severity_of([&] { orphan.data(); }) == epl::invalid_iterator::SEVERE);
+
+    //
+    // Without version tracking a view is only a pointer and a length
+    //
+    epl::Vector<int, epl::checking::none> raw{ 1, 2, 3 };
+    epl::VectorView unchecked(raw, 1, 2);
+    CHECK(unchecked[1] == 3);
+    raw.push_back(4);
+    CHECK(unchecked.size() == 2 && unchecked.data() != nullptr);
+}
+
+static void test_threads(void) {
+    //
+    // Views of one vector copied and dropped on several threads at once
+    //
+    typedef epl::Vector<int, epl::checking::concurrent> vector;
+    vector v;
+    for (int k = 0; k < 1000; k++) {
+        v.push_back(k);
+    }
+    const vector& cv = v;
+    epl::VectorView<const int, epl::checking::concurrent> whole(cv);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([whole, t]() {
+            long sum = 0;
+            for (int round = 0; round < 100; round++) {
+                auto part = whole.subview((uint64_t)t * 250, 250);
+                for (int x : part) {
+                    sum += x;
+                }
+            }
+            CHECK(sum == 100L * (250L * t * 250 + 250L * 249 / 2));
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    v.push_back(0);
+    CHECK_THROWS(whole.data(), epl::invalid_iterator);
+}
+
+int main() {
+    test_slices();
+    test_invalidation();
+    test_threads();
+    return check::result();
+}
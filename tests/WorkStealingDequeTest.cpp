@@ -0,0 +1,270 @@
+//
+// Tests for WorkStealingDeque and the ThreadPool built on it: owner and thief order,
+// growth, an allocation that fails while growing, exactly-once delivery between the
+// owner and several thieves, nested fork/join work with exceptions on the pool, and
+// submitted tasks that throw.
+//
+#include <atomic>
+#include <memory_resource>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "Check.h"
+#include "ThreadPool.h"
+#include "WorkStealingDeque.h"
+
+//
+// Counts the blocks it hands out, and fails once 'limit' of them are live
+//
+class limited_resource : public std::pmr::memory_resource {
+public:
+    int live = 0;
+    int limit = -1;
+
+private:
+    void* do_allocate(size_t bytes, size_t alignment) override {
+        if (live == limit) {
+            throw std::bad_alloc();
+        }
+        live++;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {
+        live--;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+static void test_single_thread(void) {
+    epl::WorkStealingDeque<int> d(5);
+    CHECK(d.capacity() == 8 && d.empty());
+    int x = -1;
+    CHECK(!d.pop(x) && !d.steal(x) && x == -1);
+
+    //
+    // The owner takes the newest element, a thief the oldest; 100 pushes grow the ring
+    //
+    for (int k = 0; k < 100; k++) {
+        d.push(k);
+    }
+    CHECK(d.size() == 100 && d.capacity() == 128);
+    CHECK(d.pop(x) && x == 99);
+    CHECK(d.steal(x) && x == 0);
+    CHECK(d.steal(x) && x == 1);
+    bool ordered = true;
+    for (int k = 98; k >= 2; k--) {
+        ordered = d.pop(x) && x == k && ordered;
+    }
+    CHECK(ordered && d.empty());
+    CHECK(!d.pop(x) && !d.steal(x));
+
+    //
+    // The counters keep going up; the ring wraps around under them
+    //
+    for (int round = 0; round < 50; round++) {
+        for (int k = 0; k < 100; k++) {
+            d.push(k);
+        }
+        for (int k = 0; k < 60; k++) {
+            d.steal(x);
+        }
+        while (d.pop(x)) {
+        }
+    }
+    CHECK(d.empty() && d.capacity() == 128);
+    d.push(7);
+    CHECK(d.steal(x) && x == 7);
+}
+
+static void test_allocator(void) {
+    limited_resource resource;
+    {
+        typedef epl::WorkStealingDeque<int, std::pmr::polymorphic_allocator<int>> pmr_deque;
+        pmr_deque d(4, std::pmr::polymorphic_allocator<int>(&resource));
+        CHECK(resource.live == 2);
+        for (int k = 0; k < 4; k++) {
+            d.push(k);
+        }
+
+        //
+        // Growing needs a ring and its cells; if either allocation fails the push throws
+        // and the deque is as it was
+        //
+        for (int limit : { 2, 3 }) {
+            resource.limit = limit;
+            CHECK_THROWS(d.push(4), std::bad_alloc);
+            CHECK(resource.live == 2 && d.size() == 4 && d.capacity() == 4);
+        }
+        resource.limit = -1;
+        d.push(4);
+        CHECK(d.capacity() == 8 && resource.live == 4);
+        int x = -1;
+        CHECK(d.steal(x) && x == 0 && d.pop(x) && x == 4);
+
+        //
+        // The retired ring stays until the deque goes
+        //
+        for (int k = 0; k < 20; k++) {
+            d.push(k);
+        }
+        CHECK(d.capacity() == 32 && resource.live == 8);
+    }
+    CHECK(resource.live == 0);
+}
+
+static void test_thieves(void) {
+    //
+    // The owner pushes every value once, popping some of them back, while three thieves
+    // steal; a small initial ring makes the owner grow it under the thieves
+    //
+    const int n = 200000;
+    std::vector<std::atomic<int>> seen(n);
+    for (auto& s : seen) {
+        s = 0;
+    }
+    epl::WorkStealingDeque<int> d(2);
+    std::atomic<bool> done(false);
+    std::atomic<int> stolen(0);
+    std::vector<std::thread> thieves;
+    for (int t = 0; t < 3; t++) {
+        thieves.emplace_back([&] {
+            int x;
+            for (;;) {
+                bool last = done.load(std::memory_order_acquire);
+                if (d.steal(x)) {
+                    seen[x]++;
+                    stolen++;
+                }
+                else if (last && d.empty()) {
+                    return;
+                }
+            }
+        });
+    }
+    int popped = 0;
+    for (int k = 0; k < n; k++) {
+        d.push(k);
+        int x;
+        if (k % 3 == 0 && d.pop(x)) {
+            seen[x]++;
+            popped++;
+        }
+    }
+    done.store(true, std::memory_order_release);
+    int x;
+    while (d.pop(x)) {
+        seen[x]++;
+        popped++;
+    }
+    for (auto& thief : thieves) {
+        thief.join();
+    }
+    bool once = true;
+    for (auto& s : seen) {
+        once = once && s == 1;
+    }
+    CHECK(once && popped + stolen == n && d.empty());
+}
+
+static uint64_t fork_join(epl::ThreadPool& pool, int depth, std::atomic<uint64_t>& leaves) {
+    //
+    // A binary tree of nested parallel_for calls; every level splits in two chunks, the
+    // second of which waits in the caller's deque for a thief
+    //
+    if (depth == 0) {
+        leaves++;
+        return 1;
+    }
+    std::atomic<uint64_t> sum(0);
+    pool.parallel_for(0, 2, 1, [&](uint64_t, uint64_t) {
+        sum += fork_join(pool, depth - 1, leaves);
+    });
+    return sum;
+}
+
+static void test_pool(void) {
+    for (unsigned threads : { 1u, 3u }) {
+        epl::ThreadPool pool(threads);
+        std::atomic<uint64_t> leaves(0);
+        CHECK(fork_join(pool, 12, leaves) == 4096 && leaves == 4096);
+
+        //
+        // A throw deep down the tree makes it to the top, and the pool carries on
+        //
+        std::atomic<int> calls(0);
+        CHECK_THROWS(pool.parallel_for(0, 8, 1, [&](uint64_t lo, uint64_t) {
+            pool.parallel_for(0, 64, 1, [&, lo](uint64_t inner, uint64_t) {
+                calls++;
+                if (lo == 5 && inner == 40) {
+                    throw std::runtime_error("leaf");
+                }
+            });
+        }), std::runtime_error);
+        CHECK(calls > 0 && calls <= 8 * 64);
+        leaves = 0;
+        CHECK(fork_join(pool, 6, leaves) == 64);
+
+        //
+        // Tasks submitted from a task go to that worker's own deque
+        //
+        std::atomic<int> done(0);
+        pool.submit([&pool, &done] {
+            for (int k = 0; k < 1000; k++) {
+                pool.submit([&done] { done++; });
+            }
+        });
+        while (done.load() != 1000) {
+            if (!pool.run_one()) {
+                std::this_thread::yield();
+            }
+        }
+        CHECK(done == 1000);
+
+        //
+        // A submitted task that throws neither takes down the worker nor unwinds the
+        // caller that happens to run it; the first exception is kept for take_error()
+        //
+        CHECK(!pool.take_error());
+        std::atomic<int> ran(0);
+        for (int k = 0; k < 100; k++) {
+            pool.submit([&ran, k] {
+                ran++;
+                if (k % 10 == 3) {
+                    throw std::runtime_error("task");
+                }
+            });
+        }
+        while (ran.load() != 100) {
+            if (!pool.run_one()) {
+                std::this_thread::yield();
+            }
+        }
+        std::exception_ptr error = pool.take_error();
+        CHECK(error && !pool.take_error());
+        CHECK_THROWS(std::rethrow_exception(error), std::runtime_error);
+        leaves = 0;
+        CHECK(fork_join(pool, 6, leaves) == 64);
+    }
+
+    //
+    // Without workers the task runs in submit(), which does not throw either
+    //
+    epl::ThreadPool inline_pool(0);
+    inline_pool.submit([] { throw std::logic_error("inline"); });
+    CHECK_THROWS(std::rethrow_exception(inline_pool.take_error()), std::logic_error);
+}
+
+int main() {
+    test_single_thread();
+    test_allocator();
+    test_thieves();
+    test_pool();
+    return check::result();
+}